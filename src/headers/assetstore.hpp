@@ -0,0 +1,75 @@
+/***************************************************************************
+//
+//    softProjector - an open source media projection software
+//    Copyright (C) 2017  Vladislav Kobzar
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation version 3 of the License.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+***************************************************************************/
+
+#ifndef ASSETSTORE_HPP
+#define ASSETSTORE_HPP
+
+#include <QCache>
+#include <QHash>
+#include <QPixmap>
+#include <QVariant>
+#include <QtSql>
+
+class AssetStore
+{
+    // Images used by songs, themes and slides are stored once in the Assets table,
+    // keyed by the SHA-1 of their encoded data. Image columns hold the asset id,
+    // rows written by older versions or by imports may still hold the data itself
+    // until convertBlobs() runs. References are counted by triggers, an asset is
+    // removed when nothing refers to it any more.
+    // Optionally, large images are kept as files named by their hash in a media
+    // directory next to the database, with a NULL data column. decodeMediaFile()
+    // decodes them straight from the memory mapped file.
+    // Decoded pixmaps are shared by asset id. Use from the GUI thread only,
+    // except for the static functions. decodeAssets() lets a worker thread
+    // decode images ahead, addDecoded() then makes them pixmaps.
+public:
+    static AssetStore *instance();
+    static void createTables(QSqlQuery &sq);
+    void convertBlobs();
+
+    QVariant store(const QByteArray &data);
+    QVariant store(const QPixmap &pix);
+    QByteArray data(const QVariant &value);
+    bool loadPixmap(QPixmap &pix, const QVariant &value);
+    QPixmap loadFile(const QString &fileName);
+    void setMediaFiles(bool use);
+
+    static QString mediaPath(const QString &dbPath, const QString &hash);
+    static QByteArray readMediaFile(const QString &path);
+    static QImage decodeMediaFile(const QString &path, QSize bound = QSize());
+    static QHash<qint64,QImage> decodeAssets(QSqlDatabase db, const QList<QVariant> &values);
+    void addDecoded(const QHash<qint64,QImage> &images);
+    bool isDecoded(const QVariant &value);
+
+private:
+    AssetStore();
+    static bool isAssetId(const QVariant &value);
+    bool exists(qint64 id);
+    bool writeMediaFile(const QString &path, const QByteArray &data);
+    void removeUnusedMediaFiles();
+
+    bool m_mediaFiles;
+
+    QCache<qint64,QPixmap> m_pixmaps; // cost is in KB
+    QHash<qint64,qint64> m_idByCacheKey;
+    QCache<qint64,QByteArray> m_fileData; // file bytes by pixmap cache key, cost is in KB
+};
+
+#endif // ASSETSTORE_HPP
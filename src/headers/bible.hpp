@@ -99,9 +99,11 @@ public slots:
     void getVerseAndCaption(QString &verse, QString &caption, QString verId, QString &bibId, bool useAbbr);
     int getCurrentBookRow(QString book);
     Verse getCurrentVerseAndCaption(QList<int> currentRows, BibleSettings& sets, BibleVersionSettings& bv);
+    Verse getVerses(QString verse_id, BibleSettings& sets, BibleVersionSettings& bv);
     void setBiblesId(QString& id);
     QString getBibleName();
     void loadOperatorBible();
+    static void preload(const QString &id);
 private:
     QString bibleId;
     QList<BibleVerse> operatorBible;
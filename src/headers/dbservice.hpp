@@ -0,0 +1,79 @@
+/***************************************************************************
+//
+//    softProjector - an open source media projection software
+//    Copyright (C) 2017  Vladislav Kobzar
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation version 3 of the License.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+***************************************************************************/
+
+#ifndef DBSERVICE_HPP
+#define DBSERVICE_HPP
+
+#include <QHash>
+#include <QList>
+#include <QThreadPool>
+#include <QThreadStorage>
+#include <QVariant>
+#include <QtConcurrent>
+#include <QtSql>
+
+class DbConnection
+{
+    // A connection to the main database and the statements prepared on it,
+    // owned by the thread that uses it
+public:
+    DbConnection(const QString &name, bool owned);
+    ~DbConnection();
+    QString name;
+    bool owned; // the GUI thread uses the default connection, which it does not own
+    QHash<QString,QSqlQuery> statements;
+};
+
+class DbService
+{
+    // Gives every thread its own connection to the main database: the GUI thread
+    // uses the default connection, other threads get a named connection on first
+    // use that is removed when the thread ends. Statements prepared through
+    // prepare() are kept per connection and reused.
+    // Database work that does not have to be on the GUI thread is queued with
+    // run(), select() or exec() on a small pool whose threads keep their
+    // connections, and its result is delivered through a QFuture.
+    // init() sets the database file before any other thread uses the service.
+public:
+    static DbService *instance();
+    static void init(const QString &dbPath);
+    static void tune(QSqlDatabase db);
+    QSqlDatabase database();
+    QSqlQuery prepare(const QString &sql);
+
+    template <typename Function, typename... Args>
+    auto run(Function function, Args... args)
+    {
+        return QtConcurrent::run(&m_pool,function,args...);
+    }
+    QFuture<QList<QSqlRecord> > select(const QString &sql, const QVariantList &values = QVariantList());
+    QFuture<bool> exec(const QString &sql, const QVariantList &values = QVariantList());
+    void waitForDone();
+
+private:
+    DbService();
+    DbConnection *connection();
+
+    QString m_dbPath;
+    QAtomicInt m_lastId;
+    QThreadStorage<DbConnection*> m_connections;
+    QThreadPool m_pool;
+};
+
+#endif // DBSERVICE_HPP
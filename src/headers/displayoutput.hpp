@@ -0,0 +1,63 @@
+/***************************************************************************
+//
+//    softProjector - an open source media projection software
+//    Copyright (C) 2017  Vladislav Kobzar
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation version 3 of the License.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+***************************************************************************/
+
+#ifndef DISPLAYOUTPUT_HPP
+#define DISPLAYOUTPUT_HPP
+
+#include "projectordisplayscreen.hpp"
+#include "theme.hpp"
+
+enum PresentationType
+{
+    BIBLE,
+    SONG,
+    ANNOUCEMENT,
+    PICTURE,
+    VIDEO
+};
+
+class DisplayOutput
+{
+    // One display window and what it shows: the screen or DeckLink device it is on,
+    // the theme display settings it uses and which content it takes. All outputs
+    // render text through the same RenderCache, so outputs with equal settings and
+    // size share their text images.
+    // The primary display screen (number 1) carries the display controls and the
+    // video sound, it always shows all content.
+public:
+    DisplayOutput(int number, RenderCache *cache);
+    ~DisplayOutput();
+    void setSettings(const OutputSettings &sets);
+    int number(){return m_number;}
+    int screen(){return m_settings.screen;}
+    int themeDisplay();
+    int content();
+    bool shows(PresentationType type);
+    void applyContent(TextSettingsBase &sets);
+    void showPassive(Theme &theme);
+
+    ProjectorDisplayScreen *display;
+    bool isConnected; // placed on a screen and shown with the primary display screen
+
+private:
+    int m_number;
+    OutputSettings m_settings;
+};
+
+#endif // DISPLAYOUTPUT_HPP
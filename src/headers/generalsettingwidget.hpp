@@ -48,9 +48,21 @@ private:
     DeckLinkDiscovery *deckLinkDiscovery;
     QList<DeckLinkDeviceInfo> deckLinkDevices;
 
+    // Display output rows, built from mySettings.outputs
+    QList<QLabel*> outputLabels;
+    QList<QComboBox*> screenCombos;
+    QList<QComboBox*> themeDisplayCombos;
+    QList<QComboBox*> contentCombos;
+    QString outputLabel(int row);
+    void retranslateOutputRows();
+    void addOutputRow(const OutputSettings &o);
+    void removeOutputRow();
+    void updateOutputButtons();
+    int outputScreen(int row);
+
 public slots:
     void setSettings(GeneralSettings settings);
-    void updateSecondaryDisplayScreen();
+    void updateOutputScreens();
     GeneralSettings getSettings();
 
 signals:
@@ -63,10 +75,9 @@ private slots:
     void on_pushButtonDefault_clicked();
     void loadThemes();
     void loadSettings();
-    void on_comboBoxDisplayScreen_activated(const QString &arg1);
-    void on_comboBoxDisplayScreen_2_activated(int index);
-    void on_comboBoxDisplayScreen_3_activated(int index);
-    void on_comboBoxDisplayScreen_4_activated(int index);
+    void updateThemeDisplayUse();
+    void on_pushButtonAddOutput_clicked();
+    void on_pushButtonRemoveOutput_clicked();
     void on_pushButtonAddTheme_clicked();
     void on_comboBoxTheme_activated(int index);
     void on_checkBoxUseDarkTheme_clicked();
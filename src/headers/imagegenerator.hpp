@@ -21,15 +21,42 @@
 #define IMAGEGENERATOR_HPP
 
 #include <QPixmap>
+#include <QImage>
 #include <QPainter>
-#include <QGraphicsBlurEffect>
-#include <QGraphicsScene>
-#include <QGraphicsPixmapItem>
 #include "settings.hpp"
 #include "displaysetting.hpp"
 #include "bible.hpp"
 #include "song.hpp"
 #include "announcement.hpp"
+#include "textlayout.hpp"
+
+class TextRun
+{
+    // One text or fill drawing call of a text layer, in screen coordinates
+public:
+    TextRun();
+    QString text;
+    QFont font;
+    QColor color;
+    QRect rect;
+    int flags;
+    Qt::LayoutDirection direction; // of the painter that drew the run
+    bool isFill;
+};
+
+class TextFrame
+{
+    // A rendered text layer. Normally this is a full screen image. When the text is
+    // drawn by the scene graph (isNative), it holds the text runs instead.
+public:
+    TextFrame();
+    QImage image;
+    QSize size;
+    QList<TextRun> runs;
+    QList<TextRun> shadowRuns;
+    int shadowOffset;
+    bool isNative;
+};
 
 class ImageGenerator
 {
@@ -40,16 +67,21 @@ public:
 
     QPixmap generateEmptyImage();
     QPixmap generateColorImage(QColor &color);
-    QPixmap generateBibleImage(Verse verse, BibleSettings &bSets);
-    QPixmap generateSongImage(Stanza stanza, SongSettings &sSets);
-    QPixmap generateAnnounceImage(AnnounceSlide announce, TextSettings &aSets);
+    // Text images are rendered into QImage so that they can be generated on worker threads
+    QImage generateBibleImage(const Verse &verse, const BibleSettings &bSets);
+    QImage generateSongImage(const Stanza &stanza, const SongSettings &sSets);
+    QImage generateAnnounceImage(const AnnounceSlide &announce, const TextSettings &aSets);
+
+    // When only recording, text is laid out and its runs are kept, but no image is produced
+    void setRecordOnly(bool recordOnly);
+    TextFrame textFrame();
 
     int width();
     int height();
 
 private:
     QSize m_screenSize;
-    bool m_shadow, m_blurShadow, m_isTextPrepared, m_bibleAddBKColorToText, m_songAddBKColorToText, m_announcementAddBKColorToText;
+    bool m_shadow, m_blurShadow, m_isTextPrepared, m_recordOnly, m_bibleAddBKColorToText, m_songAddBKColorToText, m_announcementAddBKColorToText;
     int m_type; // 0 = empty, 1 = bible, 2 = song, 3 = announce
     int m_shadowOffset, m_blurRadius;
     QColor m_bibleTextRecBKColor, m_bibleTextGenBKColor, m_songTextRecBKColor, m_songTextGenBKColor, m_announcementTextRecBKColor, m_announcementTextGenBKColor;
@@ -66,16 +98,28 @@ private:
     TextSettings m_aSets;
     AnnounceDisplaySettings m_adSets;
 
+    TextFrame m_frame;
+    QPainter *m_textPainter, *m_shadowPainter;
+
+    // Shaped text, shared by measuring and drawing
+    TextLayoutCache m_layouts;
+
+    // Memoized solid frames
+    QPixmap m_emptyPix, m_colorPix;
+    QColor m_pixColor;
 
-    QPixmap renderText();
+    QImage renderText();
 
+    QRect textBoundingRect(QPainter *painter, const QRect &rect, int flags, const QString &text);
+    void drawTextRun(QPainter *painter, const QRect &rect, int flags, const QString &text, QRect *br = 0);
+    void fillRun(QPainter *painter, const QRect &rect, const QColor &color);
+    void recordRun(QPainter *painter, const TextRun &run);
     QRect boundRectOrDrawText(QPainter *painter, bool draw, int left, int top, int width, int height, int flags, QString text);
     void drawBibleText(QPainter *painter, bool isShadow);
     void drawBibleTextToRect(QPainter *painter, QRect& trect, QRect& crect, QString ttext, QString ctext, int tflags, int cflags, int top, int left, int width, int height);
     void drawSongText(QPainter *painter, bool isShadow);
     void drawAnnounceText(QPainter *painter, bool isShadow);
-//    void fastbluralpha(QImage &img, int radius);
-    QPixmap applyEffectToImage(QPixmap src, QGraphicsEffect *effect);
+    void fastbluralpha(QImage &img, int radius);
 
 };
 
@@ -87,9 +87,12 @@ private:
     QList<Module> moduleList;
     ModuleProgressDialog *progressDia;
     QElapsedTimer downTime;
+    QFutureWatcher<QString> *maintainWatcher;
     Ui::ManageDataDialog *ui;
 
 private slots:
+    void on_maintain_pushButton_clicked();
+    void maintainFinished();
     QString get3(int i);
     QString getVerseId(QString book, QString chapter, QString verse);
     void setWaitCursor();
@@ -0,0 +1,122 @@
+/***************************************************************************
+//
+//    softProjector - an open source media projection software
+//    Copyright (C) 2017  Vladislav Kobzar
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation version 3 of the License.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+***************************************************************************/
+
+#ifndef MEDIACATALOG_HPP
+#define MEDIACATALOG_HPP
+
+#include <QFuture>
+#include <QHash>
+#include <QImage>
+#include <QMediaPlayer>
+#include <QStringList>
+#include <QThread>
+#include <QTimer>
+#include <QVideoFrame>
+#include <QVideoSink>
+#include <QtSql>
+
+class MediaInfo
+{
+    // What is known about a media library file without loading it into the player
+public:
+    MediaInfo();
+    QString describe() const;
+
+    QString path;     // as stored in the Media table
+    qint64 modified;  // file modification time, in ms since epoch. 0 when not known
+    qint64 duration;  // ms
+    QSize resolution;
+    qreal frameRate;
+    QString videoCodec;
+    QString audioCodec;
+    int audioBitRate;
+    bool hasVideo;
+    bool hasAudio;
+    bool isValid;     // false when the file could not be read
+    QImage poster;    // a frame from the start of a video, or the cover art
+};
+Q_DECLARE_METATYPE(MediaInfo)
+
+class MediaProber : public QObject
+{
+    // Lives on the catalog thread and reads one file at a time with its own
+    // player. The player is muted and has no video output but a sink, which
+    // supplies the poster frame.
+    Q_OBJECT
+public:
+    MediaProber();
+
+public slots:
+    void probe(const QString &path, qint64 modified);
+
+signals:
+    void probed(const MediaInfo &info);
+
+private slots:
+    void statusChanged(QMediaPlayer::MediaStatus status);
+    void frameChanged(const QVideoFrame &frame);
+    void timedOut();
+    void finish();
+
+private:
+    void next();
+
+    QMediaPlayer *m_player;
+    QVideoSink *m_sink;
+    QTimer *m_timeout;
+    QList<QPair<QString,qint64> > m_queue;
+    MediaInfo m_info;
+    bool m_busy;
+    bool m_seeking;
+};
+
+class MediaCatalog : public QObject
+{
+    // Keeps duration, resolution, stream information and a poster frame of every
+    // media library file in the MediaCatalog table. Files are probed in the
+    // background when they are added, and again when their modification time
+    // changed. The catalog is kept in memory on the GUI thread, reading it at
+    // startup and writing probe results are done on database threads.
+    Q_OBJECT
+public:
+    static MediaCatalog *instance();
+    static void createTables(QSqlQuery &sq);
+    void preload();
+    void load();
+    MediaInfo info(const QString &path) const;
+    void probe(const QStringList &paths);
+    void remove(const QString &path);
+
+signals:
+    void infoChanged(const QString &path);
+
+private slots:
+    void save(const MediaInfo &info);
+    void stop();
+
+private:
+    MediaCatalog();
+
+    QThread m_thread;
+    MediaProber *m_prober;
+    QHash<QString,MediaInfo> m_infos;
+    QFuture<QHash<QString,MediaInfo> > m_preloaded;
+};
+
+#endif // MEDIACATALOG_HPP
@@ -31,6 +31,7 @@
 #include "mediacontrol.hpp"
 #include "videoplayerwidget.hpp"
 #include "videoinfo.hpp"
+#include "mediacatalog.hpp"
 
 namespace Ui {
 class MediaWidget;
@@ -66,6 +67,7 @@ private slots:
 
     void handleDrop(QDropEvent *e);
     void loadMediaLibrary();
+    void updateCatalogInfo(const QString &path);
     void statusChanged(QMediaPlayer::MediaStatus status);
     void displayErrorMessage();
 
@@ -80,6 +82,9 @@ private slots:
 
 private:
     Ui::MediaWidget *ui;
+    void addLibraryItem(const QString &path, const QString &name);
+    void updateLibraryItem(QListWidgetItem *itm);
+    QString catalogInfo();
 
     QIcon playIcon;
     QIcon pauseIcon;
@@ -26,8 +26,14 @@
 #include <QQuickItem>
 #include <QtQml>
 #include <QMediaPlayer>
+#include <QCache>
+#include <QHash>
+#include <QSet>
+#include <QFutureWatcher>
 #include "spimageprovider.hpp"
+#include "sptextlayer.hpp"
 #include "imagegenerator.hpp"
+#include "rendercache.hpp"
 #include "settings.hpp"
 #include "bible.hpp"
 #include "song.hpp"
@@ -46,9 +52,22 @@ class ProjectorDisplayScreen : public QWidget
 public:
     explicit ProjectorDisplayScreen(QWidget *parent = 0);
     ~ProjectorDisplayScreen();
+    QSize screenSize();
+
+    // Staging lets several screens prepare a slide first and then switch together.
+    // stagedReady() is emitted when the staged images finish loading after stageText().
+    void stageText(TextSettingsBase &sets, const TextFrame &text);
+    bool isStagedReady();
+    void showStaged();
+    void prescaleBackground(QPixmap p, int fillMode);
+    void prescaleSlide(QPixmap slide, SlideShowSettings &ssSets);
+    int backgroundCacheCost();
+    int droppedPrescaled();
+    void clearPrescaled();
 
 public slots:
     void resetImGenSize();
+    void setRenderCache(RenderCache *cache);
 
     void renderNotText();
     void renderPassiveText(QPixmap &back,bool useBack);
@@ -71,10 +90,13 @@ public slots:
 private slots:
     void setBackPixmap(QPixmap p,int fillMode); // 0 = Strech, 1 = keep aspect, 2 = keep aspect by expanding
     void setBackPixmap(QPixmap p, QColor c);
-    void setTextPixmap(QPixmap p);
+    void setTextImage(QImage image, TextFrame layer = TextFrame());
     void setBackVideo(QString path);
     void setVideoSource(QObject *playerObject, QUrl path);
     void updateScreen();
+    void startTransitions();
+    void imageStatusChanged();
+    void prescaleFinished();
 
     void exitSlideClicked();
     void nextSlideClicked();
@@ -86,6 +108,7 @@ private slots:
     void playbackStopped();
 
 signals:
+    void stagedReady();
     void exitSlide();
     void nextSlide();
     void prevSlide();
@@ -99,17 +122,29 @@ protected:
     void keyReleaseEvent(QKeyEvent *event);
 
 private:
+    TextFrame renderTextFrame(const RenderJob &job);
+    void setImageSource(QObject *item, QString &slotId, const QImage &image);
+    bool isStagedImageLoading();
+    QString scaledBackgroundKey(const QPixmap &p, int fillMode);
+    QImage scaledBackground(QPixmap p, int fillMode);
+    int slideFillMode(const QPixmap &slide, SlideShowSettings &ssSets);
+
     Ui::ProjectorDisplayScreen *ui;
     QQuickView *dispView;
     SpImageProvider *imProvider;
     ImageGenerator imGen;
-    bool backImSwitch1, textImSwitch1, backImSwitch2, textImSwitch2;
-    bool isNewBack, back1to2, text1to2;
+    RenderCache *renderCache; // shared between all display screens, not owned
+    QString backId1, backId2, textId1, textId2; // provider frames shown by the image items
+    bool isNewBack, back1to2, text1to2, transitionPending, isStaged;
+    qint64 transitionRequested; // profiler time of the last updateScreen() or stageText()
     int tranType,backType;
     QColor m_color;
    // DisplayControlsSettings mySettings;
 
     QPixmap back;
+    QCache<QString,QImage> scaledBacks; // cost is in KB
+    QSet<QString> prescaledKeys; // prescaled since clearPrescaled(), to find evicted ones
+    QHash<QString,QFutureWatcher<QImage>*> pendingBacks;
 };
 
 #endif // PROJECTORDISPLAYSCREEN_HPP
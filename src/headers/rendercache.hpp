@@ -0,0 +1,84 @@
+/***************************************************************************
+//
+//    softProjector - an open source media projection software
+//    Copyright (C) 2017  Vladislav Kobzar
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation version 3 of the License.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+***************************************************************************/
+
+#ifndef RENDERCACHE_HPP
+#define RENDERCACHE_HPP
+
+#include <QCache>
+#include <QHash>
+#include <QByteArray>
+#include <QImage>
+#include <QList>
+#include <QMutex>
+#include <QThreadPool>
+#include "imagegenerator.hpp"
+
+QByteArray renderKey(const Verse &verse, const BibleSettings &bSets, QSize size);
+QByteArray renderKey(const Stanza &stanza, const SongSettings &sSets, QSize size);
+QByteArray renderKey(const AnnounceSlide &announce, const TextSettings &aSets, QSize size);
+
+class RenderJob
+{
+    // Everything needed to render one text layer. Background pixmaps are dropped
+    // from the copied settings, they do not take part in text rendering and
+    // should not travel to worker threads.
+public:
+    RenderJob();
+    RenderJob(const Verse &v, const BibleSettings &sets, QSize screenSize);
+    RenderJob(const Stanza &s, const SongSettings &sets, QSize screenSize);
+    RenderJob(const AnnounceSlide &a, const TextSettings &sets, QSize screenSize);
+    QByteArray key() const;
+    TextFrame render() const;
+
+    int type; // 1 = bible, 2 = song, 3 = announce
+    QSize size;
+    bool nativeText; // produce text runs for the scene graph text layer instead of an image
+    Verse verse;
+    BibleSettings bSets;
+    Stanza stanza;
+    SongSettings sSets;
+    AnnounceSlide announce;
+    TextSettings aSets;
+};
+
+class RenderCache
+{
+    // Holds rendered text layers keyed by (content, effective settings, screen size).
+    // Display screens that show the same content with the same settings at the same
+    // resolution get the same image back, so it is rendered only once.
+    // Jobs that differ are rendered concurrently, each with its own ImageGenerator.
+    // Layers rendered by prepare() are kept outside the bounded cache until
+    // releasePrepared(), so a prepared service is not evicted while it is shown.
+public:
+    RenderCache();
+    TextFrame render(const RenderJob &job);
+    QList<TextFrame> render(const QList<RenderJob> &jobs);
+    void prepare(const QList<RenderJob> &jobs);
+    void releasePrepared();
+    void clear();
+    int cost();
+
+private:
+    QMutex m_mutex;
+    QCache<QByteArray,TextFrame> m_cache; // cost is in KB
+    QHash<QByteArray,TextFrame> m_prepared;
+    QThreadPool m_pool;
+};
+
+#endif // RENDERCACHE_HPP
@@ -0,0 +1,77 @@
+/***************************************************************************
+//
+//    softProjector - an open source media projection software
+//    Copyright (C) 2017  Vladislav Kobzar
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation version 3 of the License.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+***************************************************************************/
+
+#ifndef RENDERPROFILER_HPP
+#define RENDERPROFILER_HPP
+
+#include <QAtomicInteger>
+#include <QElapsedTimer>
+#include <QString>
+#include <QList>
+
+class RenderProfiler
+{
+    // Collects timings of the render path stages. Every stage has a ring buffer of
+    // the latest samples, written without locks so that spans can be recorded from
+    // render threads as well. A sample read while it is being written may be off,
+    // which is fine for diagnostics.
+public:
+    enum Stage
+    {
+        ScreenUpdate,    // SoftProjector::updateScreen, whole slide change
+        Database,        // reading content to show
+        TextRender,      // ImageGenerator::renderText, font fitting and drawing
+        ShadowBlur,      // blurring text shadow
+        BackgroundScale, // ProjectorDisplayScreen::setBackPixmap
+        ImageUpload,     // handing frames over to the image provider
+        Transition,      // from display update request until transitions start
+        StageCount
+    };
+
+    static RenderProfiler *instance();
+    static qint64 now(); // monotonic, in nanoseconds
+    static QString stageName(int stage);
+
+    void record(int stage, qint64 start, qint64 duration);
+    QList<qint64> durations(int stage);
+    QString summary();
+    bool saveCsv(const QString &path);
+    void clear();
+
+private:
+    RenderProfiler();
+    static const int RingSize = 512;
+    QAtomicInteger<quint32> m_head[StageCount];
+    QAtomicInteger<qint64> m_start[StageCount][RingSize];
+    QAtomicInteger<qint64> m_duration[StageCount][RingSize];
+};
+
+class RenderSpan
+{
+    // Records the time between its construction and destruction to the profiler
+public:
+    RenderSpan(int stage);
+    ~RenderSpan();
+
+private:
+    int m_stage;
+    qint64 m_start;
+};
+
+#endif // RENDERPROFILER_HPP
@@ -20,6 +20,8 @@
 #ifndef SCHEDULE_HPP
 #define SCHEDULE_HPP
 
+#include <QtSql>
+#include <QThreadPool>
 #include "bible.hpp"
 #include "song.hpp"
 #include "slideshow.hpp"
@@ -39,7 +41,9 @@ public:
     QString stype;
     QString name;
     QIcon icon;
-    int scid;
+    int scid;     // id in the schedule file, -1 when not saved yet
+    int sorder;   // position last saved to the file
+    bool isLoaded; // song background and slide images are present
 
     BibleHistory bible;
     Song song;
@@ -48,4 +52,64 @@ public:
     Announcement announce;
 };
 
+class ScheduleFile
+{
+    // Writes a schedule to an .spsc file in one transaction with statements that
+    // are prepared once per save. Items are never changed once added, so only new
+    // items are written, other items only get their position updated when it changed.
+public:
+    ScheduleFile(const QString &path);
+    ~ScheduleFile();
+    bool isOpen() const;
+    bool save(QList<Schedule> &schedule, bool all);
+
+private:
+    void createTables();
+    void writeItem(const Schedule &sc);
+    void writeSlides(int scid, const QList<SlideShowItem> &slides);
+    void deleteItem(int scid, const QString &stype);
+
+    QString m_connection;
+    QSqlDatabase m_db;
+    QSqlQuery m_insSchedule;
+    QSqlQuery m_updSchedule;
+    QSqlQuery m_insBible;
+    QSqlQuery m_insSong;
+    QSqlQuery m_insSlideShow;
+    QSqlQuery m_insSlide;
+    QSqlQuery m_insMedia;
+    QSqlQuery m_insAnnounce;
+};
+
+class ScheduleJournal
+{
+    // Append-only record of schedule edits made since the schedule was last written
+    // to its file. Each edit is serialized to a small record that is appended and
+    // synced to the disk on a background thread, images of added items are encoded
+    // there as well. After a crash the schedule is rebuilt by opening the file named
+    // in the journal and replaying the records on it. Records cut short by the crash
+    // are ignored.
+public:
+    enum Op {Start = 0, Add, Move, Remove, Clear};
+    ScheduleJournal();
+    ~ScheduleJournal();
+    void setFileName(const QString &fileName);
+    void start(const QString &schedulePath);
+    void add(const Schedule &sc);
+    void move(int from, int to);
+    void remove(int row);
+    void clear();
+    void discard();
+
+    static bool readStart(const QString &fileName, QString &schedulePath);
+    static int replay(const QString &fileName, QList<Schedule> &schedule);
+
+private:
+    void append(const QByteArray &record, bool truncate = false);
+    static QList<QByteArray> readRecords(const QString &fileName);
+
+    QString m_fileName;
+    QThreadPool m_pool;
+};
+
 #endif // SCHEDULE_HPP
@@ -77,6 +77,13 @@ enum ScreenPosition
     BOTTOM_OF_SCREEN
 };
 
+enum OutputContent
+{
+    OC_ALL,
+    OC_SONGS,
+    OC_LOWER_THIRD
+};
+
 enum SongEndingType
 {
     SE_STAR,
@@ -293,19 +300,29 @@ public:
     qreal opacity;
 };
 
+class OutputSettings
+{   // One display output, what it shows and where
+public:
+    OutputSettings(int scr = -1, int display = 1);
+    bool operator==(const OutputSettings &other) const;
+    int screen; // screen, or DeckLink device after the screens. -1 = none
+    int themeDisplay; // theme display settings the output uses, 1 - 4
+    int content; // OutputContent
+};
+
 class GeneralSettings
 {   // To store General Program Settings
 public:
     GeneralSettings();
     bool displayIsOnTop;
     bool useDarkTheme;
-    int displayScreen; // stores primary display screen location
-    int displayScreen2; // stores secondary display screen location
-    int displayScreen3; // stores Tertiary display screen location
-    int displayScreen4; // stores Quaternary display screen location
+    QList<OutputSettings> outputs; // display outputs, the first one is the primary display screen
     DisplayControlsSettings displayControls;
     int currentThemeId;
     bool displayOnStartUp;
+    bool useNativeText; // draw display text with the scene graph instead of text images
+    bool useMediaFiles; // keep large images as files next to the database instead of in it
+    bool autosaveSchedule; // write schedule changes to its file every few seconds
     bool settingsChangedAll;
     bool settingsChangedMulti;
     bool settingsChangedSingle;
@@ -362,12 +379,18 @@ public:
     bool isSpClosing;
 
 public slots:
+    static void createTables(QSqlQuery &sq);
+    static bool convertTextSettings();
+    static void upgradeSections();
     void loadSettings();
-    void saveSettings();
-    void saveNewSettings();
-
-private slots:
-    QByteArray textToByt(QString text);
+    bool saveSettings();
+    QStringList unsavedSections(){return m_unsaved;}
+
+private:
+    QHash<QString,QByteArray> m_saved; // sections as they are in the database
+    QHash<QString,int> m_versions; // section versions as they are in the database
+    QStringList m_unsaved; // changed sections of a newer version that the last save skipped
+    void readTextSettings(QSqlQuery &sq);
 };
 
 #endif // SETTINGS_HPP
@@ -58,10 +58,7 @@ signals:
 private:
     Ui::SettingsDialog *ui;
 
-    int current_display_screen;
-    int currentDisplayScreen2;
-    int currentDisplayScreen3;
-    int currentDisplayScreen4;
+    QList<OutputSettings> currentOutputs;
     bool is_always_on_top;
 
     GeneralSettings gsettings;
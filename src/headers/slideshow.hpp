@@ -25,8 +25,17 @@
 #include <QPixmap>
 #include <QDebug>
 #include <QProgressDialog>
+#include <QCache>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QSet>
+#include <QThreadPool>
+#include <QListWidgetItem>
+#include <QStyledItemDelegate>
+#include <QAbstractItemView>
 
 #include "spfunctions.hpp"
+#include "settings.hpp"
 
 class SlideShowItem
 {
@@ -36,9 +45,81 @@ public:
     int order;
     QString name;
     QString path;
+    // Slides read from the database keep their images there (isStored) and
+    // SlideImageCache decodes them when needed. New slides hold their images here.
+    // Imported slides keep the full size image only encoded, in imageData.
+    bool isStored;
+    mutable qint64 imageKey; // SlideImageCache key of the decoded imageData, 0 until decoded
     QPixmap image;
     QPixmap imageSmall;
     QPixmap imagePreview;
+    QByteArray imageData, imageSmallData, imagePreviewData;
+
+    QPixmap getImage() const;
+    QPixmap getImageSmall() const;
+    QPixmap getImagePreview() const;
+    QByteArray getImageData() const;
+    QByteArray getImageSmallData() const;
+    QByteArray getImagePreviewData() const;
+    QListWidgetItem *createListItem() const;
+};
+
+class SlideImageCache : public QObject
+{
+    // Decodes images of stored slides on demand. Thumbnails are decoded in the
+    // background once a list paints them, full size images are prefetched
+    // around the current slide. Decoded images are kept in bounded caches.
+    Q_OBJECT
+public:
+    enum Kind {Full = 0, Small, Preview};
+    static SlideImageCache *instance();
+    QPixmap image(int slideId, Kind kind);
+    QPixmap decoded(qint64 &key, const QByteArray &data);
+    QByteArray data(int slideId, Kind kind);
+    QPixmap thumbnail(int slideId);
+    void requestThumbnail(int slideId);
+    void prefetch(const QList<SlideShowItem> &slides, int current);
+
+signals:
+    void thumbnailReady(int slideId);
+
+private:
+    SlideImageCache();
+    QByteArray read(int slideId, Kind kind, QSqlDatabase db, QString *mediaFile = NULL);
+    QImage decode(int slideId, Kind kind, QSqlDatabase db);
+    void load(int slideId, int kind);
+
+    QMutex m_mutex;
+    QWaitCondition m_loaded;
+    QCache<int,QImage> m_fullImages; // cost is in KB, prefetched until they are shown
+    QCache<int,QImage> m_thumbs;
+    QCache<int,QPixmap> m_thumbPix; // used from the GUI thread only
+    QCache<qint64,QPixmap> m_fullPix; // shown slides, GUI thread only. Stored ones by id,
+                                      // others by negative keys of decoded()
+    qint64 m_lastDataKey;
+    QSet<qint64> m_pending; // queued and running loads
+    QSet<qint64> m_loading; // running loads
+    QThreadPool m_pool;
+    QString m_dbPath;
+};
+
+class SlideIconDelegate : public QStyledItemDelegate
+{
+    // Shows the thumbnail of stored slide list items (slide id in Qt::UserRole).
+    // Only painted items request their thumbnail, so only visible ones are decoded.
+    Q_OBJECT
+public:
+    SlideIconDelegate(QAbstractItemView *view);
+    void paint(QPainter *painter, const QStyleOptionViewItem &option, const QModelIndex &index) const;
+
+protected:
+    void initStyleOption(QStyleOptionViewItem *option, const QModelIndex &index) const;
+
+private slots:
+    void thumbnailReady(int slideId);
+
+private:
+    QAbstractItemView *m_view;
 };
 
 class SlideShowInfo
@@ -64,4 +145,8 @@ public slots:
     void saveSideShow(QString savelbl, QWidget *ptW, QList<int> delList);
 };
 
+// Decodes image files at their target sizes in parallel, with a progress dialog
+QList<SlideShowItem> importSlides(const QStringList &files, const SlideShowSettings &sets,
+                                  const QString &label, QWidget *parent);
+
 #endif // SLIDESHOW_HPP
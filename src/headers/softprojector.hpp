@@ -24,7 +24,7 @@
 #include "songwidget.hpp"
 #include "biblewidget.hpp"
 #include "announcewidget.hpp"
-#include "projectordisplayscreen.hpp"
+#include "displayoutput.hpp"
 #include "editwidget.hpp"
 #include "bible.hpp"
 #include "managedatadialog.hpp"
@@ -49,15 +49,6 @@ namespace Ui
 class SoftProjectorClass;
 }
 
-enum PresentationType
-{
-    BIBLE,
-    SONG,
-    ANNOUCEMENT,
-    PICTURE,
-    VIDEO
-};
-
 class SoftProjector : public QMainWindow
 {
     Q_OBJECT
@@ -70,10 +61,7 @@ public:
     AnnounceWidget *announceWidget;
     ManageDataDialog *manageDialog;
     EditWidget *editWidget;
-    ProjectorDisplayScreen *pds1;
-    ProjectorDisplayScreen *pds2;
-    ProjectorDisplayScreen *pds3;
-    ProjectorDisplayScreen *pds4;
+    QList<DisplayOutput*> outputs; // the first one is the primary display screen
     PictureWidget *pictureWidget;
     MediaWidget *mediaPlayer;
     MediaControl *mediaControls;
@@ -100,6 +88,7 @@ public slots:
     void setWaitCursor();
     void setArrowCursor();
     void setAppDataDir(QDir d){appDataDir = d;}
+    void recoverSchedule();
 
 private:
     Ui::SoftProjectorClass *ui;
@@ -114,12 +103,12 @@ private:
     //For saving and opening schedule files
     //QString project_file_path;
     QString schedule_file_path;
+    QString schedule_source_path; // file that not yet loaded schedule items are read from
     bool is_schedule_saved;
     QString cur_locale;
     bool isSingleScreen;
-    bool hasDisplayScreen2;
-    bool hasDisplayScreen3;
-    bool hasDisplayScreen4;
+    ProjectorDisplayScreen *primaryDisplay(){return outputs.first()->display;}
+    QRect screenGeometry(int screen, const QList<QScreen*> &screens);
 
     // shortcuts
     QShortcut *shpgUP;
@@ -138,14 +127,41 @@ private:
 
     // Schelude list
     QList<Schedule> schedule;
+    ScheduleJournal journal; // edits since the schedule was last written, for crash recovery
+    QTimer *autosaveTimer;
     QDir appDataDir;
 
+    // Rendered text images shared by all display outputs
+    RenderCache renderCache;
+    Verse getBibleVerse(QString &verseIds, BibleSettings &sets, BibleVersionSettings &bv, Verse &verse1);
+    void showText(QList<DisplayOutput*> &shown, QList<TextSettingsBase*> &sets, QList<RenderJob> &jobs);
+    QList<DisplayOutput*> stagedOutputs; // staged by showText, switched once all of them are ready
+    void prescaleBackgrounds();
+    void prescaleBackground(DisplayOutput *out, TextSettingsBase sets);
+    void loadShownBackgrounds();
+
+    // Render timing overlay
+    QLabel *timingOverlay;
+    QTimer *timingTimer;
+
+    // Theme backgrounds of connected display outputs, decoded on a database thread
+    QFutureWatcher<QHash<qint64,QImage> > *themeWatcher;
+    QList<int> themeDisplays();
+
+    // Service preparation, one schedule item at a time
+    int prepareRow; // next schedule row to prepare, -1 when not preparing
+    QFutureWatcher<void> *prepareWatcher;
+    QProgressDialog *prepareDialog;
+    QList<RenderJob> prepareJobs(Schedule &sc);
+    void finishPrepare();
+
     // DeckLink device discovery
     DeckLinkDiscovery *deckLinkDiscovery;
     QList<DeckLinkDeviceInfo> deckLinkDevices;
 
 private slots:
     void showDisplayScreen(bool show);
+    void showStagedWhenReady();
 
     void applySetting(GeneralSettings &g, Theme &t, SlideShowSettings &s,
                       BibleVersionSettings &b1, BibleVersionSettings &b2,
@@ -232,27 +248,25 @@ private slots:
     void on_actionCloseSchedule_triggered();
     void openSchedule();
     void saveSchedule(bool overWrite);
-    void saveScheduleNew(QSqlQuery &q);
-    void saveScheduleItemNew(QSqlQuery &q, int scid, const BibleHistory &b);
-    void saveScheduleItemNew(QSqlQuery &q, int scid, const Song &s);
-    void saveScheduleItemNew(QSqlQuery &q, int scid, const SlideShow &s);
-    void saveScheduleItemNew(QSqlQuery &q, int scid, const VideoInfo &v);
-    void saveScheduleItemNew(QSqlQuery &q, int scid, const Announcement &a);
-    void saveScheduleUpdate(QSqlQuery &q);
-    void saveScheduleItemUpdate(QSqlQuery &q, int scid, const BibleHistory &b);
-    void saveScheduleItemUpdate(QSqlQuery &q, int scid, const Song &s);
-    void saveScheduleItemUpdate(QSqlQuery &q, int scid, const SlideShow &s);
-    void saveScheduleItemUpdate(QSqlQuery &q, int scid, const VideoInfo &v);
-    void saveScheduleItemUpdate(QSqlQuery &q, int scid, const Announcement &a);
-    void openScheduleItem(QSqlQuery &q, const int scid, BibleHistory &b);
-    void openScheduleItem(QSqlQuery &q, const int scid, Song &s);
-    void openScheduleItem(QSqlQuery &q, const int scid, SlideShow &s);
-    void openScheduleItem(QSqlQuery &q, const int scid, VideoInfo &v);
-    void openScheduleItem(QSqlQuery &q, const int scid, Announcement &a);
+    bool writeSchedule(bool all);
+    void autosaveSchedule();
+    void startupFinished();
+    void openScheduleItems(QSqlQuery &q, QHash<int,BibleHistory> &items);
+    void openScheduleItems(QSqlQuery &q, QHash<int,Song> &items);
+    void openScheduleItems(QSqlQuery &q, QHash<int,SlideShow> &items);
+    void openScheduleItems(QSqlQuery &q, QHash<int,VideoInfo> &items);
+    void openScheduleItems(QSqlQuery &q, QHash<int,Announcement> &items);
+    void loadScheduleItems(int row);
+    void on_actionPrepareService_triggered();
+    void prepareNextItem();
+    void themeBackgroundsDecoded();
 
     void on_actionClear_triggered();
 
     void on_actionCloseDisplay_triggered();
+    void on_actionRenderTimings_toggled(bool checked);
+    void on_actionSaveRenderTimings_triggered();
+    void updateRenderTimings();
     void updateCloseDisplayButtons(bool isOn);
 
 protected:
@@ -157,6 +157,7 @@ public:
     void deleteSong(int songId);
     QString getSongbookIdStringFromName(QString songbook_name);
     Song getSong(int id);
+    static void preload();
     QList<Song> getSongs();
     int lastUser(QString songbook_id);
 };
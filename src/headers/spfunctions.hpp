@@ -27,7 +27,16 @@
 #include <QBuffer>
 
 
-QByteArray pixToByte(const QPixmap & pmap);
+enum ImageUse
+{
+    ImageFull,     // backgrounds and full size slides
+    ImageThumbnail // slide previews and list icons
+};
+
+QByteArray pixToByte(const QPixmap & pmap, ImageUse use = ImageFull);
+QByteArray imageToByte(const QImage & image, ImageUse use = ImageFull);
+QImage byteToImage(const QByteArray & data, QSize bound = QSize());
+bool isReusableImageFormat(const QByteArray & format);
 bool isAnnounceTitle(QString string);
 QString getSupportedImageFormats();
 //class spFunctions
@@ -21,18 +21,48 @@
 #define SPIMAGEPROVIDER_HPP
 
 #include <QQuickImageProvider>
+#include <QQuickImageResponse>
+#include <QImage>
+#include <QHash>
+#include <QMutex>
 
-class SpImageProvider : public QQuickImageProvider
+class SpImageResponse : public QQuickImageResponse
 {
+    // Hands a stored frame over to the scene graph. The texture factory shares
+    // the image data, so the frame is not copied on its way to the GPU.
+public:
+    SpImageResponse(const QImage &image);
+    QQuickTextureFactory *textureFactory() const;
+
+private:
+    QImage m_image;
+};
 
+class SpImageProvider : public QQuickAsyncImageProvider
+{
+    // Holds frames by id. Every id is reference counted: addImage() returns an id
+    // with one reference, release() drops it and the frame is freed at zero.
+    // Frames can be added from any thread.
 public:
     SpImageProvider();
-    QPixmap requestPixmap(const QString &id, QSize *size, const QSize &requestedSize);
+    QQuickImageResponse *requestImageResponse(const QString &id, const QSize &requestedSize);
 
-    void setPixMap(QPixmap &p);
+    QString addImage(const QImage &image);
+    void retain(const QString &id);
+    void release(const QString &id);
 
 private:
-    QPixmap m_pixmap;
+    class Frame
+    {
+    public:
+        QImage image;
+        int refCount;
+    };
+
+    QMutex m_mutex;
+    QHash<QString,Frame> m_frames;
+    QHash<qint64,QString> m_idByCacheKey;
+    quint64 m_nextId;
 };
 
 
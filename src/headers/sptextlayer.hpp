@@ -0,0 +1,45 @@
+/***************************************************************************
+//
+//    softProjector - an open source media projection software
+//    Copyright (C) 2017  Vladislav Kobzar
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation version 3 of the License.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+***************************************************************************/
+
+#ifndef SPTEXTLAYER_HPP
+#define SPTEXTLAYER_HPP
+
+#include <QQuickItem>
+#include "imagegenerator.hpp"
+
+class SpTextLayer : public QQuickItem
+{
+    // Draws the text runs of a TextFrame with scene graph text nodes. Only glyph and
+    // geometry data is uploaded per slide instead of a full screen text image.
+    // Shadows are drawn as a second set of text nodes below the text.
+    // Requires Qt 6.7, with older versions nothing is drawn.
+    Q_OBJECT
+public:
+    SpTextLayer(QQuickItem *parent = 0);
+    void setFrame(const TextFrame &frame);
+    static bool isSupported();
+
+protected:
+    QSGNode *updatePaintNode(QSGNode *oldNode, UpdatePaintNodeData *data);
+
+private:
+    TextFrame m_frame;
+};
+
+#endif // SPTEXTLAYER_HPP
@@ -0,0 +1,69 @@
+/***************************************************************************
+//
+//    softProjector - an open source media projection software
+//    Copyright (C) 2017  Vladislav Kobzar
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation version 3 of the License.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+***************************************************************************/
+
+#ifndef STARTUPPROFILER_HPP
+#define STARTUPPROFILER_HPP
+
+#include <QElapsedTimer>
+#include <QList>
+#include <QMutex>
+#include <QString>
+
+class StartupProfiler
+{
+    // Records how long each phase of startup takes, on whichever thread it runs.
+    // When a log file is set with --startup-log, the phases are written to it
+    // once the main window can be used.
+public:
+    static StartupProfiler *instance();
+    void setLogFile(const QString &path);
+    void record(const QString &phase, qint64 start, qint64 duration);
+    qint64 elapsed(); // since the program started, in microseconds
+    void finish();
+
+private:
+    StartupProfiler();
+
+    struct Phase
+    {
+        QString name;
+        QString thread;
+        qint64 start;
+        qint64 duration;
+    };
+
+    QElapsedTimer m_clock;
+    QMutex m_mutex;
+    QList<Phase> m_phases;
+    QString m_logFile;
+};
+
+class StartupPhase
+{
+    // Records the time between its construction and destruction as a startup phase
+public:
+    StartupPhase(const QString &phase);
+    ~StartupPhase();
+
+private:
+    QString m_phase;
+    qint64 m_start;
+};
+
+#endif // STARTUPPROFILER_HPP
@@ -0,0 +1,70 @@
+/***************************************************************************
+//
+//    softProjector - an open source media projection software
+//    Copyright (C) 2017  Vladislav Kobzar
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation version 3 of the License.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+***************************************************************************/
+
+#ifndef TEXTLAYOUT_HPP
+#define TEXTLAYOUT_HPP
+
+#include <QCache>
+#include <QFont>
+#include <QList>
+#include <QRect>
+#include <QSharedPointer>
+#include <QTextLayout>
+
+class QPainter;
+class QPaintDevice;
+
+class TextBlock
+{
+    // Text that is shaped and broken into lines once for a font, width and set of
+    // QPainter::drawText flags. It measures and draws the same way drawText(rect, flags, text)
+    // does, so measuring passes and the final drawing can share one layout.
+    // direction is the layout direction of the painter that would draw the text.
+public:
+    TextBlock(const QString &text, const QFont &font, int width, int flags, QPaintDevice *device = 0,
+              Qt::LayoutDirection direction = Qt::LayoutDirectionAuto);
+    QRect boundingRect(const QRect &rect) const;
+    void draw(QPainter *painter, const QRect &rect) const;
+    QPointF origin(const QRect &rect) const;
+    QTextLayout *layout();
+
+private:
+    QTextLayout m_layout;
+    int m_flags;
+    qreal m_width, m_height;
+    QList<qreal> m_lineBottoms;
+};
+
+class TextLayoutCache
+{
+    // Keeps recently used TextBlocks, so text is shaped once per slide and not
+    // again for every measurement, the drawing and the shadow.
+public:
+    TextLayoutCache();
+    QSharedPointer<TextBlock> block(const QString &text, const QFont &font, int width, int flags,
+                                    QPaintDevice *device = 0, Qt::LayoutDirection direction = Qt::LayoutDirectionAuto);
+    void clear();
+
+private:
+    // Least recently used blocks are dropped first, font fitting creates many
+    // blocks that are never used again
+    QCache<QString,QSharedPointer<TextBlock> > m_blocks;
+};
+
+#endif // TEXTLAYOUT_HPP
@@ -147,13 +147,29 @@ public slots:
     void saveThemeNew();
     void saveThemeUpdate();
     void loadTheme();
+    void loadBackgrounds();
+    void loadBackgrounds(const QList<int> &screens);
+    QList<QVariant> pendingBackgrounds(const QList<int> &screens);
+    static QHash<qint64,QImage> decodeBackgrounds(QList<QVariant> values);
+    TextSettings &passiveFor(int display);
+    BibleSettings &bibleFor(int display);
+    SongSettings &songFor(int display);
+    TextSettings &announceFor(int display);
     void setThemeId(int id){m_info.themeId = id;}
     int getThemeId(){return m_info.themeId;}
     void setThemeInfo(ThemeInfo info);
     ThemeInfo getThemeInfo();
 
 private:
+     enum ThemePart { PassivePart, BiblePart, SongPart, AnnouncePart };
      ThemeInfo m_info;
+     QHash<int,QVariant> m_backgrounds; // stored backgrounds that are not decoded yet, by part*4 + screen-1
+     static QHash<int,QSqlRecord> themeRows(const QString &table, int themeId);
+     TextSettingsBase &part(int type, int screen);
+     QList<int> usedParts(const QList<int> &screens);
+     void loadParts(const QList<int> &keys);
+     void deferBackground(int type, int screen, TextSettingsBase &settings, const QVariant &value);
+     QVariant storedBackground(int type, int screen, TextSettingsBase &settings);
 
 private slots:
     void savePassiveNew(int screen, TextSettings &settings);
@@ -164,10 +180,10 @@ private slots:
     void saveBibleUpdate(int screen, BibleSettings &settings);
     void saveSongUpdate(int screen, SongSettings &settings);
     void saveAnnounceUpdate(int screen, TextSettings &settings);
-    void loadPassive(int screen, TextSettings &settings);
-    void loadBible(int screen, BibleSettings &settings);
-    void loadSong(int screen, SongSettings &settings);
-    void loadAnnounce(int screen, TextSettings &settings);
+    void loadPassive(int screen, const QSqlRecord &sr, TextSettings &settings);
+    void loadBible(int screen, const QSqlRecord &sr, BibleSettings &settings);
+    void loadSong(int screen, const QSqlRecord &sr, SongSettings &settings);
+    void loadAnnounce(int screen, const QSqlRecord &sr, TextSettings &settings);
 
 };
 
@@ -19,6 +19,7 @@
 
 import QtQuick
 import QtMultimedia
+import SoftProjector
 
 Rectangle {
     id: dispArea
@@ -118,6 +119,13 @@ Rectangle {
 //            axis {x:0; y:0; z:0}
 //            origin {x:textImage1/2; y:textImage1/2}
 //        }
+
+        // Scene graph text, used instead of the text image when native text is enabled
+        TextLayer
+        {
+            objectName: "textLayer1"
+            anchors.fill: parent
+        }
     }
 
     Image
@@ -135,6 +143,13 @@ Rectangle {
 //            axis {x:0; y:0; z:0}
 //            origin {x:textImage2/2; y:textImage2/2}
 //        }
+
+        // Scene graph text, used instead of the text image when native text is enabled
+        TextLayer
+        {
+            objectName: "textLayer2"
+            anchors.fill: parent
+        }
     }
 
     Rectangle
@@ -0,0 +1,77 @@
+##**************************************************************************
+##
+##    softProjector - an open source media projection software
+##    Copyright (C) 2017  Vladislav Kobzar
+##
+##    This program is free software: you can redistribute it and/or modify
+##    it under the terms of the GNU General Public License as published by
+##    the Free Software Foundation version 3 of the License.
+##
+##    This program is distributed in the hope that it will be useful,
+##    but WITHOUT ANY WARRANTY; without even the implied warranty of
+##    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+##    GNU General Public License for more details.
+##
+##    You should have received a copy of the GNU General Public License
+##    along with this program.  If not, see <http:##www.gnu.org/licenses/>.
+##
+##**************************************************************************
+
+# Headless text rendering benchmark. Runs on the offscreen platform,
+# see sources/renderbenchmark.cpp for options.
+
+QT += core \
+    gui \
+    sql \
+    concurrent
+
+TARGET = renderBenchmark
+TEMPLATE = app
+CONFIG += console
+CONFIG -= app_bundle
+
+RES_DIR = $${PWD}/unknownsys_build
+win32: RES_DIR = $${PWD}/win32_build
+unix:  RES_DIR = $${PWD}/unix_build
+macx: RES_DIR = $${PWD}/mac_build
+
+DESTDIR = $${RES_DIR}/bin
+OBJECTS_DIR = $${RES_DIR}/obj_benchmark
+MOC_DIR = $${RES_DIR}/moc_benchmark
+
+SOURCES += sources/renderbenchmark.cpp \
+    sources/imagegenerator.cpp \
+    sources/textlayout.cpp \
+    sources/assetstore.cpp \
+    sources/dbservice.cpp \
+    sources/startupprofiler.cpp \
+    sources/renderprofiler.cpp \
+    sources/settings.cpp \
+    sources/spfunctions.cpp \
+    sources/displaysetting.cpp \
+    sources/theme.cpp \
+    sources/bible.cpp \
+    sources/song.cpp \
+    sources/announcement.cpp
+HEADERS += headers/imagegenerator.hpp \
+    headers/textlayout.hpp \
+    headers/assetstore.hpp \
+    headers/dbservice.hpp \
+    headers/startupprofiler.hpp \
+    headers/renderprofiler.hpp \
+    headers/settings.hpp \
+    headers/spfunctions.hpp \
+    headers/displaysetting.hpp \
+    headers/theme.hpp \
+    headers/bible.hpp \
+    headers/song.hpp \
+    headers/announcement.hpp
+
+# Font of the golden image corpus, so references do not depend on installed fonts
+RESOURCES += renderbenchmark.qrc
+
+# "make check" runs the golden image check, it fails when an image differs,
+# a case got slower or a reference is missing (see goldens/README.md)
+check.commands = $$shell_path($${DESTDIR}/renderBenchmark) --golden $$shell_path($${PWD}/goldens)
+check.depends = first
+QMAKE_EXTRA_TARGETS += check
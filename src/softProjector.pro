@@ -27,7 +27,8 @@ QT += core \
     quick \
     printsupport \
     multimedia \
-    multimediawidgets
+    multimediawidgets \
+    concurrent
 
 TARGET = SoftProjector
 TEMPLATE = app
@@ -87,7 +88,16 @@ SOURCES += sources/main.cpp \
     sources/displaysetting.cpp \
     sources/projectordisplayscreen.cpp \
     sources/imagegenerator.cpp \
+    sources/textlayout.cpp \
+    sources/assetstore.cpp \
+    sources/mediacatalog.cpp \
+    sources/dbservice.cpp \
+    sources/startupprofiler.cpp \
+    sources/rendercache.cpp \
+    sources/displayoutput.cpp \
+    sources/renderprofiler.cpp \
     sources/spimageprovider.cpp \
+    sources/sptextlayer.cpp \
     sources/mediacontrol.cpp \
     sources/decklinkdiscovery.cpp
 HEADERS += headers/softprojector.hpp \
@@ -131,7 +141,16 @@ HEADERS += headers/softprojector.hpp \
     headers/displaysetting.hpp \
     headers/projectordisplayscreen.hpp \
     headers/imagegenerator.hpp \
+    headers/textlayout.hpp \
+    headers/assetstore.hpp \
+    headers/mediacatalog.hpp \
+    headers/dbservice.hpp \
+    headers/startupprofiler.hpp \
+    headers/rendercache.hpp \
+    headers/displayoutput.hpp \
+    headers/renderprofiler.hpp \
     headers/spimageprovider.hpp \
+    headers/sptextlayer.hpp \
     headers/mediacontrol.hpp \
     headers/decklinkdiscovery.hpp
 FORMS += ui/softprojector.ui \
@@ -19,6 +19,7 @@
 
 #include "../headers/announcementsettingwidget.hpp"
 #include "ui_announcementsettingwidget.h"
+#include "../headers/assetstore.hpp"
 
 AnnouncementSettingWidget::AnnouncementSettingWidget(QWidget *parent) :
     QWidget(parent),
@@ -238,7 +239,7 @@ void AnnouncementSettingWidget::on_buttonBackground_clicked()
                                                     ".", tr("Images(%1)").arg(getSupportedImageFormats()));
     if(!filename.isNull())
     {
-        QPixmap p(filename);
+        QPixmap p = AssetStore::instance()->loadFile(filename);
         mySettings.backgroundPix = p;
         QFileInfo fi(filename);
         filename = fi.fileName();
@@ -253,7 +254,7 @@ void AnnouncementSettingWidget::on_buttonBackground2_clicked()
                                                     ".", tr("Images(%1)").arg(getSupportedImageFormats()));
     if(!filename.isNull())
     {
-        QPixmap p(filename);
+        QPixmap p = AssetStore::instance()->loadFile(filename);
         mySettings2.backgroundPix = p;
         QFileInfo fi(filename);
         filename = fi.fileName();
@@ -268,7 +269,7 @@ void AnnouncementSettingWidget::on_buttonBackground3_clicked()
                                                     ".", tr("Images(%1)").arg(getSupportedImageFormats()));
     if(!filename.isNull())
     {
-        QPixmap p(filename);
+        QPixmap p = AssetStore::instance()->loadFile(filename);
         mySettings3.backgroundPix = p;
         QFileInfo fi(filename);
         filename = fi.fileName();
@@ -283,7 +284,7 @@ void AnnouncementSettingWidget::on_buttonBackground4_clicked()
                                                     ".", tr("Images(%1)").arg(getSupportedImageFormats()));
     if(!filename.isNull())
     {
-        QPixmap p(filename);
+        QPixmap p = AssetStore::instance()->loadFile(filename);
         mySettings4.backgroundPix = p;
         QFileInfo fi(filename);
         filename = fi.fileName();
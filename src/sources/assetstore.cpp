@@ -0,0 +1,355 @@
+/***************************************************************************
+//
+//    softProjector - an open source media projection software
+//    Copyright (C) 2017  Vladislav Kobzar
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation version 3 of the License.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+***************************************************************************/
+
+#include <QCryptographicHash>
+#include <QDir>
+#include <QSaveFile>
+#include "../headers/assetstore.hpp"
+#include "../headers/spfunctions.hpp"
+
+// Table and image column pairs that refer to assets
+static const char *assetColumns[][2] = {
+    {"Songs", "background"},
+    {"ThemePassive", "background"},
+    {"ThemeBible", "background"},
+    {"ThemeSong", "background"},
+    {"ThemeAnnounce", "background"},
+    {"Slides", "pix"},
+    {"Slides", "pix_small"},
+    {"Slides", "pix_prev"}
+};
+static const int assetColumnCount = sizeof(assetColumns)/sizeof(assetColumns[0]);
+
+// Assets at least this large go to the media directory when media files are used
+static const int mediaFileSize = 256*1024;
+
+AssetStore *AssetStore::instance()
+{
+    static AssetStore store;
+    return &store;
+}
+
+AssetStore::AssetStore()
+{
+    m_pixmaps.setMaxCost(128*1024);
+    m_fileData.setMaxCost(64*1024);
+    m_mediaFiles = false;
+}
+
+void AssetStore::createTables(QSqlQuery &sq)
+{
+    sq.exec("CREATE TABLE IF NOT EXISTS 'Assets' ('id' INTEGER PRIMARY KEY  AUTOINCREMENT  NOT NULL , "
+            "'hash' TEXT UNIQUE, 'data' BLOB, 'refs' INTEGER DEFAULT 0)");
+    sq.exec("CREATE TRIGGER IF NOT EXISTS asset_free AFTER UPDATE OF refs ON Assets WHEN NEW.refs <= 0 "
+            "BEGIN DELETE FROM Assets WHERE id = NEW.id; END");
+
+    for(int i(0);i<assetColumnCount;++i)
+    {
+        QString t(assetColumns[i][0]);
+        QString c(assetColumns[i][1]);
+        QString name = QString("%1_%2").arg(t.toLower()).arg(c);
+        sq.exec(QString("CREATE TRIGGER IF NOT EXISTS asset_ins_%1 AFTER INSERT ON %2 "
+                        "WHEN typeof(NEW.%3) = 'integer' "
+                        "BEGIN UPDATE Assets SET refs = refs + 1 WHERE id = NEW.%3; END").arg(name,t,c));
+        sq.exec(QString("CREATE TRIGGER IF NOT EXISTS asset_upd_%1 AFTER UPDATE OF %3 ON %2 "
+                        "WHEN OLD.%3 IS NOT NEW.%3 BEGIN "
+                        "UPDATE Assets SET refs = refs + 1 WHERE typeof(NEW.%3) = 'integer' AND id = NEW.%3; "
+                        "UPDATE Assets SET refs = refs - 1 WHERE typeof(OLD.%3) = 'integer' AND id = OLD.%3; "
+                        "END").arg(name,t,c));
+        sq.exec(QString("CREATE TRIGGER IF NOT EXISTS asset_del_%1 AFTER DELETE ON %2 "
+                        "WHEN typeof(OLD.%3) = 'integer' "
+                        "BEGIN UPDATE Assets SET refs = refs - 1 WHERE id = OLD.%3; END").arg(name,t,c));
+    }
+}
+
+void AssetStore::convertBlobs()
+{
+    // Moves image data that is still stored in place into Assets.
+    // typeof() does not read the data, so this is cheap when there is nothing to do.
+    QSqlQuery sq, uq;
+    QSqlDatabase::database().transaction();
+    for(int i(0);i<assetColumnCount;++i)
+    {
+        QString t(assetColumns[i][0]);
+        QString c(assetColumns[i][1]);
+        sq.exec(QString("SELECT rowid, %1 FROM %2 WHERE typeof(%1) = 'blob'").arg(c,t));
+        uq.prepare(QString("UPDATE %1 SET %2 = ? WHERE rowid = ?").arg(t,c));
+        while(sq.next())
+        {
+            uq.addBindValue(store(sq.value(1).toByteArray()));
+            uq.addBindValue(sq.value(0));
+            uq.exec();
+        }
+    }
+    // Assets that were stored but never referenced
+    sq.exec("DELETE FROM Assets WHERE refs <= 0");
+    QSqlDatabase::database().commit();
+
+    removeUnusedMediaFiles();
+}
+
+void AssetStore::setMediaFiles(bool use)
+{
+    // Only affects assets stored from now on, existing ones stay where they are
+    m_mediaFiles = use;
+}
+
+QVariant AssetStore::store(const QByteArray &data)
+{
+    if(data.isEmpty())
+        return QVariant();
+
+    QString hash = QString::fromLatin1(QCryptographicHash::hash(data,QCryptographicHash::Sha1).toHex());
+    QSqlQuery sq;
+    sq.prepare("SELECT id FROM Assets WHERE hash = ?");
+    sq.addBindValue(hash);
+    sq.exec();
+    if(sq.first())
+        return sq.value(0);
+
+    QVariant blob(data);
+    if(m_mediaFiles && data.size() >= mediaFileSize
+            && writeMediaFile(mediaPath(QSqlDatabase::database().databaseName(),hash),data))
+        blob = QVariant(QMetaType::fromType<QByteArray>()); // NULL, data is in the file
+
+    // New assets start without references, the referring row's trigger counts it
+    sq.prepare("INSERT INTO Assets (hash, data, refs) VALUES (?,?,0)");
+    sq.addBindValue(hash);
+    sq.addBindValue(blob);
+    if(!sq.exec())
+        return QVariant(data);
+    return sq.lastInsertId();
+}
+
+QVariant AssetStore::store(const QPixmap &pix)
+{
+    if(pix.isNull())
+        return QVariant();
+
+    // Pixmaps that came from an asset are not encoded again
+    qint64 id = m_idByCacheKey.value(pix.cacheKey(),-1);
+    if(id >= 0 && exists(id))
+        return QVariant(id);
+
+    // Pixmaps loaded with loadFile() are stored as the file was
+    QVariant v;
+    if(QByteArray *bytes = m_fileData.object(pix.cacheKey()))
+        v = store(*bytes);
+    else
+        v = store(pixToByte(pix));
+    if(isAssetId(v))
+        m_idByCacheKey.insert(pix.cacheKey(),v.toLongLong());
+    return v;
+}
+
+QByteArray AssetStore::data(const QVariant &value)
+{
+    if(!isAssetId(value))
+        return value.toByteArray();
+
+    QSqlQuery sq;
+    sq.prepare("SELECT hash, data FROM Assets WHERE id = ?");
+    sq.addBindValue(value);
+    sq.exec();
+    if(!sq.first())
+        return QByteArray();
+    if(sq.value(1).isNull())
+        return readMediaFile(mediaPath(QSqlDatabase::database().databaseName(),sq.value(0).toString()));
+    return sq.value(1).toByteArray();
+}
+
+bool AssetStore::loadPixmap(QPixmap &pix, const QVariant &value)
+{
+    // Like QPixmap::loadFromData, pix is left as it is when nothing could be loaded
+    if(!isAssetId(value))
+        return pix.loadFromData(value.toByteArray());
+
+    qint64 id = value.toLongLong();
+    if(QPixmap *cached = m_pixmaps.object(id))
+    {
+        pix = *cached;
+        return true;
+    }
+
+    QSqlQuery sq;
+    sq.prepare("SELECT hash, data FROM Assets WHERE id = ?");
+    sq.addBindValue(value);
+    sq.exec();
+    if(!sq.first())
+        return false;
+
+    QPixmap p;
+    if(sq.value(1).isNull())
+        p = QPixmap::fromImage(decodeMediaFile(mediaPath(QSqlDatabase::database().databaseName(),
+                                                         sq.value(0).toString())));
+    else
+        p.loadFromData(sq.value(1).toByteArray());
+    if(p.isNull())
+        return false;
+    m_pixmaps.insert(id,new QPixmap(p),qMax(1,p.width()*p.height()*p.depth()/8/1024));
+    m_idByCacheKey.insert(p.cacheKey(),id);
+    pix = p;
+    return true;
+}
+
+QPixmap AssetStore::loadFile(const QString &fileName)
+{
+    // Loads an image file, keeping its bytes so that store() does not need to
+    // encode the image again when it is saved unchanged
+    QFile file(fileName);
+    if(!file.open(QIODevice::ReadOnly))
+        return QPixmap();
+    QByteArray bytes = file.readAll();
+
+    QBuffer buffer(&bytes);
+    QImageReader reader(&buffer);
+    reader.setAutoTransform(true);
+    QImage img = reader.read();
+    if(img.isNull())
+        return QPixmap();
+
+    QPixmap pix = QPixmap::fromImage(img);
+    if(reader.transformation() == QImageIOHandler::TransformationNone && isReusableImageFormat(reader.format()))
+        m_fileData.insert(pix.cacheKey(),new QByteArray(bytes),qMax(qsizetype(1),bytes.size()/1024));
+    return pix;
+}
+
+QHash<qint64,QImage> AssetStore::decodeAssets(QSqlDatabase db, const QList<QVariant> &values)
+{
+    // Any thread, with a connection of that thread
+    QHash<qint64,QImage> images;
+    QSqlQuery sq(db);
+    sq.prepare("SELECT hash, data FROM Assets WHERE id = ?");
+    foreach(const QVariant &value, values)
+    {
+        if(!isAssetId(value) || images.contains(value.toLongLong()))
+            continue;
+        sq.addBindValue(value);
+        sq.exec();
+        if(!sq.first())
+            continue;
+        QImage img;
+        if(sq.value(1).isNull())
+            img = decodeMediaFile(mediaPath(db.databaseName(),sq.value(0).toString()));
+        else
+            img = byteToImage(sq.value(1).toByteArray());
+        if(!img.isNull())
+            images.insert(value.toLongLong(),img);
+    }
+    return images;
+}
+
+void AssetStore::addDecoded(const QHash<qint64,QImage> &images)
+{
+    QHashIterator<qint64,QImage> i(images);
+    while(i.hasNext())
+    {
+        i.next();
+        if(m_pixmaps.contains(i.key()))
+            continue;
+        QPixmap p = QPixmap::fromImage(i.value());
+        m_pixmaps.insert(i.key(),new QPixmap(p),qMax(1,p.width()*p.height()*p.depth()/8/1024));
+        m_idByCacheKey.insert(p.cacheKey(),i.key());
+    }
+}
+
+bool AssetStore::isDecoded(const QVariant &value)
+{
+    // True when loadPixmap() will not have to decode it
+    return isAssetId(value) && m_pixmaps.contains(value.toLongLong());
+}
+
+bool AssetStore::isAssetId(const QVariant &value)
+{
+    int type = value.typeId();
+    return type == QMetaType::LongLong || type == QMetaType::Int;
+}
+
+bool AssetStore::exists(qint64 id)
+{
+    QSqlQuery sq;
+    sq.prepare("SELECT 1 FROM Assets WHERE id = ?");
+    sq.addBindValue(id);
+    sq.exec();
+    return sq.first();
+}
+
+QString AssetStore::mediaPath(const QString &dbPath, const QString &hash)
+{
+    QFileInfo fi(dbPath);
+    return fi.absolutePath() + "/spMedia/" + hash;
+}
+
+QByteArray AssetStore::readMediaFile(const QString &path)
+{
+    // The caller owns a copy of the bytes, use decodeMediaFile() to only decode
+    QFile file(path);
+    if(!file.open(QIODevice::ReadOnly))
+        return QByteArray();
+    return file.readAll();
+}
+
+QImage AssetStore::decodeMediaFile(const QString &path, QSize bound)
+{
+    // Decodes straight from the mapped file, the data is not copied
+    QFile file(path);
+    if(!file.open(QIODevice::ReadOnly))
+        return QImage();
+    uchar *mem = file.map(0,file.size());
+    if(!mem)
+        return byteToImage(file.readAll(),bound);
+    QImage img = byteToImage(QByteArray::fromRawData((const char*)mem,file.size()),bound);
+    file.unmap(mem);
+    return img;
+}
+
+bool AssetStore::writeMediaFile(const QString &path, const QByteArray &data)
+{
+    QFileInfo fi(path);
+    if(fi.exists() && fi.size() == data.size())
+        return true; // same hash, same data
+    if(!QDir().mkpath(fi.absolutePath()))
+        return false;
+
+    QSaveFile file(path);
+    if(!file.open(QIODevice::WriteOnly))
+        return false;
+    file.write(data);
+    return file.commit();
+}
+
+void AssetStore::removeUnusedMediaFiles()
+{
+    QDir dir(QFileInfo(mediaPath(QSqlDatabase::database().databaseName(),QString())).absolutePath());
+    if(!dir.exists())
+        return;
+
+    QSet<QString> used;
+    QSqlQuery sq;
+    sq.exec("SELECT hash FROM Assets WHERE data IS NULL");
+    while(sq.next())
+        used.insert(sq.value(0).toString());
+
+    foreach(const QString &name, dir.entryList(QDir::Files))
+    {
+        // Only files named like an asset hash belong to the store
+        if(name.length() == 40 && !used.contains(name))
+            dir.remove(name);
+    }
+}
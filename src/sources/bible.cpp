@@ -18,6 +18,8 @@
 ***************************************************************************/
 
 #include "../headers/bible.hpp"
+#include "../headers/dbservice.hpp"
+#include "../headers/startupprofiler.hpp"
 
 Bible::Bible()
 {
@@ -174,7 +176,12 @@ Verse Bible::getCurrentVerseAndCaption(QList<int>  currentRows, BibleSettings& s
         verse_id += currentIdList.at(currentRows.at(i)) + ",";
     }
     verse_id.chop(1);
+    return getVerses(verse_id,sets,bv);
+}
 
+Verse Bible::getVerses(QString verse_id, BibleSettings &sets, BibleVersionSettings &bv)
+{
+    // verse_id is a comma separated list of verse ids
     Verse v;
 
     // get primary verse
@@ -415,12 +422,17 @@ void Bible::addSearchResult(const BibleVerse &bv, QList<BibleSearch> &bsl)
     bsl.append(results);
 }
 
-void Bible::loadOperatorBible()
+static QString preloadedBibleId;
+static QFuture<QList<BibleVerse> > preloadedBible;
+
+static QList<BibleVerse> readBible(QSqlDatabase db, QString id)
 {
-    operatorBible.clear();
+    QList<BibleVerse> verses;
     BibleVerse bv;
-    QSqlQuery sq;
-    sq.exec("SELECT verse_id, book, chapter, verse, verse_text FROM BibleVerse WHERE bible_id = '"+bibleId+"'");
+    QSqlQuery sq(db);
+    sq.prepare("SELECT verse_id, book, chapter, verse, verse_text FROM BibleVerse WHERE bible_id = ?");
+    sq.addBindValue(id);
+    sq.exec();
     while(sq.next())
     {
         bv.verseId = sq.value(0).toString().trimmed();
@@ -428,6 +440,33 @@ void Bible::loadOperatorBible()
         bv.chapter = sq.value(2).toInt();
         bv.verseNumber = sq.value(3).toInt();
         bv.verseText = sq.value(4).toString().trimmed();
-        operatorBible.append(bv);
+        verses.append(bv);
+    }
+    return verses;
+}
+
+static QList<BibleVerse> preloadBibleVerses(QString id)
+{
+    StartupPhase phase("bible (read)");
+    return readBible(DbService::instance()->database(),id);
+}
+
+void Bible::preload(const QString &id)
+{
+    // Reads a Bible on a database thread, the next loadOperatorBible() for it picks it up
+    if(id.isEmpty() || preloadedBible.isValid())
+        return;
+    preloadedBibleId = id;
+    preloadedBible = DbService::instance()->run(preloadBibleVerses,id);
+}
+
+void Bible::loadOperatorBible()
+{
+    if(preloadedBible.isValid() && preloadedBibleId == bibleId)
+    {
+        operatorBible = preloadedBible.result();
+        preloadedBible = QFuture<QList<BibleVerse> >();
+        return;
     }
+    operatorBible = readBible(QSqlDatabase::database(),bibleId);
 }
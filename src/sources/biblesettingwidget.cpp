@@ -19,6 +19,7 @@
 
 #include "../headers/biblesettingwidget.hpp"
 #include "ui_biblesettingwidget.h"
+#include "../headers/assetstore.hpp"
 
 BibleSettingWidget::BibleSettingWidget(QWidget *parent) :
     QWidget(parent),
@@ -907,7 +908,7 @@ void BibleSettingWidget::on_buttonBrowseBackground_clicked()
                                                     ".", tr("Images(%1)").arg(getSupportedImageFormats()));
     if(!filename.isNull())
     {
-        QPixmap p(filename);
+        QPixmap p = AssetStore::instance()->loadFile(filename);
         mySettings.backgroundPix = p;
         QFileInfo fi(filename);
         filename = fi.fileName();
@@ -922,7 +923,7 @@ void BibleSettingWidget::on_buttonBrowseBackground2_clicked()
                                                     ".", tr("Images(%1)").arg(getSupportedImageFormats()));
     if(!filename.isNull())
     {
-        QPixmap p(filename);
+        QPixmap p = AssetStore::instance()->loadFile(filename);
         mySettings2.backgroundPix = p;
         QFileInfo fi(filename);
         filename = fi.fileName();
@@ -937,7 +938,7 @@ void BibleSettingWidget::on_buttonBrowseBackground3_clicked()
                                                     ".", tr("Images(%1)").arg(getSupportedImageFormats()));
     if(!filename.isNull())
     {
-        QPixmap p(filename);
+        QPixmap p = AssetStore::instance()->loadFile(filename);
         mySettings3.backgroundPix = p;
         QFileInfo fi(filename);
         filename = fi.fileName();
@@ -952,7 +953,7 @@ void BibleSettingWidget::on_buttonBrowseBackground4_clicked()
                                                     ".", tr("Images(%1)").arg(getSupportedImageFormats()));
     if(!filename.isNull())
     {
-        QPixmap p(filename);
+        QPixmap p = AssetStore::instance()->loadFile(filename);
         mySettings4.backgroundPix = p;
         QFileInfo fi(filename);
         filename = fi.fileName();
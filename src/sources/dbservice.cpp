@@ -0,0 +1,150 @@
+/***************************************************************************
+//
+//    softProjector - an open source media projection software
+//    Copyright (C) 2017  Vladislav Kobzar
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation version 3 of the License.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+***************************************************************************/
+
+#include <QCoreApplication>
+#include "../headers/dbservice.hpp"
+
+static QList<QSqlRecord> selectRecords(QString sql, QVariantList values)
+{
+    QSqlQuery sq = DbService::instance()->prepare(sql);
+    foreach(const QVariant &v, values)
+        sq.addBindValue(v);
+    QList<QSqlRecord> records;
+    if(sq.exec())
+    {
+        while(sq.next())
+            records.append(sq.record());
+    }
+    sq.finish();
+    return records;
+}
+
+static bool execStatement(QString sql, QVariantList values)
+{
+    QSqlQuery sq = DbService::instance()->prepare(sql);
+    foreach(const QVariant &v, values)
+        sq.addBindValue(v);
+    bool ok = sq.exec();
+    sq.finish();
+    return ok;
+}
+
+DbConnection::DbConnection(const QString &name, bool owned)
+{
+    this->name = name;
+    this->owned = owned;
+}
+
+DbConnection::~DbConnection()
+{
+    // Statements have to be gone before the connection is removed
+    statements.clear();
+    if(owned)
+        QSqlDatabase::removeDatabase(name);
+}
+
+DbService *DbService::instance()
+{
+    // Never deleted, so that the GUI thread connection outlives every other user
+    static DbService *service = new DbService;
+    return service;
+}
+
+void DbService::tune(QSqlDatabase db)
+{
+    // Connection profile of the main database. With WAL, readers on other threads
+    // are not blocked by a writer, and NORMAL synchronous does not risk corruption.
+    QSqlQuery sq(db);
+    sq.exec("PRAGMA journal_mode = WAL");
+    sq.exec("PRAGMA synchronous = NORMAL");
+    sq.exec("PRAGMA cache_size = -16384"); // 16 MB
+    sq.exec("PRAGMA mmap_size = 268435456"); // 256 MB
+    sq.exec("PRAGMA temp_store = MEMORY");
+    sq.exec("PRAGMA foreign_keys = ON");
+}
+
+void DbService::init(const QString &dbPath)
+{
+    instance()->m_dbPath = dbPath;
+}
+
+DbService::DbService()
+{
+    // Pool threads stay alive, so that their connections and statements are reused
+    m_pool.setMaxThreadCount(qBound(2,QThread::idealThreadCount(),4));
+    m_pool.setExpiryTimeout(-1);
+}
+
+DbConnection *DbService::connection()
+{
+    if(!m_connections.hasLocalData())
+    {
+        if(QThread::currentThread() == qApp->thread())
+            m_connections.setLocalData(new DbConnection(QSqlDatabase::defaultConnection,false));
+        else
+        {
+            QString name = QString("spDb%1").arg(m_lastId.fetchAndAddRelaxed(1));
+            QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE",name);
+            db.setDatabaseName(m_dbPath);
+            // Wait for writers on other connections instead of failing right away
+            db.setConnectOptions("QSQLITE_BUSY_TIMEOUT=5000");
+            if(db.open())
+                tune(db);
+            m_connections.setLocalData(new DbConnection(name,true));
+        }
+    }
+    return m_connections.localData();
+}
+
+QSqlDatabase DbService::database()
+{
+    // The connection of the calling thread
+    return QSqlDatabase::database(connection()->name);
+}
+
+QSqlQuery DbService::prepare(const QString &sql)
+{
+    // Copies of a query share its prepared statement. The same statement must
+    // not be used again before the caller is done with it.
+    DbConnection *c = connection();
+    if(c->statements.contains(sql))
+        return c->statements.value(sql);
+
+    if(c->statements.count() >= 64)
+        c->statements.clear();
+    QSqlQuery sq(QSqlDatabase::database(c->name));
+    sq.prepare(sql);
+    c->statements.insert(sql,sq);
+    return sq;
+}
+
+QFuture<QList<QSqlRecord> > DbService::select(const QString &sql, const QVariantList &values)
+{
+    return QtConcurrent::run(&m_pool,selectRecords,sql,values);
+}
+
+QFuture<bool> DbService::exec(const QString &sql, const QVariantList &values)
+{
+    return QtConcurrent::run(&m_pool,execStatement,sql,values);
+}
+
+void DbService::waitForDone()
+{
+    m_pool.waitForDone();
+}
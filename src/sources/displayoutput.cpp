@@ -0,0 +1,80 @@
+/***************************************************************************
+//
+//    softProjector - an open source media projection software
+//    Copyright (C) 2017  Vladislav Kobzar
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation version 3 of the License.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+***************************************************************************/
+
+#include "../headers/displayoutput.hpp"
+
+DisplayOutput::DisplayOutput(int number, RenderCache *cache)
+{
+    m_number = number;
+    isConnected = (number == 1);
+    m_settings.themeDisplay = qMin(number,4);
+    display = new ProjectorDisplayScreen();
+    display->setRenderCache(cache);
+}
+
+DisplayOutput::~DisplayOutput()
+{
+    delete display;
+}
+
+void DisplayOutput::setSettings(const OutputSettings &sets)
+{
+    m_settings = sets;
+}
+
+int DisplayOutput::themeDisplay()
+{
+    return qBound(1,m_settings.themeDisplay,4);
+}
+
+int DisplayOutput::content()
+{
+    return m_number == 1 ? OC_ALL : m_settings.content;
+}
+
+bool DisplayOutput::shows(PresentationType type)
+{
+    switch (content()) {
+    case OC_SONGS:
+        return type == SONG;
+    case OC_LOWER_THIRD:
+        return type == BIBLE || type == SONG || type == ANNOUCEMENT;
+    default:
+        return true;
+    }
+}
+
+void DisplayOutput::applyContent(TextSettingsBase &sets)
+{
+    // Lower third text goes on black at the bottom of the screen, ready for keying
+    if(content() == OC_LOWER_THIRD)
+    {
+        sets.useBackground = false;
+        sets.screenUse = qMin(sets.screenUse,33);
+        sets.screenPosition = BOTTOM_OF_SCREEN;
+        sets.textAlignmentV = A_BOTTOM;
+    }
+}
+
+void DisplayOutput::showPassive(Theme &theme)
+{
+    TextSettings passive = theme.passiveFor(themeDisplay());
+    applyContent(passive);
+    display->renderPassiveText(passive.backgroundPix,passive.useBackground);
+}
@@ -19,6 +19,7 @@
 
 #include "../headers/editwidget.hpp"
 #include "ui_editwidget.h"
+#include "../headers/assetstore.hpp"
 #include "../headers/song.hpp"
 
 EditWidget::EditWidget(QWidget *parent) :
@@ -543,7 +544,7 @@ void EditWidget::on_toolButtonBrowseBackground_clicked()
 
     if( !filename.isNull() )
     {
-        QPixmap p(filename);
+        QPixmap p = AssetStore::instance()->loadFile(filename);
         editSong.background = p;
         QFileInfo fi(filename);
         filename = fi.fileName();
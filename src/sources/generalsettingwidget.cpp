@@ -20,6 +20,7 @@
 #include "../headers/generalsettingwidget.hpp"
 #include "ui_generalsettingwidget.h"
 #include "../headers/decklinkdiscovery.hpp"
+#include "../headers/sptextlayer.hpp"
 
 GeneralSettingWidget::GeneralSettingWidget(QWidget *parent) :
     QWidget(parent),
@@ -65,6 +66,7 @@ void GeneralSettingWidget::changeEvent(QEvent *e)
      switch ( e->type() ) {
      case QEvent::LanguageChange:
          ui->retranslateUi(this);
+         retranslateOutputRows();
          break;
      default:
          break;
@@ -87,6 +89,10 @@ void GeneralSettingWidget::loadSettings()
         ui->checkBoxUseDarkTheme->setChecked(false);
     ui->labelDarkThemeInfo->setToolTip(qApp->applicationDirPath()+"/DarkTheme.ini");
     ui->checkBoxDisplayOnStartUp->setChecked(mySettings.displayOnStartUp);
+    ui->checkBoxNativeText->setChecked(mySettings.useNativeText);
+    ui->checkBoxNativeText->setEnabled(SpTextLayer::isSupported());
+    ui->checkBoxMediaFiles->setChecked(mySettings.useMediaFiles);
+    ui->checkBoxAutosaveSchedule->setChecked(mySettings.autosaveSchedule);
 
     // Load Themes
     loadThemes();
@@ -97,7 +103,6 @@ void GeneralSettingWidget::loadSettings()
 
     int screen_count = QApplication::screens().count();
     int i = 1;
-    ui->comboBoxDisplayScreen->clear();
     for(QScreen * s: QApplication::screens())
     {
         monitors << QString("%1 - %2x%3").arg(i).arg(s->geometry().width()).arg(s->geometry().height());
@@ -155,67 +160,12 @@ void GeneralSettingWidget::loadSettings()
         ui->groupBoxDisplayScreen->setEnabled(false);
     }
 
-    // Fill display screen comboBoxes
-    ui->comboBoxDisplayScreen->clear();
-    ui->comboBoxDisplayScreen->addItems(monitors);
-    ui->comboBoxDisplayScreen_2->clear();
-    ui->comboBoxDisplayScreen_2->addItem(tr("none"));
-    ui->comboBoxDisplayScreen_2->addItems(monitors);
-    ui->comboBoxDisplayScreen_3->clear();
-    ui->comboBoxDisplayScreen_3->addItem(tr("none"));
-    ui->comboBoxDisplayScreen_3->addItems(monitors);
-    ui->comboBoxDisplayScreen_4->clear();
-    ui->comboBoxDisplayScreen_4->addItem(tr("none"));
-    ui->comboBoxDisplayScreen_4->addItems(monitors);
-
-    // Set primary display screen
-    if(mySettings.displayScreen<0 || mySettings.displayScreen>=screen_count)
-        ui->comboBoxDisplayScreen->setCurrentIndex(0);
-    else
-        ui->comboBoxDisplayScreen->setCurrentIndex(mySettings.displayScreen);
-
-    // Set secondary display screen
-    if(mySettings.displayScreen2<-1 || mySettings.displayScreen2>=screen_count)
-        ui->comboBoxDisplayScreen_2->setCurrentIndex(0);
-    else
-        ui->comboBoxDisplayScreen_2->setCurrentIndex(mySettings.displayScreen2+1);
-
-    // Set third display screen
-    if(mySettings.displayScreen3<-1 || mySettings.displayScreen3>=screen_count)
-        ui->comboBoxDisplayScreen_3->setCurrentIndex(0);
-    else
-        ui->comboBoxDisplayScreen_3->setCurrentIndex(mySettings.displayScreen3+1);
-
-    // Set fourth display screen
-    if(mySettings.displayScreen4<-1 || mySettings.displayScreen4>=screen_count)
-        ui->comboBoxDisplayScreen_4->setCurrentIndex(0);
-    else
-        ui->comboBoxDisplayScreen_4->setCurrentIndex(mySettings.displayScreen4+1);
-
-    if(screen_count -1 <2)
-    {
-        ui->comboBoxDisplayScreen_2->setCurrentIndex(0);
-        ui->comboBoxDisplayScreen_2->setEnabled(false);
-        ui->comboBoxDisplayScreen_2->setToolTip("Display unavailable");
-    }
-
-    if(ui->comboBoxDisplayScreen_2->currentIndex() == 0)
-        ui->comboBoxDisplayScreen_3->setEnabled(false);
-
-    if(screen_count -1 <3)
-    {
-        ui->comboBoxDisplayScreen_3->setCurrentIndex(0);
-        ui->comboBoxDisplayScreen_3->setEnabled(false);
-        ui->comboBoxDisplayScreen_3->setToolTip("Display unavailable");
-    }
-
-    if(screen_count -1 <4)
-    {
-        ui->comboBoxDisplayScreen_4->setCurrentIndex(0);
-        ui->comboBoxDisplayScreen_4->setEnabled(false);
-        ui->comboBoxDisplayScreen_4->setToolTip("Display unavailable");
-    }
-    updateSecondaryDisplayScreen();
+    // One row per display output, the first one is the primary display screen
+    while(!screenCombos.isEmpty())
+        removeOutputRow();
+    foreach(const OutputSettings &o, mySettings.outputs)
+        addOutputRow(o);
+    updateOutputScreens();
 
     // Set Display Controls
     if(screen_count>1)
@@ -248,6 +198,9 @@ GeneralSettings GeneralSettingWidget::getSettings()
     mySettings.displayIsOnTop = ui->checkBoxDisplayOnTop->isChecked();
     mySettings.useDarkTheme = ui->checkBoxUseDarkTheme->isChecked();
     mySettings.displayOnStartUp = ui->checkBoxDisplayOnStartUp->isChecked();
+    mySettings.useNativeText = ui->checkBoxNativeText->isChecked();
+    mySettings.useMediaFiles = ui->checkBoxMediaFiles->isChecked();
+    mySettings.autosaveSchedule = ui->checkBoxAutosaveSchedule->isChecked();
 
     int tmx = ui->comboBoxTheme->currentIndex();
     if(tmx != -1)
@@ -255,63 +208,14 @@ GeneralSettings GeneralSettingWidget::getSettings()
     else
         mySettings.currentThemeId = 0;
 
-    mySettings.displayScreen = ui->comboBoxDisplayScreen->currentIndex();
-    
-    // Handle DeckLink device indices
-    int regularScreenCount = QApplication::screens().count();
-    QString display2Text = ui->comboBoxDisplayScreen_2->currentText();
-    if (display2Text != tr("none") && display2Text != tr("None"))
-    {
-        int index2 = monitors.indexOf(display2Text);
-        if (index2 >= regularScreenCount && !deckLinkDevices.isEmpty())
-        {
-            // This is a DeckLink device - adjust index
-            mySettings.displayScreen2 = index2;
-        }
-        else
-        {
-            mySettings.displayScreen2 = index2;
-        }
-    }
-    else
-    {
-        mySettings.displayScreen2 = -1;
-    }
-    
-    QString display3Text = ui->comboBoxDisplayScreen_3->currentText();
-    if (display3Text != tr("none") && display3Text != tr("None"))
-    {
-        int index3 = monitors.indexOf(display3Text);
-        if (index3 >= regularScreenCount && !deckLinkDevices.isEmpty())
-        {
-            mySettings.displayScreen3 = index3;
-        }
-        else
-        {
-            mySettings.displayScreen3 = index3;
-        }
-    }
-    else
+    mySettings.outputs.clear();
+    for(int i(0);i<screenCombos.count();++i)
     {
-        mySettings.displayScreen3 = -1;
-    }
-    
-    QString display4Text = ui->comboBoxDisplayScreen_4->currentText();
-    if (display4Text != tr("none") && display4Text != tr("None"))
-    {
-        int index4 = monitors.indexOf(display4Text);
-        if (index4 >= regularScreenCount && !deckLinkDevices.isEmpty())
-        {
-            mySettings.displayScreen4 = index4;
-        }
-        else
-        {
-            mySettings.displayScreen4 = index4;
-        }
-    }
-    else
-    {
-        mySettings.displayScreen4 = -1;
+        OutputSettings o;
+        o.screen = outputScreen(i);
+        o.themeDisplay = themeDisplayCombos.at(i)->currentIndex()+1;
+        o.content = contentCombos.at(i)->currentIndex();
+        mySettings.outputs << o;
     }
 
     mySettings.displayControls.buttonSize = ui->comboBoxIconSize->currentIndex();
@@ -331,111 +235,143 @@ void GeneralSettingWidget::on_pushButtonDefault_clicked()
     loadSettings();
 }
 
-void GeneralSettingWidget::updateSecondaryDisplayScreen()
+QString GeneralSettingWidget::outputLabel(int row)
 {
-    QString ds1 = ui->comboBoxDisplayScreen->currentText();
-    QString ds2 = ui->comboBoxDisplayScreen_2->currentText();
-    QString ds3 = ui->comboBoxDisplayScreen_3->currentText();
-    QString ds4 = ui->comboBoxDisplayScreen_4->currentText();
-    QStringList monitors2 = monitors;
-    //Display 2 (ds2)
-    monitors2.removeOne(ds1);
-
-    ui->comboBoxDisplayScreen_2->clear();
-    ui->comboBoxDisplayScreen_2->addItem(tr("None"));
-    ui->comboBoxDisplayScreen_2->addItems(monitors2);
-
-    int i = ui->comboBoxDisplayScreen_2->findText(ds2);
-    if(i != -1)
-        ui->comboBoxDisplayScreen_2->setCurrentIndex(i);
-    else
-    {
-        ui->comboBoxDisplayScreen_2->setCurrentIndex(0);
-        emit setDisp2Use(false);
-    }
-
-    // Display 3 (ds3)
-    monitors2.removeOne(ds1);
-    monitors2.removeOne(ds2);
-
-    ui->comboBoxDisplayScreen_3->clear();
-    ui->comboBoxDisplayScreen_3->addItem(tr("None"));
-    ui->comboBoxDisplayScreen_3->addItems(monitors2);
+    if(row == 0)
+        return tr("Primary Display Screen:");
+    return tr("Display Output %1:").arg(row+1);
+}
 
-    i = ui->comboBoxDisplayScreen_3->findText(ds3);
-    if(i != -1)
-        ui->comboBoxDisplayScreen_3->setCurrentIndex(i);
-    else
+void GeneralSettingWidget::retranslateOutputRows()
+{
+    for(int i(0);i<screenCombos.count();++i)
     {
-        ui->comboBoxDisplayScreen_3->setCurrentIndex(0);
-        emit setDisp3Use(false);
+        outputLabels.at(i)->setText(outputLabel(i));
+        if(i > 0)
+            screenCombos.at(i)->setItemText(0,tr("None"));
+        for(int d(0);d<4;++d)
+            themeDisplayCombos.at(i)->setItemText(d,tr("Theme display %1").arg(d+1));
+        contentCombos.at(i)->setItemText(OC_ALL,tr("All content"));
+        contentCombos.at(i)->setItemText(OC_SONGS,tr("Songs only"));
+        contentCombos.at(i)->setItemText(OC_LOWER_THIRD,tr("Lower third"));
     }
+}
 
-    // Display 4 (ds4)
-    monitors2.removeOne(ds1);
-    monitors2.removeOne(ds2);
-    monitors2.removeOne(ds3);
+void GeneralSettingWidget::addOutputRow(const OutputSettings &o)
+{
+    int row = screenCombos.count();
+    QLabel *label = new QLabel(outputLabel(row));
+    label->setAlignment(Qt::AlignRight|Qt::AlignTrailing|Qt::AlignVCenter);
+
+    // Every screen is offered here, updateOutputScreens() leaves out the taken ones
+    QComboBox *screen = new QComboBox;
+    screen->setSizePolicy(QSizePolicy::Expanding,QSizePolicy::Fixed);
+    screen->setToolTip(tr("Select onto which screen to display"));
+    if(row > 0)
+        screen->addItem(tr("None"));
+    screen->addItems(monitors);
+    if(o.screen >= 0 && o.screen < monitors.count())
+        screen->setCurrentIndex(row > 0 ? o.screen+1 : o.screen);
+    connect(screen,SIGNAL(activated(int)),this,SLOT(updateOutputScreens()));
+
+    QComboBox *themeDisplay = new QComboBox;
+    themeDisplay->setToolTip(tr("Select which display settings of the theme this display screen uses"));
+    for(int d(0);d<4;++d)
+        themeDisplay->addItem(tr("Theme display %1").arg(d+1));
+    themeDisplay->setCurrentIndex(qBound(1,o.themeDisplay,4)-1);
+    connect(themeDisplay,SIGNAL(activated(int)),this,SLOT(updateThemeDisplayUse()));
+
+    QComboBox *content = new QComboBox;
+    content->setToolTip(tr("Select what to show on this display screen"));
+    content->addItem(tr("All content"));
+    content->addItem(tr("Songs only"));
+    content->addItem(tr("Lower third"));
+    content->setCurrentIndex(row > 0 ? o.content : int(OC_ALL));
+    content->setEnabled(row > 0); // the primary display screen shows everything
+
+    ui->gridLayoutOutputs->addWidget(label,row,0);
+    ui->gridLayoutOutputs->addWidget(screen,row,1);
+    ui->gridLayoutOutputs->addWidget(themeDisplay,row,2);
+    ui->gridLayoutOutputs->addWidget(content,row,3);
+    outputLabels << label;
+    screenCombos << screen;
+    themeDisplayCombos << themeDisplay;
+    contentCombos << content;
+    updateOutputButtons();
+}
 
-    ui->comboBoxDisplayScreen_4->clear();
-    ui->comboBoxDisplayScreen_4->addItem(tr("None"));
-    ui->comboBoxDisplayScreen_4->addItems(monitors2);
+void GeneralSettingWidget::removeOutputRow()
+{
+    delete outputLabels.takeLast();
+    delete screenCombos.takeLast();
+    delete themeDisplayCombos.takeLast();
+    delete contentCombos.takeLast();
+    updateOutputButtons();
+}
 
-    i = ui->comboBoxDisplayScreen_4->findText(ds4);
-    if(i != -1)
-        ui->comboBoxDisplayScreen_4->setCurrentIndex(i);
-    else
-    {
-        ui->comboBoxDisplayScreen_4->setCurrentIndex(0);
-        emit setDisp4Use(false);
-    }
+void GeneralSettingWidget::updateOutputButtons()
+{
+    // There is always a primary display screen, and no more outputs than screens
+    ui->pushButtonAddOutput->setEnabled(screenCombos.count() < qMax(1,monitors.count()));
+    ui->pushButtonRemoveOutput->setEnabled(screenCombos.count() > 1);
 }
 
-void GeneralSettingWidget::on_comboBoxDisplayScreen_activated(const QString &arg1)
+int GeneralSettingWidget::outputScreen(int row)
 {
-    updateSecondaryDisplayScreen();
+    // Index into monitors, -1 when the output is not shown
+    QComboBox *cb = screenCombos.at(row);
+    if(row > 0 && cb->currentIndex() <= 0)
+        return -1;
+    return qMax(0,monitors.indexOf(cb->currentText()));
 }
 
-void GeneralSettingWidget::on_comboBoxDisplayScreen_2_activated(int index)
+void GeneralSettingWidget::updateOutputScreens()
 {
-    updateSecondaryDisplayScreen();
-    int screen_count = QGuiApplication::screens().count();
-    if(index<=0)
+    // A screen is used by one output only, each output offers the screens
+    // that the outputs above it left
+    QStringList available = monitors;
+    for(int i(0);i<screenCombos.count();++i)
     {
-        emit setDisp2Use(false);
-        ui->comboBoxDisplayScreen_3->setEnabled(false);
-    }
-    else
-    {
-        emit setDisp2Use(true);
-        if(screen_count -1 >=3)
-            ui->comboBoxDisplayScreen_3->setEnabled(true);
+        QComboBox *cb = screenCombos.at(i);
+        QString current = cb->currentText();
+        cb->clear();
+        if(i > 0)
+            cb->addItem(tr("None"));
+        cb->addItems(available);
+        int j = cb->findText(current);
+        cb->setCurrentIndex(j != -1 ? j : 0);
+        if(i == 0 || cb->currentIndex() > 0)
+            available.removeOne(cb->currentText());
     }
+    updateThemeDisplayUse();
 }
 
-void GeneralSettingWidget::on_comboBoxDisplayScreen_3_activated(int index)
+void GeneralSettingWidget::updateThemeDisplayUse()
 {
-    updateSecondaryDisplayScreen();
-    int screen_count = QGuiApplication::screens().count();
-    if(index<=0)
+    // Theme display settings are only edited for displays that a shown output uses
+    QSet<int> used;
+    for(int i(0);i<screenCombos.count();++i)
     {
-        emit setDisp3Use(false);
-        ui->comboBoxDisplayScreen_4->setEnabled(false);
+        if(outputScreen(i) != -1)
+            used.insert(themeDisplayCombos.at(i)->currentIndex()+1);
     }
+    emit setDisp2Use(used.contains(2));
+    emit setDisp3Use(used.contains(3));
+    emit setDisp4Use(used.contains(4));
+}
 
-    else
-    {
-        emit setDisp3Use(true);
-        if(screen_count -1 >=4)
-            ui->comboBoxDisplayScreen_4->setEnabled(true);
-    }
+void GeneralSettingWidget::on_pushButtonAddOutput_clicked()
+{
+    // A new output takes the next theme display settings and is not shown yet
+    addOutputRow(OutputSettings(-1,qMin(screenCombos.count()+1,4)));
+    updateOutputScreens();
 }
 
-void GeneralSettingWidget::on_comboBoxDisplayScreen_4_activated(int index)
+void GeneralSettingWidget::on_pushButtonRemoveOutput_clicked()
 {
-    if(index<=0)
-        emit setDisp4Use(false);
-    else
-        emit setDisp4Use(true);
+    if(screenCombos.count() > 1)
+        removeOutputRow();
+    updateOutputScreens();
 }
 
 void GeneralSettingWidget::on_pushButtonAddTheme_clicked()
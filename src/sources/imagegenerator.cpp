@@ -17,16 +17,34 @@
 //
 ***************************************************************************/
 
+#include <QVector>
 #include "../headers/imagegenerator.hpp"
+#include "../headers/renderprofiler.hpp"
 
 
+TextRun::TextRun()
+{
+    flags = 0;
+    direction = Qt::LayoutDirectionAuto;
+    isFill = false;
+}
+
+TextFrame::TextFrame()
+{
+    shadowOffset = 0;
+    isNative = false;
+}
+
 ImageGenerator::ImageGenerator()
 {
     m_type = 0;
+    m_recordOnly = false;
+    m_textPainter = m_shadowPainter = NULL;
     m_shadow = m_blurShadow = false;
     m_shadowOffset = 3;
     m_blurRadius = 5;
     m_screenSize = QSize(1280,960);
+    m_bibleAddBKColorToText = m_songAddBKColorToText = m_announcementAddBKColorToText = false;
 }
 
 void ImageGenerator::setScreenSize(QSize size)
@@ -39,6 +57,16 @@ QSize ImageGenerator::getScreenSize()
     return m_screenSize;
 }
 
+void ImageGenerator::setRecordOnly(bool recordOnly)
+{
+    m_recordOnly = recordOnly;
+}
+
+TextFrame ImageGenerator::textFrame()
+{
+    return m_frame;
+}
+
 int ImageGenerator::width()
 {
     return m_screenSize.width();
@@ -51,19 +79,27 @@ int ImageGenerator::height()
 
 QPixmap ImageGenerator::generateEmptyImage()
 {
-    QPixmap pmap(m_screenSize);
-    pmap.fill(QColor(0,0,0,0));
-    return pmap;
+    // Solid frames only change with screen size, so they are generated once
+    if(m_emptyPix.size() != m_screenSize)
+    {
+        m_emptyPix = QPixmap(m_screenSize);
+        m_emptyPix.fill(QColor(0,0,0,0));
+    }
+    return m_emptyPix;
 }
 
 QPixmap ImageGenerator::generateColorImage(QColor &color)
 {
-    QPixmap pmap(m_screenSize);
-    pmap.fill(color);
-    return pmap;
+    if(m_colorPix.size() != m_screenSize || m_pixColor != color)
+    {
+        m_colorPix = QPixmap(m_screenSize);
+        m_colorPix.fill(color);
+        m_pixColor = color;
+    }
+    return m_colorPix;
 }
 
-QPixmap ImageGenerator::generateBibleImage(Verse verse, BibleSettings &bSets)
+QImage ImageGenerator::generateBibleImage(const Verse &verse, const BibleSettings &bSets)
 {
     m_type = 1;
     m_verse = verse;
@@ -81,12 +117,14 @@ QPixmap ImageGenerator::generateBibleImage(Verse verse, BibleSettings &bSets)
     m_bibleAddBKColorToText = m_bSets.bibleAddBKColorToText;
     m_bibleTextRecBKColor = m_bSets.bibleTextRecBKColor;
     m_bibleTextGenBKColor = m_bSets.bibleTextGenBKColor;
+    // Output must depend only on current settings, so that it can be shared between screens
+    m_songAddBKColorToText = m_announcementAddBKColorToText = false;
 
     m_isTextPrepared = false;
     return renderText();
 }
 
-QPixmap ImageGenerator::generateSongImage(Stanza stanza, SongSettings &sSets)
+QImage ImageGenerator::generateSongImage(const Stanza &stanza, const SongSettings &sSets)
 {
     m_type = 2;
     m_stanza = stanza;
@@ -103,12 +141,13 @@ QPixmap ImageGenerator::generateSongImage(Stanza stanza, SongSettings &sSets)
     m_songAddBKColorToText = m_sSets.songAddBKColorToText;
     m_songTextRecBKColor = m_sSets.songTextRecBKColor;
     m_songTextGenBKColor = m_sSets.songTextGenBKColor;
+    m_bibleAddBKColorToText = m_announcementAddBKColorToText = false;
 
     m_isTextPrepared = false;
     return renderText();
 }
 
-QPixmap ImageGenerator::generateAnnounceImage(AnnounceSlide announce, TextSettings &aSets)
+QImage ImageGenerator::generateAnnounceImage(const AnnounceSlide &announce, const TextSettings &aSets)
 {
     m_type = 3;
     m_announce = announce;
@@ -119,21 +158,43 @@ QPixmap ImageGenerator::generateAnnounceImage(AnnounceSlide announce, TextSettin
 //    m_blurShadow = (m_aSets.effectsType == 2);
     m_shadow = m_aSets.useShadow;
     m_blurShadow = m_aSets.useBlurShadow;
+    m_announcementAddBKColorToText = m_aSets.announcementAddBKColorToText;
+    m_announcementTextRecBKColor = m_aSets.announcementTextRecBKColor;
+    m_announcementTextGenBKColor = m_aSets.announcementTextGenBKColor;
+    m_bibleAddBKColorToText = m_songAddBKColorToText = false;
 
     m_isTextPrepared = false;
     return renderText();
 
 }
 
-QPixmap ImageGenerator::renderText()
+QImage ImageGenerator::renderText()
 {
-    QPixmap textMap(m_screenSize), shadowMap(m_screenSize), outMap(m_screenSize);
+    RenderSpan span(RenderProfiler::TextRender);
+
+    // Painting into a one pixel image still gives the same layout, as long as the
+    // resolution stays the same. That is enough when only the runs are needed.
+    QSize mapSize = m_recordOnly ? QSize(1,1) : m_screenSize;
+    QImage textMap(mapSize,QImage::Format_ARGB32_Premultiplied);
+    QImage shadowMap(mapSize,QImage::Format_ARGB32_Premultiplied);
+    QImage outMap(mapSize,QImage::Format_ARGB32_Premultiplied);
+
+    m_frame = TextFrame();
+    m_frame.size = m_screenSize;
+    m_frame.shadowOffset = m_shadowOffset;
+    m_frame.isNative = m_recordOnly;
+
     //fill with transparent background
     if(m_bibleAddBKColorToText == 1 || m_songAddBKColorToText == 1 || m_announcementAddBKColorToText == 1)
     {  
-        if(m_announcementAddBKColorToText == 1) textMap.fill(m_announcementTextGenBKColor);
-        if(m_songAddBKColorToText == 1) textMap.fill(m_songTextGenBKColor);
-        if(m_bibleAddBKColorToText == 1) textMap.fill(m_bibleTextGenBKColor);
+        TextRun fill;
+        if(m_announcementAddBKColorToText == 1) fill.color = m_announcementTextGenBKColor;
+        if(m_songAddBKColorToText == 1) fill.color = m_songTextGenBKColor;
+        if(m_bibleAddBKColorToText == 1) fill.color = m_bibleTextGenBKColor;
+        textMap.fill(fill.color);
+        fill.rect = QRect(QPoint(0,0),m_screenSize);
+        fill.isFill = true;
+        m_frame.runs.append(fill);
     } else {
         textMap.fill(QColor(0,0,0,0));
     }
@@ -141,6 +202,8 @@ QPixmap ImageGenerator::renderText()
     outMap.fill(QColor(0,0,0,0));
 
     QPainter textPaint(&textMap), shadowPaint(&shadowMap), outPaint(&outMap);
+    m_textPainter = &textPaint;
+    m_shadowPainter = &shadowPaint;
     //TODO: remove set paint for shadow and make it as an option in settings.
 
     // int shadowOffset(0);
@@ -183,28 +246,76 @@ QPixmap ImageGenerator::renderText()
 
     textPaint.end();
     shadowPaint.end();
+    m_textPainter = m_shadowPainter = NULL;
 
+    if(m_recordOnly)
+    {
+        outPaint.end();
+        return QImage();
+    }
 
     // Set the blured image to the produced text image:
     if(m_blurShadow) // Blur the shadow:
     {
-        QGraphicsBlurEffect* beff = new QGraphicsBlurEffect;
-        beff->setBlurRadius(m_blurRadius);
-        shadowMap = applyEffectToImage(shadowMap,beff);
+        RenderSpan blurSpan(RenderProfiler::ShadowBlur);
+        fastbluralpha(shadowMap,m_blurRadius);
     }
 
     // draw shadow onto output pixmap
 
     if(m_shadow || m_blurShadow)
-        outPaint.drawPixmap(m_shadowOffset,m_shadowOffset,shadowMap);
+        outPaint.drawImage(m_shadowOffset,m_shadowOffset,shadowMap);
 
     // draw text onto output pixmap
-    outPaint.drawPixmap(0,0,textMap);
+    outPaint.drawImage(0,0,textMap);
     outPaint.end();
 
     return outMap;
 }
 
+QRect ImageGenerator::textBoundingRect(QPainter *painter, const QRect &rect, int flags, const QString &text)
+{
+    // Same result as QPainter::boundingRect, but the shaped text is kept for drawing
+    return m_layouts.block(text,painter->font(),rect.width(),flags,painter->device(),painter->layoutDirection())->boundingRect(rect);
+}
+
+void ImageGenerator::drawTextRun(QPainter *painter, const QRect &rect, int flags, const QString &text, QRect *br)
+{
+    QSharedPointer<TextBlock> block = m_layouts.block(text,painter->font(),rect.width(),flags,painter->device(),painter->layoutDirection());
+    if(!m_recordOnly)
+        block->draw(painter,rect);
+    if(br)
+        *br = block->boundingRect(rect);
+
+    TextRun run;
+    run.text = text;
+    run.font = painter->font();
+    run.color = painter->pen().color();
+    run.rect = rect;
+    run.flags = flags;
+    run.direction = painter->layoutDirection();
+    recordRun(painter,run);
+}
+
+void ImageGenerator::fillRun(QPainter *painter, const QRect &rect, const QColor &color)
+{
+    painter->fillRect(rect, QBrush(color, Qt::SolidPattern));
+
+    TextRun run;
+    run.color = color;
+    run.rect = rect;
+    run.isFill = true;
+    recordRun(painter,run);
+}
+
+void ImageGenerator::recordRun(QPainter *painter, const TextRun &run)
+{
+    if(painter == m_textPainter)
+        m_frame.runs.append(run);
+    else if(painter == m_shadowPainter)
+        m_frame.shadowRuns.append(run);
+}
+
 QRect ImageGenerator::boundRectOrDrawText(QPainter *painter, bool draw, int left, int top, int width, int height, int flags, QString text)
 {
     // If draw is false, calculate the rectangle that the specified text would be
@@ -213,9 +324,9 @@ QRect ImageGenerator::boundRectOrDrawText(QPainter *painter, bool draw, int left
 
     QRect out_rect;
     if(draw)
-        painter->drawText(left, top, width, height, flags, text, &out_rect);
+        drawTextRun(painter, QRect(left, top, width, height), flags, text, &out_rect);
     else
-        out_rect = painter->boundingRect(left, top, width, height, flags, text);
+        out_rect = textBoundingRect(painter, QRect(left, top, width, height), flags, text);
     return out_rect;
 }
 
@@ -385,16 +496,16 @@ void ImageGenerator::drawBibleText(QPainter *painter, bool isShadow)
         painter->setPen(m_bSets.textColor);
     }
 
-    painter->drawText(left,m_bdSets.ptRect.top(),w,m_bdSets.ptRect.height(), tflags, m_verse.primary_text);
+    drawTextRun(painter,QRect(left,m_bdSets.ptRect.top(),w,m_bdSets.ptRect.height()), tflags, m_verse.primary_text);
 
     if(haveSecondary && !m_verse.secondary_text.isEmpty())
     {
-        painter->drawText(left,m_bdSets.stRect.top(),w,m_bdSets.stRect.height(), tflags, m_verse.secondary_text);
+        drawTextRun(painter,QRect(left,m_bdSets.stRect.top(),w,m_bdSets.stRect.height()), tflags, m_verse.secondary_text);
     }
 
     if(haveTrinary && !m_verse.trinary_text.isEmpty())
     {
-        painter->drawText(left,m_bdSets.ttRect.top(),w,m_bdSets.ttRect.height(), tflags, m_verse.trinary_text);
+        drawTextRun(painter,QRect(left,m_bdSets.ttRect.top(),w,m_bdSets.ttRect.height()), tflags, m_verse.trinary_text);
     }
 
     painter->setFont(m_bdSets.cFont);
@@ -409,16 +520,16 @@ void ImageGenerator::drawBibleText(QPainter *painter, bool isShadow)
         painter->setPen(m_bSets.captionColor);
     }
 
-    painter->drawText(m_bdSets.pcRect, cflags, m_verse.primary_caption);
+    drawTextRun(painter,m_bdSets.pcRect, cflags, m_verse.primary_caption);
 
     if(haveSecondary && !m_verse.secondary_text.isEmpty())
     {
-        painter->drawText(m_bdSets.scRect, cflags, m_verse.secondary_caption);
+        drawTextRun(painter,m_bdSets.scRect, cflags, m_verse.secondary_caption);
     }
 
     if(haveTrinary && !m_verse.trinary_text.isEmpty())
     {
-        painter->drawText(m_bdSets.tcRect, cflags, m_verse.trinary_caption);
+        drawTextRun(painter,m_bdSets.tcRect, cflags, m_verse.trinary_caption);
     }
 }
 
@@ -428,16 +539,16 @@ void ImageGenerator::drawBibleTextToRect(QPainter *painter, QRect& trect, QRect&
 {
     // prepare caption
     painter->setFont(m_bSets.captionFont);
-    crect = painter->boundingRect(left, top, width, height, cflags, ctext);
+    crect = textBoundingRect(painter, QRect(left, top, width, height), cflags, ctext);
 
     // prepare text
     painter->setFont(m_bSets.textFont);
-    trect = painter->boundingRect(left, top, width, height-crect.height(), tflags, ttext);
+    trect = textBoundingRect(painter, QRect(left, top, width, height-crect.height()), tflags, ttext);
 
     if(m_bibleAddBKColorToText == 1)
     {
         int fillheight = trect.height()+crect.height();
-        painter->fillRect(QRect(0, top+height-fillheight-left, width+(left*2), top+height), QBrush(m_bibleTextRecBKColor, Qt::SolidPattern));
+        fillRun(painter, QRect(0, top+height-fillheight-left, width+(left*2), top+height), m_bibleTextRecBKColor);
     }
 
     // reset capion location
@@ -659,7 +770,7 @@ void ImageGenerator::drawSongText(QPainter *painter, bool isShadow)
     if(m_songAddBKColorToText == 1)
     {
         int fillheight = main_rect.height()+caption_rect.height();
-        painter->fillRect(QRect(0, top+height-fillheight-left, width+(left*2), top+height), QBrush(m_songTextRecBKColor, Qt::SolidPattern));
+        fillRun(painter, QRect(0, top+height-fillheight-left, width+(left*2), top+height), m_songTextRecBKColor);
     }
     if(m_sSets.infoAling == 0 && m_sSets.endingPosition == 0)
     {
@@ -786,7 +897,7 @@ void ImageGenerator::drawAnnounceText(QPainter *painter, bool isShadow)
         bool exit = false;
         while( !exit )
         {
-            rect = painter->boundingRect(left, top, w, h, flags, m_announce.text);
+            rect = textBoundingRect(painter, QRect(left, top, w, h), flags, m_announce.text);
             exit = ( rect.width() <= w && rect.height() <= h );
             if( !exit )
             {
@@ -805,7 +916,7 @@ void ImageGenerator::drawAnnounceText(QPainter *painter, bool isShadow)
             exit = false;
             while( !exit )
             {
-                rect = painter->boundingRect(left, top, w, h, flags, m_announce.text);
+                rect = textBoundingRect(painter, QRect(left, top, w, h), flags, m_announce.text);
                 exit = ( rect.width() <= w && rect.height() <= h );
                 if( !exit )
                 {
@@ -822,7 +933,7 @@ void ImageGenerator::drawAnnounceText(QPainter *painter, bool isShadow)
     if(m_announcementAddBKColorToText == 1)
     {
         int fillheight = m_adSets.tRect.height();
-        painter->fillRect(QRect(0, top+h-fillheight-left, w+(left*2), top+h), QBrush(m_announcementTextRecBKColor, Qt::SolidPattern));
+        fillRun(painter, QRect(0, top+h-fillheight-left, w+(left*2), top+h), m_announcementTextRecBKColor);
     }
 
     painter->setFont(m_aSets.textFont);
@@ -830,22 +941,59 @@ void ImageGenerator::drawAnnounceText(QPainter *painter, bool isShadow)
         painter->setPen(QColor(Qt::black));
     else
         painter->setPen(m_aSets.textColor);
-    painter->drawText(m_adSets.tRect, flags, m_announce.text);
+    drawTextRun(painter,m_adSets.tRect, flags, m_announce.text);
 }
 
 
-QPixmap ImageGenerator::applyEffectToImage(QPixmap src, QGraphicsEffect *effect)
+static void boxBlurLine(QRgb *p, int stride, int length, int radius, QRgb *line)
+{
+    // Running sum box blur of one row or column. Pixels outside of the image
+    // are treated as transparent.
+    for(int i(0);i<length;++i)
+        line[i] = p[i*stride];
+
+    int div = radius + radius + 1;
+    int sa(0), sr(0), sg(0), sb(0);
+    for(int i(0);i<radius && i<length;++i)
+    {
+        sa += qAlpha(line[i]); sr += qRed(line[i]); sg += qGreen(line[i]); sb += qBlue(line[i]);
+    }
+    for(int i(0);i<length;++i)
+    {
+        int in = i + radius;
+        if(in < length)
+        {
+            sa += qAlpha(line[in]); sr += qRed(line[in]); sg += qGreen(line[in]); sb += qBlue(line[in]);
+        }
+        int out = i - radius - 1;
+        if(out >= 0)
+        {
+            sa -= qAlpha(line[out]); sr -= qRed(line[out]); sg -= qGreen(line[out]); sb -= qBlue(line[out]);
+        }
+        p[i*stride] = qRgba(sr/div, sg/div, sb/div, sa/div);
+    }
+}
+
+void ImageGenerator::fastbluralpha(QImage &img, int radius)
 {
-    if(src.isNull()) return QPixmap(); //No need to do anything else!
-    if(!effect) return src; //No need to do anything else!
-    QGraphicsScene scene;
-    QGraphicsPixmapItem item;
-    item.setPixmap(src);
-    item.setGraphicsEffect(effect);
-    scene.addItem(&item);
-    QPixmap res(src.size());
-    res.fill(Qt::transparent);
-    QPainter ptr(&res);
-    scene.render(&ptr);
-    return res;
+    // Two passes of a separable box blur, which is close to the gaussian blur that
+    // QGraphicsBlurEffect used to give. Unlike the graphics effect it does not need
+    // a QGraphicsScene, so it is safe to run outside of the GUI thread.
+    if(radius < 1 || img.isNull())
+        return;
+    if(img.format() != QImage::Format_ARGB32_Premultiplied)
+        img = img.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+
+    int w = img.width();
+    int h = img.height();
+    int stride = img.bytesPerLine()/4;
+    QRgb *bits = reinterpret_cast<QRgb*>(img.bits());
+    QVector<QRgb> line(qMax(w,h));
+    for(int pass(0);pass<2;++pass)
+    {
+        for(int y(0);y<h;++y)
+            boxBlurLine(bits+y*stride,1,w,radius,line.data());
+        for(int x(0);x<w;++x)
+            boxBlurLine(bits+x,stride,h,radius,line.data());
+    }
 }
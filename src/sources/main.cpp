@@ -21,13 +21,51 @@
 #include <QMessageBox>
 #include <QtSql>
 #include <QStyleFactory>
+#include <QTimer>
 #include "../headers/softprojector.hpp"
+#include "../headers/sptextlayer.hpp"
+#include "../headers/assetstore.hpp"
+#include "../headers/mediacatalog.hpp"
+#include "../headers/dbservice.hpp"
+#include "../headers/startupprofiler.hpp"
 
 // Definitions for database versions 'dbVer' numbers
 // x - Official release. ex: 2 - for SoftProjector 2
 // xxx - Official sub realeas. ex: 201 - for SoftProjector 2.01
 // 990xxx - Development release. ex: 990206 - for SoftProjector 2 Development Build 6 (2db6)
-int const dbVer = 2;
+// 3 - Images are stored once in the Assets table
+// 4 - Media library catalog
+// 5 - Settings are stored as binary sections in SettingsData
+int const dbVer = 5;
+
+bool upgradeDatabase(int &dbVersion)
+{
+    // Brings older databases to the current version, one step at a time
+    QSqlQuery sq;
+    if(dbVersion == 2)
+    {
+        AssetStore::createTables(sq);
+        dbVersion = 3;
+    }
+    if(dbVersion == 3)
+    {
+        MediaCatalog::createTables(sq);
+        dbVersion = 4;
+    }
+    if(dbVersion == 4)
+    {
+        // One transaction, the text settings are kept when they could not be converted
+        QSqlDatabase db = QSqlDatabase::database();
+        db.transaction();
+        Settings::createTables(sq);
+        if(Settings::convertTextSettings() && sq.exec("PRAGMA user_version = 5") && db.commit())
+            dbVersion = 5;
+        else
+            db.rollback();
+    }
+    sq.exec(QString("PRAGMA user_version = %1").arg(dbVersion));
+    return dbVersion == dbVer;
+}
 
 bool connect(QString database_file)
 {
@@ -54,6 +92,16 @@ bool connect(QString database_file)
     }
     else
     {
+        // New databases can give free pages back without a full VACUUM,
+        // this has to be set before the first table is created
+        if(!database_exists)
+        {
+            QSqlQuery sq;
+            sq.exec("PRAGMA auto_vacuum = INCREMENTAL");
+        }
+        DbService::tune(db);
+        DbService::init(database_file);
+
         // If no files exited, then database has been created now we need to fill it
         if(!database_exists)
         {
@@ -69,7 +117,6 @@ bool connect(QString database_file)
             sq.exec("CREATE TABLE 'BibleVersions' ('id' INTEGER PRIMARY KEY  AUTOINCREMENT  NOT NULL, "
                     "'bible_name' TEXT, 'abbreviation' TEXT, 'information' TEXT, 'right_to_left' INTEGER DEFAULT 0)");
             sq.exec("CREATE TABLE 'Media' ('long_path' TEXT, 'short_path' TEXT)");
-            sq.exec("CREATE TABLE 'Settings' ('type' TEXT, 'sets' TEXT)");
             sq.exec("CREATE TABLE 'SlideShows' ('id' INTEGER PRIMARY KEY  AUTOINCREMENT  NOT NULL , 'name' TEXT, 'info' TEXT)");
             sq.exec("CREATE TABLE 'Slides' ('id' INTEGER PRIMARY KEY  AUTOINCREMENT  NOT NULL , "
                     "'ss_id' INTEGER, 'p_order' INTEGER, 'name' TEXT, 'path' TEXT, "
@@ -102,6 +149,9 @@ bool connect(QString database_file)
                     "'add_background_color_to_text' BOOL, 'text_rec_background_color' INTEGER, 'text_gen_background_color' INTEGER)");
             //sq.exec("CREATE TABLE 'ThemeData' ('theme_id' INTEGER, 'type' TEXT, 'sets' TEXT)");
             sq.exec("CREATE TABLE 'Themes' ('id' INTEGER PRIMARY KEY  AUTOINCREMENT  NOT NULL , 'name' TEXT, 'comment' TEXT)");
+            AssetStore::createTables(sq);
+            MediaCatalog::createTables(sq);
+            Settings::createTables(sq);
         }
         return true;
     }
@@ -109,9 +159,26 @@ bool connect(QString database_file)
 
 int main(int argc, char *argv[])
 {
+    // Startup phases are timed from here
+    StartupProfiler::instance();
+
     QApplication a(argc, argv);
     a.setApplicationName("SoftProjector");
 
+    // --startup-log [file] writes the startup phases, by default to startup.log
+    // next to the database
+    QString startupLog;
+    bool logStartup = false;
+    QStringList args = a.arguments();
+    int logArg = args.indexOf("--startup-log");
+    if(logArg > 0)
+    {
+        logStartup = true;
+        if(logArg+1 < args.count() && !args.at(logArg+1).startsWith("--"))
+            startupLog = args.at(logArg+1);
+    }
+    qmlRegisterType<SpTextLayer>("SoftProjector",1,0,"TextLayer");
+
     QPixmap pixmap(":icons/icons/splash.png");
     QSplashScreen splash(pixmap);
     splash.setMask(pixmap.mask());
@@ -284,7 +351,12 @@ int main(int argc, char *argv[])
     }
 #endif
 
+    if(logStartup)
+        StartupProfiler::instance()->setLogFile(startupLog.isEmpty() ? database_dir + "startup.log" : startupLog);
+
     // Try to connect to database
+    StartupProfiler *profiler = StartupProfiler::instance();
+    qint64 phaseStart = profiler->elapsed();
     if( !connect(database_dir) )
     {
         QMessageBox mb;
@@ -301,6 +373,8 @@ int main(int argc, char *argv[])
     sq.exec("PRAGMA user_version");
     sq.first();
     int dbVersion = sq.value(0).toInt();
+    if(dbVersion < dbVer && dbVersion >= 2)
+        upgradeDatabase(dbVersion);
     if(dbVer != dbVersion)
     {
         QString errortxt = QString("SoftProjector requires database vesion # %1\n"
@@ -319,9 +393,22 @@ int main(int argc, char *argv[])
     }
     // Database is of correct version
 
+    // Move image data written in place by imports or older versions into Assets
+    AssetStore::instance()->convertBlobs();
+    Settings::upgradeSections();
+    profiler->record("database",phaseStart,profiler->elapsed()-phaseStart);
+
+    phaseStart = profiler->elapsed();
     SoftProjector w;
     w.setAppDataDir(QDir(database_dir));
+    w.recoverSchedule();
     w.show();
     splash.finish(&w);
-    return a.exec();
+    profiler->record("main window",phaseStart,profiler->elapsed()-phaseStart);
+    QTimer::singleShot(0,&w,SLOT(startupFinished()));
+    int ret = a.exec();
+
+    // Let queued database work finish before the connections go away
+    DbService::instance()->waitForDone();
+    return ret;
 }
@@ -19,6 +19,66 @@
 
 #include "../headers/managedatadialog.hpp"
 #include "ui_managedatadialog.h"
+#include "../headers/assetstore.hpp"
+#include "../headers/dbservice.hpp"
+
+static QString databaseStats(QSqlQuery &sq, const QString &path)
+{
+    // File size and page use of the main database, including its WAL file
+    sq.exec("PRAGMA page_count");
+    sq.first();
+    qint64 pages = sq.value(0).toLongLong();
+    sq.exec("PRAGMA page_size");
+    sq.first();
+    qint64 pageSize = sq.value(0).toLongLong();
+    sq.exec("PRAGMA freelist_count");
+    sq.first();
+    qint64 freePages = sq.value(0).toLongLong();
+    qint64 size = QFileInfo(path).size() + QFileInfo(path + "-wal").size();
+    return ManageDataDialog::tr("%1 MB on disk, %2 pages of %3 bytes, %4 free pages")
+            .arg(size/1048576.0,0,'f',1).arg(pages).arg(pageSize).arg(freePages);
+}
+
+static QString maintainDatabase()
+{
+    // Runs on a database thread with its own connection
+    QElapsedTimer timer;
+    timer.start();
+    QSqlDatabase db = DbService::instance()->database();
+    QString path = db.databaseName();
+    QSqlQuery sq(db);
+    QStringList report;
+    report << ManageDataDialog::tr("Before: %1").arg(databaseStats(sq,path));
+
+    QStringList problems;
+    sq.exec("PRAGMA integrity_check(20)");
+    while(sq.next())
+        problems << sq.value(0).toString();
+    if(problems == QStringList("ok"))
+        report << ManageDataDialog::tr("Integrity check: no problems found");
+    else
+        report << ManageDataDialog::tr("Integrity check found problems:\n%1").arg(problems.join("\n"));
+
+    // Databases created before incremental vacuum was turned on are converted once
+    sq.exec("PRAGMA auto_vacuum");
+    sq.first();
+    if(sq.value(0).toInt() != 2)
+    {
+        sq.exec("PRAGMA auto_vacuum = INCREMENTAL");
+        if(!sq.exec("VACUUM"))
+            report << ManageDataDialog::tr("Vacuum failed: %1").arg(sq.lastError().text());
+    }
+    else
+        sq.exec("PRAGMA incremental_vacuum");
+
+    sq.exec("REINDEX");
+    sq.exec("ANALYZE");
+    sq.exec("PRAGMA wal_checkpoint(TRUNCATE)");
+
+    report << ManageDataDialog::tr("After: %1").arg(databaseStats(sq,path));
+    report << ManageDataDialog::tr("Done in %1 seconds").arg(timer.elapsed()/1000.0,0,'f',1);
+    return report.join("\n\n");
+}
 
 using namespace Qt::StringLiterals;
 
@@ -32,6 +92,9 @@ ManageDataDialog::ManageDataDialog(QWidget *parent) :
 {
     ui->setupUi(this);
 
+    maintainWatcher = new QFutureWatcher<QString>(this);
+    connect(maintainWatcher,SIGNAL(finished()),this,SLOT(maintainFinished()));
+
     // Set tables
     bible_model = new BiblesModel;
     songbook_model = new SongbooksModel;
@@ -767,7 +830,7 @@ void ManageDataDialog::exportSongbook(QString path)
                 q.addBindValue(sq.record().value("ending_font"));
                 q.addBindValue(sq.record().value("use_background"));
                 q.addBindValue(sq.record().value("background_name"));
-                q.addBindValue(sq.record().value("background"));
+                q.addBindValue(AssetStore::instance()->data(sq.record().value("background")));
                 q.addBindValue(sq.record().value("count"));
                 q.addBindValue(sq.record().value("date"));
                 q.exec();
@@ -839,6 +902,27 @@ void ManageDataDialog::on_ok_pushButton_clicked()
     close();
 }
 
+void ManageDataDialog::on_maintain_pushButton_clicked()
+{
+    // Maintenance runs in the background, the rest of the program stays usable
+    ui->maintain_pushButton->setEnabled(false);
+    ui->maintain_pushButton->setText(tr("Maintaining..."));
+    maintainWatcher->setFuture(DbService::instance()->run(maintainDatabase));
+}
+
+void ManageDataDialog::maintainFinished()
+{
+    ui->maintain_pushButton->setEnabled(true);
+    ui->maintain_pushButton->setText(tr("Maintain Database"));
+
+    QMessageBox mb(this);
+    mb.setWindowTitle(tr("Maintain Database"));
+    mb.setText(maintainWatcher->result());
+    mb.setIcon(QMessageBox::Information);
+    mb.setStandardButtons(QMessageBox::Ok);
+    mb.exec();
+}
+
 void ManageDataDialog::on_import_bible_pushButton_clicked()
 {
     QString file_path = QFileDialog::getOpenFileName(this,
@@ -1689,7 +1773,7 @@ void ManageDataDialog::transferThemeAnnounce(QSqlQuery &sqf, QSqlQuery &sqt, int
         sqt.bindValue(":uu",sqf.record().value("use_blur_shadow"));
         sqt.bindValue(":ub",sqf.record().value("use_background"));
         sqt.bindValue(":bn",sqf.record().value("background_name"));
-        sqt.bindValue(":ba",sqf.record().value("background"));
+        sqt.bindValue(":ba",AssetStore::instance()->data(sqf.record().value("background")));
         sqt.bindValue(":tf",sqf.record().value("text_font"));
         sqt.bindValue(":tc",sqf.record().value("text_color"));
         sqt.bindValue(":av",sqf.record().value("text_align_v"));
@@ -1720,7 +1804,7 @@ void ManageDataDialog::transferThemeBible(QSqlQuery &sqf, QSqlQuery &sqt, int tm
         sqt.bindValue(":uu",sqf.record().value("use_blur_shadow"));
         sqt.bindValue(":ub",sqf.record().value("use_background"));
         sqt.bindValue(":bn",sqf.record().value("background_name"));
-        sqt.bindValue(":ba",sqf.record().value("background"));
+        sqt.bindValue(":ba",AssetStore::instance()->data(sqf.record().value("background")));
         sqt.bindValue(":tf",sqf.record().value("text_font"));
         sqt.bindValue(":tc",sqf.record().value("text_color"));
         sqt.bindValue(":av",sqf.record().value("text_align_v"));
@@ -1754,7 +1838,7 @@ void ManageDataDialog::transferThemePassive(QSqlQuery &sqf, QSqlQuery &sqt, int
         sqt.bindValue(":di",sqf.record().value("disp"));
         sqt.bindValue(":ub",sqf.record().value("use_background"));
         sqt.bindValue(":bn",sqf.record().value("background_name"));
-        sqt.bindValue(":ba",sqf.record().value("background"));
+        sqt.bindValue(":ba",AssetStore::instance()->data(sqf.record().value("background")));
         sqt.bindValue(":ud",sqf.record().value("use_disp_1"));
         sqt.exec();
     }
@@ -1792,7 +1876,7 @@ void ManageDataDialog::transferThemeSong(QSqlQuery &sqf, QSqlQuery &sqt, int tmI
         sqt.bindValue(":ep",sqf.record().value("ending_position"));
         sqt.bindValue(":ub",sqf.record().value("use_background"));
         sqt.bindValue(":bn",sqf.record().value("background_name"));
-        sqt.bindValue(":ba",sqf.record().value("background"));
+        sqt.bindValue(":ba",AssetStore::instance()->data(sqf.record().value("background")));
         sqt.bindValue(":tf",sqf.record().value("text_font"));
         sqt.bindValue(":tc",sqf.record().value("text_color"));
         sqt.bindValue(":av",sqf.record().value("text_align_v"));
@@ -0,0 +1,357 @@
+/***************************************************************************
+//
+//    softProjector - an open source media projection software
+//    Copyright (C) 2017  Vladislav Kobzar
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation version 3 of the License.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+***************************************************************************/
+
+#include <QCoreApplication>
+#include <QMediaFormat>
+#include <QMediaMetaData>
+#include <QTime>
+#include "../headers/mediacatalog.hpp"
+#include "../headers/spfunctions.hpp"
+#include "../headers/dbservice.hpp"
+#include "../headers/startupprofiler.hpp"
+
+static QString localFile(const QString &path)
+{
+    // Library paths are usually plain file paths, older entries may be urls
+    if(path.startsWith("file:"))
+        return QUrl(path).toLocalFile();
+    return path;
+}
+
+MediaInfo::MediaInfo()
+{
+    modified = 0;
+    duration = 0;
+    frameRate = 0;
+    audioBitRate = 0;
+    hasVideo = false;
+    hasAudio = false;
+    isValid = false;
+}
+
+QString MediaInfo::describe() const
+{
+    if(!isValid)
+        return QString();
+
+    QString font = "<font color=#49fff9>";
+    QString info;
+    if(duration > 0)
+        info += QObject::tr("Duration: ") + font
+                + QTime(0,0).addMSecs(duration).toString(duration >= 3600000 ? "h:mm:ss" : "m:ss")
+                + "<br></font>";
+    if(hasVideo)
+    {
+        QString video;
+        if(!resolution.isEmpty())
+            video = QString("%1x%2").arg(resolution.width()).arg(resolution.height());
+        if(frameRate > 0)
+            video += QString(" %1 fps").arg(frameRate,0,'f',2);
+        if(!videoCodec.isEmpty())
+            video += " " + videoCodec;
+        info += QObject::tr("Video: ") + font + video.trimmed() + "<br></font>";
+    }
+    if(hasAudio)
+    {
+        QString audio = audioCodec;
+        if(audioBitRate > 0)
+            audio += QString(" %1kbit").arg(audioBitRate/1000);
+        info += QObject::tr("Audio: ") + font + audio.trimmed() + "<br></font>";
+    }
+    return info;
+}
+
+MediaProber::MediaProber()
+{
+    m_player = NULL;
+    m_sink = NULL;
+    m_timeout = NULL;
+    m_busy = false;
+    m_seeking = false;
+}
+
+void MediaProber::probe(const QString &path, qint64 modified)
+{
+    if(!m_player)
+    {
+        // Created here so that they belong to the catalog thread
+        m_player = new QMediaPlayer(this);
+        m_sink = new QVideoSink(this);
+        m_player->setVideoSink(m_sink);
+        m_timeout = new QTimer(this);
+        m_timeout->setSingleShot(true);
+        m_timeout->setInterval(10000);
+        connect(m_player,SIGNAL(mediaStatusChanged(QMediaPlayer::MediaStatus)),
+                this,SLOT(statusChanged(QMediaPlayer::MediaStatus)));
+        connect(m_sink,SIGNAL(videoFrameChanged(QVideoFrame)),this,SLOT(frameChanged(QVideoFrame)));
+        connect(m_timeout,SIGNAL(timeout()),this,SLOT(timedOut()));
+    }
+
+    m_queue.append(qMakePair(path,modified));
+    if(!m_busy)
+        next();
+}
+
+void MediaProber::next()
+{
+    while(!m_queue.isEmpty())
+    {
+        QPair<QString,qint64> p = m_queue.takeFirst();
+        QFileInfo fi(localFile(p.first));
+        qint64 modified = fi.exists() ? fi.lastModified().toMSecsSinceEpoch() : 0;
+        if(modified == p.second)
+            continue; // catalog entry is up to date
+
+        m_info = MediaInfo();
+        m_info.path = p.first;
+        m_info.modified = modified;
+        if(!fi.exists())
+        {
+            emit probed(m_info);
+            continue;
+        }
+
+        m_busy = true;
+        m_seeking = false;
+        m_player->setSource(QUrl::fromLocalFile(fi.absoluteFilePath()));
+        m_timeout->start();
+        return;
+    }
+}
+
+void MediaProber::statusChanged(QMediaPlayer::MediaStatus status)
+{
+    if(!m_busy)
+        return;
+    if(status == QMediaPlayer::InvalidMedia)
+    {
+        finish();
+        return;
+    }
+    if(status != QMediaPlayer::LoadedMedia || m_seeking)
+        return;
+
+    QMediaMetaData md = m_player->metaData();
+    m_info.isValid = true;
+    m_info.duration = m_player->duration();
+    m_info.hasVideo = m_player->hasVideo();
+    m_info.hasAudio = m_player->hasAudio();
+    m_info.resolution = md.value(QMediaMetaData::Resolution).toSize();
+    m_info.frameRate = md.value(QMediaMetaData::VideoFrameRate).toReal();
+    m_info.audioBitRate = md.value(QMediaMetaData::AudioBitRate).toInt();
+    QVariant codec = md.value(QMediaMetaData::VideoCodec);
+    if(codec.isValid())
+        m_info.videoCodec = QMediaFormat::videoCodecName(codec.value<QMediaFormat::VideoCodec>());
+    codec = md.value(QMediaMetaData::AudioCodec);
+    if(codec.isValid())
+        m_info.audioCodec = QMediaFormat::audioCodecName(codec.value<QMediaFormat::AudioCodec>());
+
+    QVariant art = md.value(QMediaMetaData::ThumbnailImage);
+    if(!art.isValid())
+        art = md.value(QMediaMetaData::CoverArtImage);
+    if(art.isValid())
+        m_info.poster = art.value<QImage>();
+
+    if(!m_info.hasVideo)
+    {
+        finish();
+        return;
+    }
+
+    // Run the video for a moment, a little past the start where it is often black.
+    // There is no audio output, so nothing is heard.
+    m_seeking = true;
+    m_player->setPosition(qMin<qint64>(m_info.duration/10,5000));
+    m_player->play();
+}
+
+void MediaProber::frameChanged(const QVideoFrame &frame)
+{
+    if(!m_busy || !m_seeking || !frame.isValid())
+        return;
+    QImage img = frame.toImage();
+    if(img.isNull())
+        return;
+    m_info.poster = img;
+    finish();
+}
+
+void MediaProber::timedOut()
+{
+    // Nothing could be read in time, the disk or the media backend may just be busy.
+    // Stored without the modification time, the file is probed again on the next scan.
+    if(m_busy && !m_info.isValid)
+        m_info.modified = 0;
+    finish();
+}
+
+void MediaProber::finish()
+{
+    if(!m_busy)
+        return;
+    m_busy = false;
+    m_seeking = false;
+    m_timeout->stop();
+    m_player->stop();
+    m_player->setSource(QUrl());
+
+    if(!m_info.poster.isNull())
+        m_info.poster = m_info.poster.scaled(160,90,Qt::KeepAspectRatio,Qt::SmoothTransformation);
+    emit probed(m_info);
+    next();
+}
+
+MediaCatalog *MediaCatalog::instance()
+{
+    static MediaCatalog catalog;
+    return &catalog;
+}
+
+MediaCatalog::MediaCatalog()
+{
+    qRegisterMetaType<MediaInfo>();
+    m_prober = new MediaProber;
+    m_prober->moveToThread(&m_thread);
+    connect(&m_thread,SIGNAL(finished()),m_prober,SLOT(deleteLater()));
+    connect(m_prober,SIGNAL(probed(MediaInfo)),this,SLOT(save(MediaInfo)));
+    connect(qApp,SIGNAL(aboutToQuit()),this,SLOT(stop()));
+}
+
+void MediaCatalog::createTables(QSqlQuery &sq)
+{
+    sq.exec("CREATE TABLE IF NOT EXISTS 'MediaCatalog' ('path' TEXT PRIMARY KEY, 'modified' INTEGER, "
+            "'duration' INTEGER, 'width' INTEGER, 'height' INTEGER, 'frame_rate' REAL, "
+            "'video_codec' TEXT, 'audio_codec' TEXT, 'audio_bitrate' INTEGER, "
+            "'has_video' BOOL, 'has_audio' BOOL, 'is_valid' BOOL, 'poster' BLOB)");
+}
+
+static QHash<QString,MediaInfo> readInfos(QSqlDatabase db)
+{
+    QHash<QString,MediaInfo> infos;
+    QSqlQuery sq(db);
+    sq.exec("SELECT path, modified, duration, width, height, frame_rate, video_codec, audio_codec, "
+            "audio_bitrate, has_video, has_audio, is_valid, poster FROM MediaCatalog");
+    while(sq.next())
+    {
+        MediaInfo mi;
+        mi.path = sq.value(0).toString();
+        mi.modified = sq.value(1).toLongLong();
+        mi.duration = sq.value(2).toLongLong();
+        mi.resolution = QSize(sq.value(3).toInt(),sq.value(4).toInt());
+        mi.frameRate = sq.value(5).toReal();
+        mi.videoCodec = sq.value(6).toString();
+        mi.audioCodec = sq.value(7).toString();
+        mi.audioBitRate = sq.value(8).toInt();
+        mi.hasVideo = sq.value(9).toBool();
+        mi.hasAudio = sq.value(10).toBool();
+        mi.isValid = sq.value(11).toBool();
+        mi.poster.loadFromData(sq.value(12).toByteArray());
+        infos.insert(mi.path,mi);
+    }
+    return infos;
+}
+
+static QHash<QString,MediaInfo> preloadInfos()
+{
+    StartupPhase phase("media catalog (read)");
+    return readInfos(DbService::instance()->database());
+}
+
+void MediaCatalog::preload()
+{
+    // Reads the catalog and decodes the posters on a database thread, load() picks them up
+    if(!m_preloaded.isValid())
+        m_preloaded = DbService::instance()->run(preloadInfos);
+}
+
+void MediaCatalog::load()
+{
+    if(m_preloaded.isValid())
+    {
+        m_infos = m_preloaded.result();
+        m_preloaded = QFuture<QHash<QString,MediaInfo> >();
+    }
+    else
+        m_infos = readInfos(QSqlDatabase::database());
+}
+
+MediaInfo MediaCatalog::info(const QString &path) const
+{
+    return m_infos.value(path);
+}
+
+void MediaCatalog::probe(const QStringList &paths)
+{
+    // The prober compares modification times, so files are only read when needed
+    if(!m_thread.isRunning())
+        m_thread.start(QThread::LowPriority);
+    foreach(const QString &path, paths)
+        QMetaObject::invokeMethod(m_prober,"probe",Qt::QueuedConnection,
+                                  Q_ARG(QString,path),Q_ARG(qint64,m_infos.value(path).modified));
+}
+
+void MediaCatalog::remove(const QString &path)
+{
+    m_infos.remove(path);
+    QSqlQuery sq;
+    sq.prepare("DELETE FROM MediaCatalog WHERE path = ?");
+    sq.addBindValue(path);
+    sq.exec();
+}
+
+static void writeInfo(MediaInfo info)
+{
+    QSqlQuery sq = DbService::instance()->prepare(
+                "INSERT OR REPLACE INTO MediaCatalog (path, modified, duration, width, height, frame_rate, "
+                "video_codec, audio_codec, audio_bitrate, has_video, has_audio, is_valid, poster) "
+                "VALUES (?,?,?,?,?,?,?,?,?,?,?,?,?)");
+    sq.addBindValue(info.path);
+    sq.addBindValue(info.modified);
+    sq.addBindValue(info.duration);
+    sq.addBindValue(info.resolution.width());
+    sq.addBindValue(info.resolution.height());
+    sq.addBindValue(info.frameRate);
+    sq.addBindValue(info.videoCodec);
+    sq.addBindValue(info.audioCodec);
+    sq.addBindValue(info.audioBitRate);
+    sq.addBindValue(info.hasVideo);
+    sq.addBindValue(info.hasAudio);
+    sq.addBindValue(info.isValid);
+    if(info.poster.isNull())
+        sq.addBindValue(QVariant(QMetaType::fromType<QByteArray>()));
+    else
+        sq.addBindValue(imageToByte(info.poster,ImageThumbnail));
+    sq.exec();
+    sq.finish();
+}
+
+void MediaCatalog::save(const MediaInfo &info)
+{
+    // Poster encoding and writing are done on a database thread
+    DbService::instance()->run(writeInfo,info);
+
+    m_infos.insert(info.path,info);
+    emit infoChanged(info.path);
+}
+
+void MediaCatalog::stop()
+{
+    m_thread.quit();
+    m_thread.wait();
+}
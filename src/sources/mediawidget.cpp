@@ -94,6 +94,7 @@ MediaWidget::MediaWidget(QWidget *parent) :
 
     audioExt = "*.mp3 *.acc *.ogg *.oga *.wma *.wav *.asf *.mka";
     videoExt = "*.wmv *.avi *.mkv *.flv *.mp4 *.mpg *.mpeg *.mov *.ogv *.ts";
+    connect(MediaCatalog::instance(),SIGNAL(infoChanged(QString)),this,SLOT(updateCatalogInfo(QString)));
     loadMediaLibrary();
 }
 
@@ -121,15 +122,56 @@ void MediaWidget::changeEvent(QEvent *e)
 
 void MediaWidget::loadMediaLibrary()
 {
+    // The list is filled from the catalog, files that are new or have changed
+    // since they were last probed are read again in the background
+    MediaCatalog::instance()->load();
+    QStringList paths;
     QSqlQuery sq;
     sq.exec("SELECT * FROM Media");
     while(sq.next())
     {
         mediaFilePaths.append(sq.value(0).toString());
         mediaFileNames.append(sq.value(1).toString());
-        ui->listWidgetMediaFiles->clear();
-        ui->listWidgetMediaFiles->addItems(mediaFileNames);
+        paths.append(sq.value(0).toString());
+        addLibraryItem(sq.value(0).toString(),sq.value(1).toString());
     }
+    MediaCatalog::instance()->probe(paths);
+}
+
+void MediaWidget::addLibraryItem(const QString &path, const QString &name)
+{
+    QListWidgetItem *itm = new QListWidgetItem(name);
+    itm->setData(Qt::UserRole,path);
+    updateLibraryItem(itm);
+    ui->listWidgetMediaFiles->addItem(itm);
+}
+
+void MediaWidget::updateLibraryItem(QListWidgetItem *itm)
+{
+    MediaInfo mi = MediaCatalog::instance()->info(itm->data(Qt::UserRole).toString());
+    if(!mi.poster.isNull())
+        itm->setIcon(QIcon(QPixmap::fromImage(mi.poster)));
+    QString info = mi.describe();
+    if(!info.isEmpty())
+        itm->setToolTip(info);
+}
+
+void MediaWidget::updateCatalogInfo(const QString &path)
+{
+    for(int i(0);i<ui->listWidgetMediaFiles->count();++i)
+    {
+        QListWidgetItem *itm = ui->listWidgetMediaFiles->item(i);
+        if(itm->data(Qt::UserRole).toString() == path)
+            updateLibraryItem(itm);
+    }
+}
+
+QString MediaWidget::catalogInfo()
+{
+    QListWidgetItem *itm = ui->listWidgetMediaFiles->currentItem();
+    if(!itm)
+        return QString();
+    return MediaCatalog::instance()->info(itm->data(Qt::UserRole).toString()).describe();
 }
 
 void MediaWidget::statusChanged(QMediaPlayer::MediaStatus status)
@@ -138,8 +180,8 @@ void MediaWidget::statusChanged(QMediaPlayer::MediaStatus status)
     switch (status) {
     case QMediaPlayer::BufferingMedia:
     case QMediaPlayer::LoadingMedia:
-        ui->labelInfo->setText(QString("<center><strong><font color=#49fff9>%1</font>")
-                               .arg(tr("Loading...")));
+        ui->labelInfo->setText(QString("<center><strong><font color=#49fff9>%1</font></strong></center>%2")
+                               .arg(tr("Loading...")).arg(catalogInfo()));
         break;
     case QMediaPlayer::StalledMedia:
         ui->labelInfo->setText(QString("<center><strong><font color=#49fff9>%1</font>")
@@ -287,9 +329,9 @@ void MediaWidget::updateInfo()
 
     QString bitrate;
     if (tBitrate != 0)
-        bitrate = "Bitrate: " + font + QString::number(tBitrate/1000) + "kbit</font>";
+        bitrate = "Bitrate: " + font + QString::number(tBitrate/1000) + "kbit<br></font>";
 
-    ui->labelInfo->setText(file + album + title + artist + bitrate);
+    ui->labelInfo->setText(file + album + title + artist + bitrate + catalogInfo());
 
 }
 
@@ -303,8 +345,9 @@ void MediaWidget::insertFiles(QStringList &files)
         mediaFileNames.append(f.fileName());
         mediaFilePaths.append(QUrl::fromLocalFile(file));
         sq.exec(QString("INSERT INTO Media (long_Path, short_path) VALUES('%1', '%2')").arg(file).arg(f.fileName()));
-        ui->listWidgetMediaFiles->addItem(f.fileName());
+        addLibraryItem(file,f.fileName());
     }
+    MediaCatalog::instance()->probe(files);
 }
 
 void MediaWidget::hasVideoChanged(bool bHasVideo)
@@ -353,13 +396,12 @@ void MediaWidget::removeFromLibrary()
     {
         QSqlQuery sq;
         sq.exec("DELETE FROM Media WHERE short_path = '" +mediaFileNames.at(cm)+ "'");
+        MediaCatalog::instance()->remove(ui->listWidgetMediaFiles->item(cm)->data(Qt::UserRole).toString());
         mediaFilePaths.removeAt(cm);
         mediaFileNames.removeAt(cm);
 
         ui->listWidgetMediaFiles->setCurrentRow(-1);
-        ui->listWidgetMediaFiles->clear();
-        if(mediaFileNames.count()>0)
-            ui->listWidgetMediaFiles->addItems(mediaFileNames);
+        delete ui->listWidgetMediaFiles->takeItem(cm);
         player->stop();
 
         hasVideoChanged(false);
@@ -19,6 +19,7 @@
 
 #include "../headers/passivesettingwidget.hpp"
 #include "ui_passivesettingwidget.h"
+#include "../headers/assetstore.hpp"
 
 PassiveSettingWidget::PassiveSettingWidget(QWidget *parent) :
     QWidget(parent),
@@ -124,7 +125,7 @@ void PassiveSettingWidget::on_buttonBrowseBackgound_clicked()
                                                     ".", tr("Images(%1)").arg(getSupportedImageFormats()));
     if(!filename.isNull())
     {
-        QPixmap p(filename);
+        QPixmap p = AssetStore::instance()->loadFile(filename);
         mySettings.backgroundPix = p;
         QFileInfo fi(filename);
         filename = fi.fileName();
@@ -154,7 +155,7 @@ void PassiveSettingWidget::on_buttonBrowseBackgound2_clicked()
                                                     ".", tr("Images(%1)").arg(getSupportedImageFormats()));
     if(!filename.isNull())
     {
-        QPixmap p(filename);
+        QPixmap p = AssetStore::instance()->loadFile(filename);
         mySettings2.backgroundPix = p;
         QFileInfo fi(filename);
         filename = fi.fileName();
@@ -169,7 +170,7 @@ void PassiveSettingWidget::on_buttonBrowseBackgound3_clicked()
                                                     ".", tr("Images(%1)").arg(getSupportedImageFormats()));
     if(!filename.isNull())
     {
-        QPixmap p(filename);
+        QPixmap p = AssetStore::instance()->loadFile(filename);
         mySettings3.backgroundPix = p;
         QFileInfo fi(filename);
         filename = fi.fileName();
@@ -184,7 +185,7 @@ void PassiveSettingWidget::on_buttonBrowseBackgound4_clicked()
                                                     ".", tr("Images(%1)").arg(getSupportedImageFormats()));
     if(!filename.isNull())
     {
-        QPixmap p(filename);
+        QPixmap p = AssetStore::instance()->loadFile(filename);
         mySettings4.backgroundPix = p;
         QFileInfo fi(filename);
         filename = fi.fileName();
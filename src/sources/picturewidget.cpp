@@ -25,6 +25,7 @@ PictureWidget::PictureWidget(QWidget *parent) :
     ui(new Ui::PictureWidget)
 {
     ui->setupUi(this);
+    ui->listWidgetSlides->setItemDelegate(new SlideIconDelegate(ui->listWidgetSlides));
     loadSlideShows();
     ui->pushButtonGoLive->setEnabled(false);
 }
@@ -71,13 +72,11 @@ void PictureWidget::on_listWidgetSlides_currentRowChanged(int currentRow)
 {
     if(currentRow>=0)
     {
-        int pw,ph;
-        pw = slides.at(currentRow).imagePreview.width();
-        ph = slides.at(currentRow).imagePreview.height();
-        if(pw>300 || ph>200)
-            ui->labelPreview->setPixmap(slides.at(currentRow).imagePreview.scaled(300,200,Qt::KeepAspectRatio));
+        QPixmap preview = slides.at(currentRow).getImagePreview();
+        if(preview.width()>300 || preview.height()>200)
+            ui->labelPreview->setPixmap(preview.scaled(300,200,Qt::KeepAspectRatio));
         else
-            ui->labelPreview->setPixmap(slides.at(currentRow).imagePreview);
+            ui->labelPreview->setPixmap(preview);
         ui->labelPixInfo->setText(tr("Preview slide: ")+slides.at(currentRow).name);
     }
 }
@@ -94,58 +93,14 @@ void PictureWidget::on_pushButtonAddImages_clicked()
 
     if(imageFilePaths.count()>0)
     {
-        this->setCursor(Qt::WaitCursor);
-        int i(0);
-        QProgressDialog progress(tr("Adding files..."), tr("Cancel"), 0, imageFilePaths.count(), this);
+        QList<SlideShowItem> imported = importSlides(imageFilePaths,mySettings,tr("Adding files..."),this);
         ui->listWidgetSlides->setIconSize(QSize(100,100));
-        foreach(const QString &file, imageFilePaths)
+        foreach(const SlideShowItem &sd, imported)
         {
-            ++i;
-            progress.setValue(i);
-
-            QPixmap img;
-            SlideShowItem sd;
-            img.load(file);
-
-            // set display image. If to resize, resize them
-            if(mySettings.resize)
-            {
-                if(img.width()>mySettings.boundWidth || img.height()>mySettings.boundWidth )
-                    sd.image = img.scaled(mySettings.boundWidth ,mySettings.boundWidth , Qt::KeepAspectRatio);
-                else
-                    sd.image = img;
-            }
-            else
-                sd.image = img;
-
-            // set preview image
-            if(img.width()>400 || img.height()>400)
-                sd.imagePreview = img.scaled(400,400, Qt::KeepAspectRatio);
-            else
-                sd.imagePreview = img;
-
-            // set list image
-            if(img.width()>100 || img.height()>100)
-                sd.imageSmall = img.scaled(100,100, Qt::KeepAspectRatio);
-            else
-                sd.imageSmall = img;
-
-            // set file name
-            QFileInfo f(file);
-            sd.name = f.fileName();
-            sd.path = f.filePath();
-
-            // add to slideshow
+            // add to slideshow and to slide show list
             slides.append(sd);
-
-            // add to slide show list
-            QListWidgetItem *itm = new QListWidgetItem;
-            QIcon ico(sd.imageSmall);
-
-            itm->setIcon(ico);
-            ui->listWidgetSlides->addItem(itm);
+            ui->listWidgetSlides->addItem(sd.createListItem());
         }
-        this->setCursor(Qt::ArrowCursor);
         ui->pushButtonGoLive->setEnabled(true);
     }
 }
@@ -159,9 +114,7 @@ void PictureWidget::on_pushButtonRemoveImage_clicked()
         ui->listWidgetSlides->clear();
         foreach(const SlideShowItem &sst, slides)
         {
-            QListWidgetItem *itm = new QListWidgetItem;
-            QIcon ico(sst.imageSmall);
-            itm->setIcon(ico);
+            QListWidgetItem *itm = sst.createListItem();
             ui->listWidgetSlides->addItem(itm);
         }
         ui->listWidgetSlides->setCurrentRow(c);
@@ -191,9 +144,7 @@ void PictureWidget::on_pushButtonMoveUp_clicked()
         ui->listWidgetSlides->clear();
         foreach(const SlideShowItem &sst, slides)
         {
-            QListWidgetItem *itm = new QListWidgetItem;
-            QIcon ico(sst.imageSmall);
-            itm->setIcon(ico);
+            QListWidgetItem *itm = sst.createListItem();
             ui->listWidgetSlides->addItem(itm);
         }
         ui->listWidgetSlides->setCurrentRow(u);
@@ -210,9 +161,7 @@ void PictureWidget::on_pushButtonMoveDown_clicked()
         ui->listWidgetSlides->clear();
         foreach(const SlideShowItem &sst, slides)
         {
-            QListWidgetItem *itm = new QListWidgetItem;
-            QIcon ico(sst.imageSmall);
-            itm->setIcon(ico);
+            QListWidgetItem *itm = sst.createListItem();
             ui->listWidgetSlides->addItem(itm);
         }
         ui->listWidgetSlides->setCurrentRow(d);
@@ -246,9 +195,7 @@ void PictureWidget::sendToPreview(SlideShow &sshow)
     foreach(const SlideShowItem &sst, currentSlideShow.slides)
     {
         slides.append(sst);
-        QListWidgetItem *itm = new QListWidgetItem;
-        QIcon ico(sst.imageSmall);
-        itm->setIcon(ico);
+        QListWidgetItem *itm = sst.createListItem();
         ui->listWidgetSlides->addItem(itm);
     }
     ui->listWidgetSlides->setCurrentRow(0);
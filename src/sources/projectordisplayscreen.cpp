@@ -18,9 +18,27 @@
 ***************************************************************************/
 
 #include "../3rdparty/headers/qmediaplaylist.h"
+#include <QtConcurrent>
 #include "../headers/projectordisplayscreen.hpp"
+#include "../headers/renderprofiler.hpp"
 #include "ui_projectordisplayscreen.h"
 
+static QImage scaleBackground(QImage image, QSize size, int fillMode)
+{
+    // fill mode -->>  0 = Strech, 1 = keep aspect, 2 = keep aspect by expanding
+    switch(fillMode)
+    {
+    case 0:
+        return image.scaled(size,Qt::IgnoreAspectRatio,Qt::SmoothTransformation);
+    case 1:
+        return image.scaled(size,Qt::KeepAspectRatio,Qt::SmoothTransformation);
+    case 2:
+        return image.scaled(size,Qt::KeepAspectRatioByExpanding,Qt::SmoothTransformation);
+    default:
+        return image;
+    }
+}
+
 
 ProjectorDisplayScreen::ProjectorDisplayScreen(QWidget *parent) :
     QWidget(parent),
@@ -46,9 +64,23 @@ ProjectorDisplayScreen::ProjectorDisplayScreen(QWidget *parent) :
     connect(dispObj,SIGNAL(playbackStateChanged(int)),this,SLOT(videoPlaybackStateChanged(int)));
     connect(dispObj,SIGNAL(playbackStopped()),this,SLOT(playbackStopped()));
 
-    backImSwitch1 = backImSwitch2 = textImSwitch1 = textImSwitch2 = false;
+    // Frames are delivered asynchronously, transitions wait until staged images are loaded
+    QStringList imageItems = QStringList() << "backImage1" << "backImage2" << "textImage1" << "textImage2";
+    foreach(const QString &name, imageItems)
+    {
+        QObject *item = dispObj->findChild<QObject*>(name);
+        if(item)
+            connect(item,SIGNAL(statusChanged(QQuickImageBase::Status)),this,SLOT(imageStatusChanged()));
+    }
+
     back1to2 = text1to2 = isNewBack = true;
+    transitionPending = false;
+    isStaged = false;
     m_color.setRgb(0,0,0,0);// = QColor(QColor::black());
+    renderCache = NULL;
+
+    // Keep enough scaled backgrounds for all theme items and a few slides, even on 4K
+    scaledBacks.setMaxCost(256*1024);
 }
 
 ProjectorDisplayScreen::~ProjectorDisplayScreen()
@@ -59,9 +91,16 @@ ProjectorDisplayScreen::~ProjectorDisplayScreen()
 
 void ProjectorDisplayScreen::resetImGenSize()
 {
+    if(imGen.getScreenSize() != this->size())
+        scaledBacks.clear();
     imGen.setScreenSize(this->size());
 }
 
+void ProjectorDisplayScreen::setRenderCache(RenderCache *cache)
+{
+    renderCache = cache;
+}
+
 void ProjectorDisplayScreen::setBackPixmap(QPixmap p, int fillMode)
 {
     // fill mode -->>  0 = Strech, 1 = keep aspect, 2 = keep aspect by expanding
@@ -74,65 +113,132 @@ void ProjectorDisplayScreen::setBackPixmap(QPixmap p, int fillMode)
     back = p;
     isNewBack = true;
 
-    switch(fillMode)
+    QImage im;
     {
-    case 0:
-        p = p.scaled(imGen.getScreenSize(),Qt::IgnoreAspectRatio,Qt::SmoothTransformation);
-        break;
-    case 1:
-        p = p.scaled(imGen.getScreenSize(),Qt::KeepAspectRatio,Qt::SmoothTransformation);
-        break;
-    case 2:
-        p = p.scaled(imGen.getScreenSize(),Qt::KeepAspectRatioByExpanding,Qt::SmoothTransformation);
-        break;
-    default:
-        // Do No Scaling/resizing
-        break;
+        RenderSpan span(RenderProfiler::BackgroundScale);
+        im = scaledBackground(p,fillMode);
     }
-
-    imProvider->setPixMap(p);
     back1to2 = (!back1to2);
 
-    QObject *item1 = dispView->rootObject()->findChild<QObject*>("backImage1");
-    QObject *item2 = dispView->rootObject()->findChild<QObject*>("backImage2");
-    if(item1 && item2)
+    QObject *item = dispView->rootObject()->findChild<QObject*>(back1to2 ? "backImage2" : "backImage1");
+    if(item)
     {
-        if(back1to2)
-        {
-            backImSwitch2 = (!backImSwitch2);
-            if(backImSwitch2)
-                item2->setProperty("source","image://improvider/imB2a");
-            else
-                item2->setProperty("source","image://improvider/imB2b");
-
-            if(p.height()<imGen.height())
-                item2->setProperty("y",(imGen.height()-p.height())/2);
-            else
-                item2->setProperty("y",0);
-            if(p.width()<imGen.width())
-                item2->setProperty("x",(imGen.width()-p.width())/2);
-            else
-                item2->setProperty("x",0);
-        }
+        setImageSource(item,back1to2 ? backId2 : backId1,im);
+
+        if(im.height()<imGen.height())
+            item->setProperty("y",(imGen.height()-im.height())/2);
         else
-        {
-            backImSwitch1 = (!backImSwitch1);
-            if(backImSwitch1)
-                item1->setProperty("source","image://improvider/imB1a");
-            else
-                item1->setProperty("source","image://improvider/imB1b");
-            if(p.height()<imGen.height())
-                item1->setProperty("y",(imGen.height()-p.height())/2);
-            else
-                item1->setProperty("y",0);
-            if(p.width()<imGen.width())
-                item1->setProperty("x",(imGen.width()-p.width())/2);
-            else
-                item1->setProperty("x",0);
-        }
+            item->setProperty("y",0);
+        if(im.width()<imGen.width())
+            item->setProperty("x",(imGen.width()-im.width())/2);
+        else
+            item->setProperty("x",0);
     }
 }
 
+void ProjectorDisplayScreen::setImageSource(QObject *item, QString &slotId, const QImage &image)
+{
+    // Every image item holds a reference to the frame it shows,
+    // the frame it showed before is released.
+    RenderSpan span(RenderProfiler::ImageUpload);
+    QString id = imProvider->addImage(image);
+    item->setProperty("source","image://improvider/" + id);
+    if(!slotId.isEmpty())
+        imProvider->release(slotId);
+    slotId = id;
+}
+
+QString ProjectorDisplayScreen::scaledBackgroundKey(const QPixmap &p, int fillMode)
+{
+    return QString("%1:%2x%3:%4").arg(p.cacheKey()).arg(imGen.width()).arg(imGen.height()).arg(fillMode);
+}
+
+QImage ProjectorDisplayScreen::scaledBackground(QPixmap p, int fillMode)
+{
+    if(fillMode < 0 || fillMode > 2 || p.isNull() || p.size() == imGen.getScreenSize())
+        return p.toImage(); // Do No Scaling/resizing
+
+    QString key = scaledBackgroundKey(p,fillMode);
+    if(QImage *sim = scaledBacks.object(key))
+        return *sim;
+
+    QImage im;
+    if(pendingBacks.contains(key))
+    {
+        // Already being scaled in the background, wait for it rather than scaling twice
+        QFutureWatcher<QImage> *w = pendingBacks.take(key);
+        w->disconnect(this);
+        w->waitForFinished();
+        im = w->result();
+        w->deleteLater();
+    }
+    else
+        im = scaleBackground(p.toImage(),imGen.getScreenSize(),fillMode);
+
+    scaledBacks.insert(key,new QImage(im),im.width()*im.height()*4/1024);
+    return im;
+}
+
+void ProjectorDisplayScreen::prescaleBackground(QPixmap p, int fillMode)
+{
+    // Scale a background that is likely to be shown on a worker thread,
+    // so that switching to it later does not need to scale it.
+    if(fillMode < 0 || fillMode > 2 || p.isNull() || p.size() == imGen.getScreenSize())
+        return;
+
+    QString key = scaledBackgroundKey(p,fillMode);
+    prescaledKeys.insert(key);
+    if(scaledBacks.contains(key) || pendingBacks.contains(key))
+        return;
+
+    QFutureWatcher<QImage> *w = new QFutureWatcher<QImage>(this);
+    w->setProperty("backKey",key);
+    connect(w,SIGNAL(finished()),this,SLOT(prescaleFinished()));
+    pendingBacks.insert(key,w);
+    w->setFuture(QtConcurrent::run(scaleBackground,p.toImage(),imGen.getScreenSize(),fillMode));
+}
+
+void ProjectorDisplayScreen::prescaleSlide(QPixmap slide, SlideShowSettings &ssSets)
+{
+    prescaleBackground(slide,slideFillMode(slide,ssSets));
+}
+
+int ProjectorDisplayScreen::backgroundCacheCost()
+{
+    // Memory used by scaled backgrounds, in KB
+    return scaledBacks.totalCost();
+}
+
+int ProjectorDisplayScreen::droppedPrescaled()
+{
+    // Backgrounds prescaled since clearPrescaled() that no longer fit in the cache
+    int dropped(0);
+    foreach(const QString &key, prescaledKeys)
+    {
+        if(!scaledBacks.contains(key) && !pendingBacks.contains(key))
+            ++dropped;
+    }
+    return dropped;
+}
+
+void ProjectorDisplayScreen::clearPrescaled()
+{
+    prescaledKeys.clear();
+}
+
+void ProjectorDisplayScreen::prescaleFinished()
+{
+    QFutureWatcher<QImage> *w = static_cast<QFutureWatcher<QImage>*>(sender());
+    QString key = w->property("backKey").toString();
+    pendingBacks.remove(key);
+    if(!scaledBacks.contains(key))
+    {
+        QImage im = w->result();
+        scaledBacks.insert(key,new QImage(im),im.width()*im.height()*4/1024);
+    }
+    w->deleteLater();
+}
+
 void ProjectorDisplayScreen::setBackPixmap(QPixmap p, QColor c)
 {
     if(backType == 0)
@@ -143,32 +249,20 @@ void ProjectorDisplayScreen::setBackPixmap(QPixmap p, QColor c)
         setBackPixmap(imGen.generateEmptyImage(),0);
 }
 
-void ProjectorDisplayScreen::setTextPixmap(QPixmap p)
+void ProjectorDisplayScreen::setTextImage(QImage image, TextFrame layer)
 {
-    imProvider->setPixMap(p);
     text1to2 = (!text1to2);
 
-    QObject *item1 = dispView->rootObject()->findChild<QObject*>("textImage1");
-    QObject *item2 = dispView->rootObject()->findChild<QObject*>("textImage2");
-    if(item1 && item2)
-    {
-        if(text1to2)
-        {
-            textImSwitch2 = (!textImSwitch2);
-            if(textImSwitch2)
-                item2->setProperty("source","image://improvider/imT2a");
-            else
-                item2->setProperty("source","image://improvider/imT2b");
-        }
-        else
-        {
-            textImSwitch1 = (!textImSwitch1);
-            if(textImSwitch1)
-                item1->setProperty("source","image://improvider/imT1a");
-            else
-                item1->setProperty("source","image://improvider/imT1b");
-        }
-    }
+    QObject *root = dispView->rootObject();
+    QObject *item = root->findChild<QObject*>(text1to2 ? "textImage2" : "textImage1");
+    if(item)
+        setImageSource(item,text1to2 ? textId2 : textId1,image);
+
+    // Scene graph text is drawn on top of the (then empty) text image,
+    // so it takes part in the same transitions
+    SpTextLayer *textLayer = root->findChild<SpTextLayer*>(text1to2 ? "textLayer2" : "textLayer1");
+    if(textLayer)
+        textLayer->setFrame(layer);
 }
 
 void ProjectorDisplayScreen::setBackVideo(QString path)
@@ -194,6 +288,50 @@ void ProjectorDisplayScreen::setVideoSource(QObject* playerObject, QUrl path)
 
 void ProjectorDisplayScreen::updateScreen()
 {
+    transitionRequested = RenderProfiler::now();
+    isStaged = false;
+    if(isStagedImageLoading())
+    {
+        transitionPending = true;
+        return;
+    }
+    transitionPending = false;
+    startTransitions();
+}
+
+bool ProjectorDisplayScreen::isStagedImageLoading()
+{
+    QObject *root = dispView->rootObject();
+    QObject *textItem = root->findChild<QObject*>(text1to2 ? "textImage2" : "textImage1");
+    QObject *backItem = root->findChild<QObject*>(back1to2 ? "backImage2" : "backImage1");
+
+    // 2 = Image.Loading
+    if(textItem && textItem->property("status").toInt() == 2)
+        return true;
+    if(isNewBack && backItem && backItem->property("status").toInt() == 2)
+        return true;
+    return false;
+}
+
+void ProjectorDisplayScreen::imageStatusChanged()
+{
+    if(transitionPending && !isStagedImageLoading())
+    {
+        transitionPending = false;
+        startTransitions();
+    }
+    else if(isStaged && !isStagedImageLoading())
+    {
+        // The slide waits for showStaged(), so that all screens switch together
+        emit stagedReady();
+    }
+}
+
+void ProjectorDisplayScreen::startTransitions()
+{
+    RenderProfiler::instance()->record(RenderProfiler::Transition,transitionRequested,
+                                       RenderProfiler::now()-transitionRequested);
+
     QObject *root = dispView->rootObject();
     QMetaObject::invokeMethod(root,"stopTransitions");
     //    QString tranType = "seq";
@@ -296,13 +434,13 @@ void ProjectorDisplayScreen::keyReleaseEvent(QKeyEvent *event)
 
 void ProjectorDisplayScreen::renderNotText()
 {
-    setTextPixmap(imGen.generateEmptyImage());
+    setTextImage(imGen.generateEmptyImage().toImage());
     updateScreen();
 }
 
 void ProjectorDisplayScreen::renderPassiveText(QPixmap &back, bool useBack)
 {
-    setTextPixmap(imGen.generateEmptyImage());
+    setTextImage(imGen.generateEmptyImage().toImage());
     if(useBack)
     {
         backType = B_PICTURE;
@@ -319,75 +457,44 @@ void ProjectorDisplayScreen::renderPassiveText(QPixmap &back, bool useBack)
 
 void ProjectorDisplayScreen::renderBibleText(Verse bVerse, BibleSettings &bSets)
 {
-    // TODO: This is temporary until database is fixed
-    if(bSets.useFading)
-    {
-        tranType = TR_FADE;
-    }
-    else
-    {
-        tranType = TR_NONE;
-    }
-
-    if(bSets.useBackground)
-    {
-        setBackPixmap(bSets.backgroundPix,0);
-        backType = B_PICTURE;
-    }
-    else
-    {
-        setBackPixmap(imGen.generateColorImage(m_color),0);
-        backType = B_NONE;
-    }
-
-    //tranType = bSets.transitionType;
-    //backType = bSets.backgroundType;
-    setTextPixmap(imGen.generateBibleImage(bVerse,bSets));
-    //setBackPixmap(bSets.backgroundPix,bSets.backgroundColor);
-    //if(backType ==2)
-    //{
-    //    setVideoSource(bSets.backgroundVideoPath);
-    //}
-
+    stageText(bSets,renderTextFrame(RenderJob(bVerse,bSets,imGen.getScreenSize())));
     updateScreen();
 }
 
 void ProjectorDisplayScreen::renderSongText(Stanza stanza, SongSettings &sSets)
 {
-    // TODO: This is temporary until database is fixed
-    if(sSets.useFading)
-    {
-        tranType = TR_FADE;
-    }
-    else
-    {
-        tranType = TR_NONE;
-    }
+    stageText(sSets,renderTextFrame(RenderJob(stanza,sSets,imGen.getScreenSize())));
+    updateScreen();
+}
 
-    if(sSets.useBackground)
-    {
-        setBackPixmap(sSets.backgroundPix,0);
-        backType = B_PICTURE;
-    }
+void ProjectorDisplayScreen::renderAnnounceText(AnnounceSlide announce, TextSettings &aSets)
+{
+    stageText(aSets,renderTextFrame(RenderJob(announce,aSets,imGen.getScreenSize())));
+    updateScreen();
+}
+
+TextFrame ProjectorDisplayScreen::renderTextFrame(const RenderJob &job)
+{
+    if(renderCache)
+        return renderCache->render(job);
     else
-    {
-        setBackPixmap(imGen.generateColorImage(m_color),0);
-        backType = B_NONE;
-    }
+        return job.render();
+}
 
-    setTextPixmap(imGen.generateSongImage(stanza,sSets));
-    //if(sSets.backgroundType == 1)
-    //    setBackPixmap(sSets.backgroundPix,0);
-    //else
-    //    setBackPixmap(imGen.generateColorImage(m_color),0);
-    //tranType = sSets.transitionType;
-    updateScreen();
+QSize ProjectorDisplayScreen::screenSize()
+{
+    return imGen.getScreenSize();
 }
 
-void ProjectorDisplayScreen::renderAnnounceText(AnnounceSlide announce, TextSettings &aSets)
+void ProjectorDisplayScreen::stageText(TextSettingsBase &sets, const TextFrame &text)
 {
+    // Loads new background and text into the hidden image items.
+    // Nothing is shown until showStaged() is called.
+    transitionRequested = RenderProfiler::now();
+    transitionPending = false;
+
     // TODO: This is temporary until database is fixed
-    if(aSets.useFading)
+    if(sets.useFading)
     {
         tranType = TR_FADE;
     }
@@ -396,9 +503,9 @@ void ProjectorDisplayScreen::renderAnnounceText(AnnounceSlide announce, TextSett
         tranType = TR_NONE;
     }
 
-    if(aSets.useBackground)
+    if(sets.useBackground)
     {
-        setBackPixmap(aSets.backgroundPix,0);
+        setBackPixmap(sets.backgroundPix,0);
         backType = B_PICTURE;
     }
     else
@@ -407,38 +514,55 @@ void ProjectorDisplayScreen::renderAnnounceText(AnnounceSlide announce, TextSett
         backType = B_NONE;
     }
 
-    setTextPixmap(imGen.generateAnnounceImage(announce,aSets));
-    //if(aSets.transitionType == 1)
-    //    setBackPixmap(aSets.backgroundPix,0);
-    //else
-    //    setBackPixmap(imGen.generateColorImage(m_color),0);
-    //tranType = aSets.transitionType;
-    updateScreen();
+    if(text.isNative)
+        setTextImage(imGen.generateEmptyImage().toImage(),text);
+    else
+        setTextImage(text.image);
+    isStaged = true;
+}
+
+bool ProjectorDisplayScreen::isStagedReady()
+{
+    return !isStaged || !isStagedImageLoading();
+}
+
+void ProjectorDisplayScreen::showStaged()
+{
+    // Nothing to do when the staged slide was replaced by a direct update
+    if(!isStaged)
+        return;
+    isStaged = false;
+    startTransitions();
 }
 
 void ProjectorDisplayScreen::renderSlideShow(QPixmap slide, SlideShowSettings &ssSets)
 {
     tranType = TR_FADE;
 
+    setTextImage(imGen.generateEmptyImage().toImage());
+    setBackPixmap(slide,slideFillMode(slide,ssSets));
+    updateScreen();
+
+}
+
+int ProjectorDisplayScreen::slideFillMode(const QPixmap &slide, SlideShowSettings &ssSets)
+{
     bool expand;
     if(slide.width()<imGen.width() && slide.height()<imGen.height())
         expand = ssSets.expandSmall;
     else
         expand = true;
 
-    setTextPixmap(imGen.generateEmptyImage());
     if(expand)
-        setBackPixmap(slide,ssSets.fitType +1);
+        return ssSets.fitType +1;
     else
-        setBackPixmap(slide,3);
-    updateScreen();
-
+        return 3;
 }
 
 void ProjectorDisplayScreen::renderVideo(VideoInfo videoDetails)
 {
     backType = B_VIDEO;
-    setTextPixmap(imGen.generateEmptyImage());
+    setTextImage(imGen.generateEmptyImage().toImage());
     setBackPixmap(imGen.generateColorImage(m_color),0);
     QObject *root = dispView->rootObject();
     QObject *item = root->findChild<QObject*>("player");
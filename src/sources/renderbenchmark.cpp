@@ -0,0 +1,783 @@
+/***************************************************************************
+//
+//    softProjector - an open source media projection software
+//    Copyright (C) 2017  Vladislav Kobzar
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation version 3 of the License.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+***************************************************************************/
+
+// Headless render benchmark for ImageGenerator, built by renderBenchmark.pro.
+// Renders all song stanzas, the given Bible chapters and all announcements of a
+// database at several screen sizes and reports slides per second and latency
+// percentiles for every content type. Runs on the offscreen platform, e.g.:
+//   renderBenchmark --db ~/.local/share/SoftProjector/ --bibles 1,2,3 --chapters 19:119,43:1
+//
+// With --golden it instead renders a fixed built-in corpus and compares every image
+// with the reference PNG of the same name in the given directory, so changes to
+// ImageGenerator can be checked for both output and speed in one run. The corpus
+// only uses the DejaVu Sans font bundled in renderbenchmark.qrc, the references
+// in src/goldens do not depend on the fonts of the machine. See src/goldens/README.md.
+//   renderBenchmark --golden goldens/ --record   (write the references and timings)
+//   renderBenchmark --golden goldens/            (compare, exit code 1 on mismatch or slowdown)
+// Golden mode also draws a set of texts with both QPainter::drawText and TextBlock and
+// fails when the two differ, so the text layout is checked against Qt itself.
+
+#include <QGuiApplication>
+#include <QFontDatabase>
+#include <QPainter>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QTextStream>
+#include <QtSql>
+#include "../headers/imagegenerator.hpp"
+#include "../headers/textlayout.hpp"
+#include "../headers/theme.hpp"
+#include "../headers/settings.hpp"
+#include "../headers/bible.hpp"
+#include "../headers/song.hpp"
+#include "../headers/announcement.hpp"
+#include "../headers/dbservice.hpp"
+
+class BenchSong
+{
+public:
+    Stanza stanza;
+    SongSettings settings;
+};
+
+class BenchResult
+{
+public:
+    QString type;
+    QSize size;
+    QList<qint64> times; // nanoseconds
+};
+
+static QTextStream out(stdout);
+static QTextStream err(stderr);
+
+static QSize parseSize(const QString &s)
+{
+    if(s == "720p")
+        return QSize(1280,720);
+    if(s == "1080p")
+        return QSize(1920,1080);
+    if(s == "4k" || s == "2160p")
+        return QSize(3840,2160);
+    QStringList wh = s.split("x");
+    if(wh.count() == 2)
+        return QSize(wh.at(0).toInt(),wh.at(1).toInt());
+    return QSize();
+}
+
+static double percentile(const QList<qint64> &sorted, int p)
+{
+    // Nearest rank, in milliseconds
+    if(sorted.isEmpty())
+        return 0;
+    int i = qBound(0,(sorted.count()*p + 99)/100 - 1,sorted.count()-1);
+    return sorted.at(i)/1e6;
+}
+
+static void printResult(const BenchResult &r)
+{
+    QList<qint64> t = r.times;
+    std::sort(t.begin(),t.end());
+    qint64 total(0);
+    foreach(qint64 n, t)
+        total += n;
+    double sps = total > 0 ? t.count()/(total/1e9) : 0;
+
+    out << QString("%1 %2 %3 %4 %5 %6 %7 %8\n").arg(r.type,-10)
+           .arg(QString("%1x%2").arg(r.size.width()).arg(r.size.height()),-10)
+           .arg(t.count(),7).arg(sps,9,'f',1)
+           .arg(percentile(t,50),8,'f',2).arg(percentile(t,95),8,'f',2)
+           .arg(percentile(t,99),8,'f',2).arg(t.isEmpty() ? 0.0 : t.last()/1e6,8,'f',2);
+    out.flush();
+}
+
+static QList<BenchSong> loadSongs(Theme &theme, int maxSongs)
+{
+    QList<BenchSong> songs;
+    QSqlQuery sq;
+    sq.exec("SELECT id FROM Songs ORDER BY id");
+    int count(0);
+    while(sq.next() && (maxSongs <= 0 || count < maxSongs))
+    {
+        Song song(sq.value(0).toInt());
+        song.readData();
+        BenchSong bs;
+        bs.settings = theme.song;
+        if(song.usePrivateSettings)
+            song.getSettings(bs.settings);
+        int stanzas = song.getSongTextList().count();
+        for(int i(0);i<stanzas;++i)
+        {
+            bs.stanza = song.getStanza(i);
+            songs.append(bs);
+        }
+        ++count;
+    }
+    return songs;
+}
+
+static QList<Verse> loadVerses(Theme &theme, BibleVersionSettings &bv, const QStringList &chapters)
+{
+    QList<Verse> verses;
+    Bible bible;
+    bible.setBiblesId(bv.primaryBible);
+    bible.loadOperatorBible();
+    foreach(const QString &c, chapters)
+    {
+        QStringList bc = c.split(":");
+        if(bc.count() != 2)
+            continue;
+        bible.getChapter(bc.at(0).toInt(),bc.at(1).toInt());
+        bible.currentIdList = bible.previewIdList;
+        for(int i(0);i<bible.currentIdList.count();++i)
+            verses.append(bible.getCurrentVerseAndCaption(QList<int>() << i,theme.bible,bv));
+    }
+    return verses;
+}
+
+static QList<AnnounceSlide> loadAnnouncements()
+{
+    QList<AnnounceSlide> slides;
+    QSqlQuery sq;
+    sq.exec("SELECT id FROM Announcements ORDER BY id");
+    while(sq.next())
+    {
+        Announcement a(sq.value(0).toInt());
+        a.readData();
+        int count = a.getAnnounceList().count();
+        for(int i(0);i<count;++i)
+            slides.append(a.getAnnounceSlide(i));
+    }
+    return slides;
+}
+
+class GoldenCase
+{
+    // One slide of the golden corpus
+public:
+    QString name;
+    int type; // 1 = bible, 2 = song, 3 = announce
+    Verse verse;
+    BibleSettings bSets;
+    Stanza stanza;
+    SongSettings sSets;
+    AnnounceSlide announce;
+    TextSettings aSets;
+
+    void setFont(const QString &family)
+    {
+        // Every font of the case, sizes are kept. Glyphs missing from the font are
+        // not taken from other fonts, so the result does not depend on installed fonts.
+        QList<QFont*> fonts;
+        fonts << &bSets.textFont << &bSets.captionFont << &sSets.textFont << &sSets.infoFont
+              << &sSets.endingFont << &aSets.textFont;
+        foreach(QFont *f, fonts)
+        {
+            f->setFamily(family);
+            f->setStyleStrategy(QFont::NoFontMerging);
+            f->setHintingPreference(QFont::PreferNoHinting);
+        }
+    }
+
+    QImage render(ImageGenerator &imGen) const
+    {
+        if(type == 1)
+            return imGen.generateBibleImage(verse,bSets);
+        else if(type == 2)
+            return imGen.generateSongImage(stanza,sSets);
+        return imGen.generateAnnounceImage(announce,aSets);
+    }
+};
+
+static QString shortStanza()
+{
+    return QString("Amazing grace! How sweet the sound\nThat saved a wretch like me!");
+}
+
+static QString longStanza()
+{
+    QStringList lines;
+    lines << "Through many dangers, toils and snares,"
+          << "I have already come;"
+          << "'Tis grace hath brought me safe thus far,"
+          << "And grace will lead me home."
+          << "The Lord has promised good to me,"
+          << "His Word my hope secures;"
+          << "He will my Shield and Portion be,"
+          << "As long as life endures."
+          << "Yea, when this flesh and heart shall fail,"
+          << "And mortal life shall cease,"
+          << "I shall possess, within the veil,"
+          << "A life of joy and peace.";
+    return lines.join("\n");
+}
+
+static const QString goldenFontFamily("DejaVu Sans");
+
+static QList<GoldenCase> goldenCorpus()
+{
+    QList<GoldenCase> cases;
+    QStringList alignV = QStringList() << "top" << "middle" << "bottom";
+    QStringList alignH = QStringList() << "left" << "center" << "right";
+
+    // Songs: short and long stanzas with every alignment combination
+    for(int v(0);v<3;++v)
+        for(int h(0);h<3;++h)
+            for(int l(0);l<2;++l)
+            {
+                GoldenCase c;
+                c.type = 2;
+                c.name = QString("song-%1-%2-%3").arg(l ? "long" : "short").arg(alignV.at(v)).arg(alignH.at(h));
+                c.stanza.number = 1;
+                c.stanza.stanza = l ? longStanza() : shortStanza();
+                c.stanza.stanzaTitle = "Verse 1";
+                c.stanza.wordsBy = "John Newton";
+                c.stanza.musicBy = "";
+                c.stanza.tune = "G";
+                c.stanza.isLast = l;
+                c.sSets.textAlignmentV = v;
+                c.sSets.textAlignmentH = h;
+                c.sSets.showStanzaTitle = true;
+                c.sSets.showSongKey = true;
+                c.sSets.showSongNumber = true;
+                c.sSets.showSongEnding = l;
+                cases.append(c);
+            }
+
+    // Shadow variants are where the blur work happens
+    for(int b(0);b<2;++b)
+    {
+        GoldenCase c = cases.at(1);
+        c.name = QString("song-long-%1").arg(b ? "blurshadow" : "noshadow");
+        c.sSets.useShadow = b;
+        c.sSets.useBlurShadow = b;
+        cases.append(c);
+    }
+
+    // Text layout cases: right to left text, leading spaces and one word wider than the screen
+    GoldenCase rtlSong = cases.at(0);
+    rtlSong.stanza.stanza = QString::fromUtf8("הַלְלוּ־יָהּ הַלְלוּ אֵל בְּקָדְשׁוֹ \n"
+            "הַלְלוּהוּ בִּרְקִיעַ עֻזּוֹ");
+    rtlSong.stanza.stanzaTitle = QString::fromUtf8("בית 1");
+    for(int h(0);h<3;++h)
+    {
+        GoldenCase c = rtlSong;
+        c.name = QString("song-rtl-hebrew-%1").arg(alignH.at(h));
+        c.sSets.textAlignmentH = h;
+        cases.append(c);
+    }
+    GoldenCase indented = cases.at(0);
+    indented.stanza.stanza = "Amazing grace! How sweet the sound\n    That saved a wretch like me!\n"
+            "I once was lost, but now am found,\n        Was blind, but now I see.";
+    for(int h(0);h<3;++h)
+    {
+        GoldenCase c = indented;
+        c.name = QString("song-leading-spaces-%1").arg(alignH.at(h));
+        c.sSets.textAlignmentH = h;
+        cases.append(c);
+    }
+    GoldenCase longWord = cases.at(0);
+    longWord.name = "song-long-word";
+    longWord.stanza.stanza = QString("Hallelujah").repeated(12) + "\nAmen";
+    cases.append(longWord);
+
+    // Bible: one translation, right to left translations and every alignment
+    GoldenCase bible;
+    bible.type = 1;
+    bible.verse.primary_text = "For God so loved the world, that he gave his only begotten Son, "
+            "that whosoever believeth in him should not perish, but have everlasting life.";
+    bible.verse.primary_caption = "John 3:16";
+    bible.bSets.versions.primaryBible = "1";
+    bible.bSets.versions.secondaryBible = "none";
+    bible.bSets.versions.trinaryBible = "none";
+    for(int v(0);v<3;++v)
+        for(int h(0);h<3;++h)
+        {
+            GoldenCase c = bible;
+            c.name = QString("bible-1-%1-%2").arg(alignV.at(v)).arg(alignH.at(h));
+            c.bSets.textAlignmentV = v;
+            c.bSets.textAlignmentH = h;
+            c.bSets.captionAlignment = h;
+            cases.append(c);
+        }
+
+    GoldenCase hebrew = bible;
+    hebrew.name = "bible-rtl-hebrew";
+    hebrew.verse.primary_text = QString::fromUtf8("כִּי־כֵן אָהַב הָאֱלֹהִים אֶת־הָעוֹלָם "
+            "עַד אֲשֶׁר נָתַן אֶת־בְּנוֹ אֶת־יְחִידוֹ");
+    hebrew.verse.primary_caption = QString::fromUtf8("יוחנן 3:16");
+    hebrew.bSets.textAlignmentH = 2;
+    hebrew.bSets.captionAlignment = 2;
+    cases.append(hebrew);
+
+    GoldenCase arabic = hebrew;
+    arabic.name = "bible-rtl-arabic";
+    arabic.verse.primary_text = QString::fromUtf8("لأَنَّهُ هكَذَا أَحَبَّ اللهُ الْعَالَمَ "
+            "حَتَّى بَذَلَ ابْنَهُ الْوَحِيدَ");
+    arabic.verse.primary_caption = QString::fromUtf8("يوحنا 3:16");
+    cases.append(arabic);
+
+    // Three translations, one of them right to left, with the screen use and position settings
+    GoldenCase three = bible;
+    three.verse.secondary_text = hebrew.verse.primary_text;
+    three.verse.secondary_caption = hebrew.verse.primary_caption;
+    three.verse.trinary_text = QString::fromUtf8("Ибо так возлюбил Бог мир, что отдал Сына Своего "
+            "Единородного, дабы всякий верующий в Него, не погиб, но имел жизнь вечную.");
+    three.verse.trinary_caption = QString::fromUtf8("Иоанна 3:16");
+    three.bSets.versions.secondaryBible = "2";
+    three.bSets.versions.trinaryBible = "3";
+    int uses[] = {100, 66, 33};
+    for(int u(0);u<3;++u)
+        for(int p(0);p<2;++p)
+        {
+            GoldenCase c = three;
+            c.name = QString("bible-3-use%1-%2").arg(uses[u]).arg(p ? "bottom" : "top");
+            c.bSets.screenUse = uses[u];
+            c.bSets.screenPosition = p;
+            cases.append(c);
+        }
+
+    // Announcements with every alignment combination
+    for(int v(0);v<3;++v)
+        for(int h(0);h<3;++h)
+        {
+            GoldenCase c;
+            c.type = 3;
+            c.name = QString("announce-%1-%2").arg(alignV.at(v)).arg(alignH.at(h));
+            c.announce.text = "Welcome!\nPlease join us for fellowship after the service.";
+            c.announce.usePrivateSettings = false;
+            c.aSets.textAlignmentV = v;
+            c.aSets.textAlignmentH = h;
+            cases.append(c);
+        }
+
+    for(int i(0);i<cases.count();++i)
+        cases[i].setFont(goldenFontFamily);
+    return cases;
+}
+
+static QHash<QString,double> readTimings(const QString &file)
+{
+    // "<case> <median ms>" lines written by --record
+    QHash<QString,double> timings;
+    QFile f(file);
+    if(!f.open(QIODevice::ReadOnly | QIODevice::Text))
+        return timings;
+    QTextStream ts(&f);
+    while(!ts.atEnd())
+    {
+        QStringList parts = ts.readLine().split(" ",Qt::SkipEmptyParts);
+        if(parts.count() == 2)
+            timings.insert(parts.at(0),parts.at(1).toDouble());
+    }
+    return timings;
+}
+
+class ParityCase
+{
+    // Text drawn both with QPainter::drawText and with TextBlock
+public:
+    QString name;
+    QString text;
+    int flags;
+    Qt::LayoutDirection direction;
+};
+
+static QList<ParityCase> parityCorpus()
+{
+    QList<ParityCase> cases;
+    QStringList names;
+    QStringList texts;
+    names << "ltr" << "rtl-hebrew" << "rtl-arabic" << "rtl-trailing-spaces" << "mixed"
+          << "leading-spaces" << "long-word" << "tabs" << "empty";
+    texts << "Amazing grace! How sweet the sound that saved a wretch like me!"
+          << QString::fromUtf8("כִּי־כֵן אָהַב הָאֱלֹהִים אֶת־הָעוֹלָם עַד אֲשֶׁר נָתַן אֶת־בְּנוֹ אֶת־יְחִידוֹ")
+          << QString::fromUtf8("لأَنَّهُ هكَذَا أَحَبَّ اللهُ الْعَالَمَ حَتَّى بَذَلَ ابْنَهُ الْوَحِيدَ")
+          << QString::fromUtf8("הַלְלוּ־יָהּ   \nהַלְלוּ אֵל בְּקָדְשׁוֹ ")
+          << QString::fromUtf8("John 3:16 יוחנן 3:16 Иоанна 3:16")
+          << "   Amazing grace!\n      How sweet the sound\n\tThat saved a wretch like me!"
+          << QString("Hallelujah").repeated(8)
+          << "Verse 1\tG\r\nChorus\tD"
+          << "";
+    QList<int> aligns;
+    aligns << Qt::AlignLeft << Qt::AlignHCenter << Qt::AlignRight;
+    QStringList alignNames;
+    alignNames << "left" << "center" << "right";
+    for(int t(0);t<texts.count();++t)
+        for(int a(0);a<aligns.count();++a)
+            for(int d(0);d<2;++d)
+            {
+                ParityCase c;
+                c.name = QString("parity-%1-%2%3").arg(names.at(t)).arg(alignNames.at(a)).arg(d ? "-rtl" : "");
+                c.text = texts.at(t);
+                c.flags = aligns.at(a) | Qt::AlignVCenter | Qt::TextWordWrap;
+                c.direction = d ? Qt::RightToLeft : Qt::LayoutDirectionAuto;
+                cases.append(c);
+            }
+    return cases;
+}
+
+static QImage parityImage(const ParityCase &c, bool textBlock, QRect &bounds)
+{
+    QImage image(640,360,QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::white);
+    QPainter p(&image);
+    p.setLayoutDirection(c.direction);
+    QFont font(goldenFontFamily,28);
+    font.setStyleStrategy(QFont::NoFontMerging);
+    font.setHintingPreference(QFont::PreferNoHinting);
+    p.setFont(font);
+    p.setPen(Qt::black);
+    QRect rect(20,30,600,300);
+    if(textBlock)
+    {
+        TextBlock block(c.text,p.font(),rect.width(),c.flags,p.device(),p.layoutDirection());
+        block.draw(&p,rect);
+        bounds = block.boundingRect(rect);
+    }
+    else
+    {
+        p.drawText(rect,c.flags,c.text);
+        bounds = p.boundingRect(rect,c.flags,c.text);
+    }
+    return image;
+}
+
+static void compareImages(const QImage &a, const QImage &b, double &meanDiff, double &badRatio)
+{
+    // Perceptual tolerance: antialiasing and rounding differences are small per channel,
+    // real changes move whole glyphs. Counts pixels that differ by more than a visible amount.
+    QImage ia = a.convertToFormat(QImage::Format_ARGB32);
+    QImage ib = b.convertToFormat(QImage::Format_ARGB32);
+    qint64 sum(0);
+    qint64 bad(0);
+    for(int y(0);y<ia.height();++y)
+    {
+        const QRgb *la = reinterpret_cast<const QRgb*>(ia.constScanLine(y));
+        const QRgb *lb = reinterpret_cast<const QRgb*>(ib.constScanLine(y));
+        for(int x(0);x<ia.width();++x)
+        {
+            int d = qMax(qMax(qAbs(qRed(la[x]) - qRed(lb[x])),qAbs(qGreen(la[x]) - qGreen(lb[x]))),
+                         qMax(qAbs(qBlue(la[x]) - qBlue(lb[x])),qAbs(qAlpha(la[x]) - qAlpha(lb[x]))));
+            sum += d;
+            if(d > 48)
+                ++bad;
+        }
+    }
+    qint64 pixels = qMax(1,ia.width()*ia.height());
+    meanDiff = double(sum)/pixels;
+    badRatio = double(bad)/pixels;
+}
+
+static int runGolden(const QString &dirPath, bool record, int repeat, double maxSlowdown)
+{
+    QDir dir(dirPath);
+    if(record)
+        dir.mkpath(".");
+    if(!dir.exists())
+    {
+        out << "Golden directory not found: " << dirPath << "\n";
+        return 1;
+    }
+
+    if(QFontDatabase::addApplicationFont(":/fonts/DejaVuSans.ttf") < 0)
+    {
+        out << "Could not load the bundled golden font\n";
+        return 1;
+    }
+
+    ImageGenerator imGen;
+    imGen.setScreenSize(QSize(1280,720));
+    QList<GoldenCase> cases = goldenCorpus();
+    int failed(0);
+    int missing(0);
+    QElapsedTimer timer;
+
+    // Median render times of the references. Times depend on the machine, they are
+    // only checked when the references were recorded on the machine that compares.
+    QString timingFile = dir.filePath("timings.txt");
+    QHash<QString,double> timings = record ? QHash<QString,double>() : readTimings(timingFile);
+    QStringList recorded;
+
+    if(!record)
+    {
+        // Without any reference the check compares nothing, stop before rendering
+        int found(0);
+        foreach(const GoldenCase &c, cases)
+            if(QFile::exists(dir.filePath(c.name + ".png")))
+                ++found;
+        if(found == 0)
+        {
+            err << "ERROR: no golden references in " << dir.absolutePath() << "\n"
+                << "The check cannot pass until they are recorded with:\n"
+                << "  renderBenchmark --golden " << dirPath << " --record\n";
+            return 2;
+        }
+        if(!QFile::exists(timingFile))
+            err << "WARNING: " << timingFile << " not found, render times are not checked\n";
+    }
+
+    out << QString("%1 %2 %3 %4\n").arg(QString("case"),-28).arg(QString("ms"),8)
+           .arg(QString("mean"),8).arg(QString("result"));
+    foreach(const GoldenCase &c, cases)
+    {
+        QImage image;
+        QList<qint64> times;
+        for(int r(0);r<repeat;++r)
+        {
+            timer.start();
+            image = c.render(imGen);
+            times.append(timer.nsecsElapsed());
+        }
+        std::sort(times.begin(),times.end());
+        double ms = times.at(times.count()/2)/1e6;
+
+        QString file = dir.filePath(c.name + ".png");
+        QString result;
+        double meanDiff(0);
+        if(record)
+        {
+            result = image.save(file) ? "recorded" : "WRITE FAILED";
+            recorded << QString("%1 %2").arg(c.name).arg(ms,0,'f',3);
+        }
+        else
+        {
+            QImage golden(file);
+            double badRatio(0);
+            if(golden.isNull())
+            {
+                result = "MISSING";
+                ++missing;
+            }
+            else if(golden.size() != image.size())
+                result = "SIZE MISMATCH";
+            else
+            {
+                compareImages(image,golden,meanDiff,badRatio);
+                if(meanDiff > 1.0 || badRatio > 0.001)
+                    result = QString("DIFF %1% of pixels").arg(badRatio*100,0,'f',3);
+                else if(timings.contains(c.name) && ms > timings.value(c.name)*maxSlowdown)
+                    result = QString("SLOW %1x").arg(ms/timings.value(c.name),0,'f',2);
+                else
+                    result = "ok";
+            }
+            if(result != "ok" && result != "MISSING")
+            {
+                ++failed;
+                image.save(dir.filePath(c.name + ".actual.png"));
+            }
+        }
+        out << QString("%1 %2 %3 %4\n").arg(c.name,-28).arg(ms,8,'f',2).arg(meanDiff,8,'f',3).arg(result);
+        out.flush();
+    }
+
+    // TextBlock against drawText, needs no references
+    foreach(const ParityCase &c, parityCorpus())
+    {
+        QRect drawTextBounds, blockBounds;
+        QImage expected = parityImage(c,false,drawTextBounds);
+        QImage image = parityImage(c,true,blockBounds);
+        double meanDiff(0);
+        double badRatio(0);
+        compareImages(image,expected,meanDiff,badRatio);
+        QString result = "ok";
+        if(badRatio > 0)
+            result = QString("PARITY DIFF %1% of pixels").arg(badRatio*100,0,'f',3);
+        else if(blockBounds != drawTextBounds)
+            result = "PARITY BOUNDS";
+        if(result != "ok")
+        {
+            ++failed;
+            expected.save(dir.filePath(c.name + ".drawtext.png"));
+            image.save(dir.filePath(c.name + ".actual.png"));
+        }
+        out << QString("%1 %2 %3 %4\n").arg(c.name,-28).arg(QString("-"),8).arg(meanDiff,8,'f',3).arg(result);
+        out.flush();
+    }
+
+    if(record)
+    {
+        QFile f(timingFile);
+        if(f.open(QIODevice::WriteOnly | QIODevice::Text | QIODevice::Truncate))
+            f.write((recorded.join("\n") + "\n").toUtf8());
+        return failed ? 1 : 0;
+    }
+
+    out << QString("\n%1 of %2 cases differ from the references or drawText, or are slower than %3x their recorded time\n")
+           .arg(failed).arg(cases.count() + parityCorpus().count()).arg(maxSlowdown);
+    if(missing)
+    {
+        // Not a pass: nothing was compared for these cases
+        out.flush();
+        err << QString("ERROR: %1 cases have no reference, record them with --record\n").arg(missing);
+        return failed ? 1 : 2;
+    }
+    return failed ? 1 : 0;
+}
+
+int main(int argc, char *argv[])
+{
+    if(qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM"))
+        qputenv("QT_QPA_PLATFORM","offscreen");
+    QGuiApplication app(argc, argv);
+    app.setApplicationName("renderBenchmark");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Measures text rendering speed of SoftProjector.");
+    parser.addHelpOption();
+    QCommandLineOption dbOption("db","Directory that holds spData.sqlite.","dir",".");
+    QCommandLineOption themeOption("theme","Theme id, the current theme by default.","id");
+    QCommandLineOption biblesOption("bibles","Comma separated Bible version ids, 1 to 3. "
+                                    "Every prefix is measured, so 1,2,3 measures one, two and three translations.","ids");
+    QCommandLineOption chaptersOption("chapters","Comma separated book:chapter list.","list","1:1,19:23,43:3");
+    QCommandLineOption sizesOption("sizes","Comma separated screen sizes: 720p, 1080p, 4k or WxH.","list","720p,1080p,4k");
+    QCommandLineOption songsOption("songs","Maximum number of songs, 0 for all.","n","0");
+    QCommandLineOption repeatOption("repeat","Number of times every slide is rendered.","n","1");
+    parser.addOption(dbOption);
+    parser.addOption(themeOption);
+    parser.addOption(biblesOption);
+    parser.addOption(chaptersOption);
+    parser.addOption(sizesOption);
+    parser.addOption(songsOption);
+    QCommandLineOption goldenOption("golden","Render the built-in corpus and compare it with the "
+                                    "reference images in dir instead of benchmarking a database.","dir");
+    QCommandLineOption recordOption("record","With --golden, write the reference images and render times.");
+    QCommandLineOption slowdownOption("max-slowdown","With --golden, fail cases whose median render time "
+                                      "is more than factor times the recorded one.","factor","1.5");
+    parser.addOption(repeatOption);
+    parser.addOption(goldenOption);
+    parser.addOption(recordOption);
+    parser.addOption(slowdownOption);
+    parser.process(app);
+
+    int repeat = qMax(1,parser.value(repeatOption).toInt());
+    if(parser.isSet(goldenOption))
+    {
+        // A single render is too noisy to compare times with
+        return runGolden(parser.value(goldenOption),parser.isSet(recordOption),qMax(5,repeat),
+                         qMax(1.0,parser.value(slowdownOption).toDouble()));
+    }
+
+    QString dbPath = QDir(parser.value(dbOption)).filePath("spData.sqlite");
+    if(!QFile::exists(dbPath))
+    {
+        out << "Database not found: " << dbPath << "\n";
+        return 1;
+    }
+    QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE");
+    db.setDatabaseName(dbPath);
+    db.setConnectOptions("QSQLITE_OPEN_READONLY");
+    if(!db.open())
+    {
+        out << "Could not open database: " << db.lastError().text() << "\n";
+        return 1;
+    }
+    DbService::init(dbPath);
+
+    Settings settings;
+    settings.loadSettings();
+    Theme theme;
+    theme.setThemeId(parser.isSet(themeOption) ? parser.value(themeOption).toInt()
+                                                : settings.general.currentThemeId);
+    theme.loadTheme();
+
+    QStringList bibleIds = parser.isSet(biblesOption) ? parser.value(biblesOption).split(",")
+                                                      : QStringList() << settings.bibleSets.primaryBible;
+    QStringList chapters = parser.value(chaptersOption).split(",",Qt::SkipEmptyParts);
+
+    QList<QSize> sizes;
+    foreach(const QString &s, parser.value(sizesOption).split(",",Qt::SkipEmptyParts))
+    {
+        QSize size = parseSize(s.trimmed().toLower());
+        if(size.isValid())
+            sizes.append(size);
+    }
+
+    // Load all content first, only rendering is measured
+    QList<BenchSong> songs = loadSongs(theme,parser.value(songsOption).toInt());
+    QList<AnnounceSlide> announcements = loadAnnouncements();
+    QList<QList<Verse> > verses; // by number of translations
+    QList<BibleVersionSettings> versions;
+    for(int n(1);n<=qMin(3,bibleIds.count());++n)
+    {
+        BibleVersionSettings bv;
+        bv.primaryBible = bibleIds.at(0);
+        bv.secondaryBible = n > 1 ? bibleIds.at(1) : QString("none");
+        bv.trinaryBible = n > 2 ? bibleIds.at(2) : QString("none");
+        versions.append(bv);
+        verses.append(loadVerses(theme,bv,chapters));
+    }
+
+    out << QString("Theme %1: %2 stanzas, %3 verses, %4 announcement slides\n\n")
+           .arg(theme.getThemeId()).arg(songs.count())
+           .arg(verses.isEmpty() ? 0 : verses.first().count()).arg(announcements.count());
+    out << QString("%1 %2 %3 %4 %5 %6 %7 %8\n").arg(QString("type"),-10).arg(QString("size"),-10)
+           .arg(QString("slides"),7).arg(QString("slides/s"),9).arg(QString("p50 ms"),8)
+           .arg(QString("p95 ms"),8).arg(QString("p99 ms"),8).arg(QString("max ms"),8);
+
+    QElapsedTimer timer;
+    foreach(const QSize &size, sizes)
+    {
+        ImageGenerator imGen;
+        imGen.setScreenSize(size);
+
+        BenchResult songResult;
+        songResult.type = "song";
+        songResult.size = size;
+        for(int r(0);r<repeat;++r)
+            foreach(const BenchSong &bs, songs)
+            {
+                timer.start();
+                imGen.generateSongImage(bs.stanza,bs.settings);
+                songResult.times.append(timer.nsecsElapsed());
+            }
+        printResult(songResult);
+
+        for(int n(0);n<verses.count();++n)
+        {
+            BibleSettings bSets = theme.bible;
+            bSets.versions = versions.at(n);
+            BenchResult bibleResult;
+            bibleResult.type = QString("bible-%1").arg(n+1);
+            bibleResult.size = size;
+            for(int r(0);r<repeat;++r)
+                foreach(const Verse &v, verses.at(n))
+                {
+                    timer.start();
+                    imGen.generateBibleImage(v,bSets);
+                    bibleResult.times.append(timer.nsecsElapsed());
+                }
+            printResult(bibleResult);
+        }
+
+        BenchResult announceResult;
+        announceResult.type = "announce";
+        announceResult.size = size;
+        for(int r(0);r<repeat;++r)
+            foreach(const AnnounceSlide &a, announcements)
+            {
+                timer.start();
+                imGen.generateAnnounceImage(a,theme.announce);
+                announceResult.times.append(timer.nsecsElapsed());
+            }
+        printResult(announceResult);
+    }
+
+    return 0;
+}
@@ -0,0 +1,275 @@
+/***************************************************************************
+//
+//    softProjector - an open source media projection software
+//    Copyright (C) 2017  Vladislav Kobzar
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation version 3 of the License.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+***************************************************************************/
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QHash>
+#include <QtConcurrent>
+#include "../headers/rendercache.hpp"
+
+static void writeTextBase(QDataStream &ds, const TextSettingsBase &s)
+{
+    // Only settings that change the produced text image are part of the key
+    ds << s.textFont.toString() << s.textColor.rgba() << s.textShadowColor.rgba();
+    ds << s.textAlignmentV << s.textAlignmentH;
+    ds << s.useShadow << s.useBlurShadow;
+    ds << s.screenUse << s.screenPosition;
+}
+
+static QByteArray hashKey(const QByteArray &data)
+{
+    return QCryptographicHash::hash(data,QCryptographicHash::Md5);
+}
+
+QByteArray renderKey(const Verse &verse, const BibleSettings &bSets, QSize size)
+{
+    QByteArray data;
+    QDataStream ds(&data,QIODevice::WriteOnly);
+    ds << 1 << size;
+    ds << verse.primary_text << verse.primary_caption;
+    ds << verse.secondary_text << verse.secondary_caption;
+    ds << verse.trinary_text << verse.trinary_caption;
+    writeTextBase(ds,bSets);
+    ds << bSets.captionFont.toString() << bSets.captionColor.rgba() << bSets.captionShadowColor.rgba();
+    ds << bSets.captionAlignment << bSets.captionPosition;
+    ds << bSets.versions.primaryBible << bSets.versions.secondaryBible << bSets.versions.trinaryBible;
+    ds << bSets.bibleAddBKColorToText << bSets.bibleTextRecBKColor.rgba() << bSets.bibleTextGenBKColor.rgba();
+    return hashKey(data);
+}
+
+QByteArray renderKey(const Stanza &stanza, const SongSettings &sSets, QSize size)
+{
+    QByteArray data;
+    QDataStream ds(&data,QIODevice::WriteOnly);
+    ds << 2 << size;
+    ds << stanza.stanza << stanza.stanzaTitle << stanza.number << stanza.tune << stanza.isLast;
+    writeTextBase(ds,sSets);
+    ds << sSets.showStanzaTitle << sSets.showSongKey << sSets.showSongNumber << sSets.showSongEnding;
+    ds << sSets.infoFont.toString() << sSets.infoColor.rgba() << sSets.infoShadowColor.rgba() << sSets.infoAling;
+    ds << sSets.endingFont.toString() << sSets.endingColor.rgba() << sSets.endingShadowColor.rgba();
+    ds << sSets.endingType << sSets.endingPosition;
+    ds << sSets.songAddBKColorToText << sSets.songTextRecBKColor.rgba() << sSets.songTextGenBKColor.rgba();
+    return hashKey(data);
+}
+
+QByteArray renderKey(const AnnounceSlide &announce, const TextSettings &aSets, QSize size)
+{
+    QByteArray data;
+    QDataStream ds(&data,QIODevice::WriteOnly);
+    ds << 3 << size;
+    ds << announce.text;
+    writeTextBase(ds,aSets);
+    ds << aSets.announcementAddBKColorToText << aSets.announcementTextRecBKColor.rgba()
+       << aSets.announcementTextGenBKColor.rgba();
+    return hashKey(data);
+}
+
+RenderJob::RenderJob()
+{
+    type = 0;
+    nativeText = false;
+}
+
+RenderJob::RenderJob(const Verse &v, const BibleSettings &sets, QSize screenSize)
+{
+    type = 1;
+    nativeText = false;
+    size = screenSize;
+    verse = v;
+    bSets = sets;
+    bSets.backgroundPix = QPixmap();
+}
+
+RenderJob::RenderJob(const Stanza &s, const SongSettings &sets, QSize screenSize)
+{
+    type = 2;
+    nativeText = false;
+    size = screenSize;
+    stanza = s;
+    stanza.background = QPixmap();
+    sSets = sets;
+    sSets.backgroundPix = QPixmap();
+}
+
+RenderJob::RenderJob(const AnnounceSlide &a, const TextSettings &sets, QSize screenSize)
+{
+    type = 3;
+    nativeText = false;
+    size = screenSize;
+    announce = a;
+    aSets = sets;
+    aSets.backgroundPix = QPixmap();
+}
+
+QByteArray RenderJob::key() const
+{
+    QByteArray key;
+    switch (type) {
+    case 1:
+        key = renderKey(verse,bSets,size);
+        break;
+    case 2:
+        key = renderKey(stanza,sSets,size);
+        break;
+    case 3:
+        key = renderKey(announce,aSets,size);
+        break;
+    default:
+        break;
+    }
+    if(nativeText)
+        key.append('n');
+    return key;
+}
+
+TextFrame RenderJob::render() const
+{
+    // A fresh generator per job, ImageGenerator keeps per-render state
+    ImageGenerator imGen;
+    imGen.setScreenSize(size);
+
+    // Blurred shadows can not be drawn by the scene graph text layer, they stay images
+    bool blur = (type == 1 && bSets.useBlurShadow) || (type == 2 && sSets.useBlurShadow)
+            || (type == 3 && aSets.useBlurShadow);
+    imGen.setRecordOnly(nativeText && !blur);
+
+    QImage image;
+    switch (type) {
+    case 1:
+        image = imGen.generateBibleImage(verse,bSets);
+        break;
+    case 2:
+        image = imGen.generateSongImage(stanza,sSets);
+        break;
+    case 3:
+        image = imGen.generateAnnounceImage(announce,aSets);
+        break;
+    default:
+        break;
+    }
+
+    TextFrame frame = imGen.textFrame();
+    frame.image = image;
+    return frame;
+}
+
+static TextFrame renderJob(const RenderJob &job)
+{
+    return job.render();
+}
+
+RenderCache::RenderCache()
+{
+    // Enough for a few slides on each of four 4K outputs
+    m_cache.setMaxCost(256*1024);
+}
+
+TextFrame RenderCache::render(const RenderJob &job)
+{
+    return render(QList<RenderJob>() << job).first();
+}
+
+QList<TextFrame> RenderCache::render(const QList<RenderJob> &jobs)
+{
+    QList<QByteArray> keys;
+    QHash<QByteArray,TextFrame> frames;
+    QList<int> toRender; // index of the first job for every key that is not cached
+
+    m_mutex.lock();
+    for(int i(0);i<jobs.count();++i)
+    {
+        QByteArray key = jobs.at(i).key();
+        keys.append(key);
+        if(frames.contains(key))
+            continue;
+        if(m_prepared.contains(key))
+            frames.insert(key,m_prepared.value(key));
+        else if(TextFrame *f = m_cache.object(key))
+            frames.insert(key,*f);
+        else
+        {
+            frames.insert(key,TextFrame());
+            toRender.append(i);
+        }
+    }
+    m_mutex.unlock();
+
+    if(toRender.count() == 1)
+    {
+        // Nothing to run in parallel
+        int i = toRender.first();
+        frames[keys.at(i)] = jobs.at(i).render();
+    }
+    else if(toRender.count() > 1)
+    {
+        QList<QFuture<TextFrame> > futures;
+        foreach(int i, toRender)
+            futures.append(QtConcurrent::run(&m_pool,renderJob,jobs.at(i)));
+        for(int j(0);j<toRender.count();++j)
+            frames[keys.at(toRender.at(j))] = futures[j].result();
+    }
+
+    m_mutex.lock();
+    foreach(int i, toRender)
+    {
+        const TextFrame &f = frames.value(keys.at(i));
+        m_cache.insert(keys.at(i),new TextFrame(f),qMax(1,f.image.width()*f.image.height()*4/1024));
+    }
+    m_mutex.unlock();
+
+    QList<TextFrame> out;
+    foreach(const QByteArray &key, keys)
+        out.append(frames.value(key));
+    return out;
+}
+
+void RenderCache::prepare(const QList<RenderJob> &jobs)
+{
+    QList<TextFrame> frames = render(jobs);
+    QMutexLocker locker(&m_mutex);
+    for(int i(0);i<jobs.count();++i)
+        m_prepared.insert(jobs.at(i).key(),frames.at(i));
+}
+
+void RenderCache::releasePrepared()
+{
+    QMutexLocker locker(&m_mutex);
+    m_prepared.clear();
+}
+
+void RenderCache::clear()
+{
+    QMutexLocker locker(&m_mutex);
+    m_cache.clear();
+    m_prepared.clear();
+}
+
+int RenderCache::cost()
+{
+    // Memory used by cached and prepared text layers, in KB
+    QMutexLocker locker(&m_mutex);
+    int cost = m_cache.totalCost();
+    QHash<QByteArray,TextFrame>::const_iterator i = m_prepared.constBegin();
+    for(;i != m_prepared.constEnd();++i)
+    {
+        if(!m_cache.contains(i.key()))
+            cost += qMax(1,i.value().image.width()*i.value().image.height()*4/1024);
+    }
+    return cost;
+}
@@ -0,0 +1,166 @@
+/***************************************************************************
+//
+//    softProjector - an open source media projection software
+//    Copyright (C) 2017  Vladislav Kobzar
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation version 3 of the License.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+***************************************************************************/
+
+#include <QFile>
+#include <QTextStream>
+#include <QtAlgorithms>
+#include "../headers/renderprofiler.hpp"
+
+class ProfilerClock
+{
+public:
+    ProfilerClock() { timer.start(); }
+    QElapsedTimer timer;
+};
+
+static QElapsedTimer &profilerClock()
+{
+    static ProfilerClock clock;
+    return clock.timer;
+}
+
+RenderProfiler::RenderProfiler()
+{
+    profilerClock();
+}
+
+RenderProfiler *RenderProfiler::instance()
+{
+    static RenderProfiler profiler;
+    return &profiler;
+}
+
+qint64 RenderProfiler::now()
+{
+    return profilerClock().nsecsElapsed();
+}
+
+QString RenderProfiler::stageName(int stage)
+{
+    switch (stage) {
+    case ScreenUpdate:
+        return "Screen update";
+    case Database:
+        return "Database";
+    case TextRender:
+        return "Text render";
+    case ShadowBlur:
+        return "Shadow blur";
+    case BackgroundScale:
+        return "Background scale";
+    case ImageUpload:
+        return "Image upload";
+    case Transition:
+        return "Transition start";
+    default:
+        return QString();
+    }
+}
+
+void RenderProfiler::record(int stage, qint64 start, qint64 duration)
+{
+    if(stage < 0 || stage >= StageCount)
+        return;
+    int i = m_head[stage].fetchAndAddRelaxed(1) % RingSize;
+    m_start[stage][i].storeRelaxed(start);
+    m_duration[stage][i].storeRelease(duration);
+}
+
+QList<qint64> RenderProfiler::durations(int stage)
+{
+    // Oldest first
+    QList<qint64> d;
+    if(stage < 0 || stage >= StageCount)
+        return d;
+    quint32 head = m_head[stage].loadAcquire();
+    quint32 count = qMin(head,(quint32)RingSize);
+    for(quint32 j(head-count);j<head;++j)
+        d.append(m_duration[stage][j % RingSize].loadAcquire());
+    return d;
+}
+
+static qint64 percentile(const QList<qint64> &sorted, int p)
+{
+    if(sorted.isEmpty())
+        return 0;
+    int i = (sorted.count()-1)*p/100;
+    return sorted.at(i);
+}
+
+QString RenderProfiler::summary()
+{
+    // Times are in milliseconds
+    QString s = QString("%1 %2 %3 %4 %5 %6\n").arg(QString("Stage"),-17).arg(QString("last"),8)
+            .arg(QString("p50"),8).arg(QString("p95"),8).arg(QString("max"),8).arg(QString("n"),5);
+    for(int st(0);st<StageCount;++st)
+    {
+        QList<qint64> d = durations(st);
+        if(d.isEmpty())
+        {
+            s += QString("%1 %2\n").arg(stageName(st),-17).arg(QString("-"),8);
+            continue;
+        }
+        qint64 last = d.last();
+        std::sort(d.begin(),d.end());
+        s += QString("%1 %2 %3 %4 %5 %6\n").arg(stageName(st),-17)
+                .arg(last/1e6,8,'f',2).arg(percentile(d,50)/1e6,8,'f',2)
+                .arg(percentile(d,95)/1e6,8,'f',2).arg(d.last()/1e6,8,'f',2)
+                .arg(d.count(),5);
+    }
+    return s;
+}
+
+bool RenderProfiler::saveCsv(const QString &path)
+{
+    QFile file(path);
+    if(!file.open(QIODevice::WriteOnly | QIODevice::Text))
+        return false;
+
+    QTextStream out(&file);
+    out << "stage,start_ns,duration_ns\n";
+    for(int st(0);st<StageCount;++st)
+    {
+        quint32 head = m_head[st].loadAcquire();
+        quint32 count = qMin(head,(quint32)RingSize);
+        for(quint32 j(head-count);j<head;++j)
+        {
+            int i = j % RingSize;
+            out << stageName(st) << "," << m_start[st][i].loadAcquire() << ","
+                << m_duration[st][i].loadAcquire() << "\n";
+        }
+    }
+    return true;
+}
+
+void RenderProfiler::clear()
+{
+    for(int st(0);st<StageCount;++st)
+        m_head[st].storeRelease(0);
+}
+
+RenderSpan::RenderSpan(int stage)
+{
+    m_stage = stage;
+    m_start = RenderProfiler::now();
+}
+
+RenderSpan::~RenderSpan()
+{
+    RenderProfiler::instance()->record(m_stage,m_start,RenderProfiler::now()-m_start);
+}
@@ -17,16 +17,27 @@
 //
 ***************************************************************************/
 
+#include <QtConcurrent>
 #include "../headers/schedule.hpp"
 
+#ifdef Q_OS_WIN
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
 Schedule::Schedule()
 {
     scid = -1;
+    sorder = -1;
+    isLoaded = true;
 }
 
 Schedule::Schedule(BibleHistory &b)
 {
     scid = -1;
+    sorder = -1;
+    isLoaded = true;
     stype = "bible";
     name = b.caption;
     icon = QIcon(":/icons/icons/book.png");
@@ -36,6 +47,8 @@ Schedule::Schedule(BibleHistory &b)
 Schedule::Schedule(Song &s)
 {
     scid = -1;
+    sorder = -1;
+    isLoaded = true;
     stype = "song";
     name = QString("%1 %2").arg(s.number).arg(s.title);
     icon = QIcon(":/icons/icons/song_tab.png");
@@ -45,6 +58,8 @@ Schedule::Schedule(Song &s)
 Schedule::Schedule(SlideShow &s)
 {
     scid = -1;
+    sorder = -1;
+    isLoaded = true;
     stype = "slideshow";
     name = s.name;
     icon = QIcon(":/icons/icons/photo.png");
@@ -54,6 +69,8 @@ Schedule::Schedule(SlideShow &s)
 Schedule::Schedule(VideoInfo &m)
 {
     scid = -1;
+    sorder = -1;
+    isLoaded = true;
     stype = "media";
     name = m.fileName;
     icon = QIcon(":/icons/icons/video.png");
@@ -63,8 +80,608 @@ Schedule::Schedule(VideoInfo &m)
 Schedule::Schedule(Announcement &a)
 {
     scid = -1;
+    sorder = -1;
+    isLoaded = true;
     stype = "announce";
     name = a.title;
     icon = QIcon(":/icons/icons/announce.png");
     announce = a;
 }
+
+ScheduleFile::ScheduleFile(const QString &path)
+{
+    m_connection = "spsc";
+    m_db = QSqlDatabase::addDatabase("QSQLITE",m_connection);
+    m_db.setDatabaseName(path);
+    if(!m_db.open())
+        return;
+
+    createTables();
+    m_insSchedule = QSqlQuery(m_db);
+    m_insSchedule.prepare("INSERT INTO schedule (stype,name,sorder) VALUES(?,?,?)");
+    m_updSchedule = QSqlQuery(m_db);
+    m_updSchedule.prepare("UPDATE schedule SET name = ?, sorder = ? WHERE id = ?");
+    m_insBible = QSqlQuery(m_db);
+    m_insBible.prepare("INSERT INTO bible (scid,verseIds,caption,captionLong) VALUES(?,?,?,?)");
+    m_insSong = QSqlQuery(m_db);
+    m_insSong.prepare("INSERT INTO song (scid,songid,sbid,sbName,number,title,category,tune,wordsBy,musicBy,"
+                      "songText,notes,usePrivate,alignV,alignH,color,font,infoColor,infoFont,endingColor,"
+                      "endingFont,useBack,backImage,backName) "
+                      "VALUES(?,?,?,?,?,?,?,?,?,?,?,?,?,?,?,?,?,?,?,?,?,?,?,?)");
+    m_insSlideShow = QSqlQuery(m_db);
+    m_insSlideShow.prepare("INSERT INTO slideshow (scid,ssid,name,info) VALUES (?,?,?,?)");
+    m_insSlide = QSqlQuery(m_db);
+    m_insSlide.prepare("INSERT INTO slides (scid,sid,name,path,porder,image,imageSmall,imagePreview) "
+                       "VALUES(?,?,?,?,?,?,?,?)");
+    m_insMedia = QSqlQuery(m_db);
+    m_insMedia.prepare("INSERT INTO media (scid,name,path,aRatio) VALUES(?,?,?,?)");
+    m_insAnnounce = QSqlQuery(m_db);
+    m_insAnnounce.prepare("INSERT INTO announce (scid,aId,title,aText,usePrivate,useAuto,loop,slideTimer,font,"
+                          "color,useBack,backImage,backPath,alignV,alignH) "
+                          "VALUES(?,?,?,?,?,?,?,?,?,?,?,?,?,?,?)");
+}
+
+ScheduleFile::~ScheduleFile()
+{
+    // Queries and the database handle have to be gone before the connection is removed
+    m_insSchedule = m_updSchedule = m_insBible = m_insSong = QSqlQuery();
+    m_insSlideShow = m_insSlide = m_insMedia = m_insAnnounce = QSqlQuery();
+    m_db.close();
+    m_db = QSqlDatabase();
+    QSqlDatabase::removeDatabase(m_connection);
+}
+
+bool ScheduleFile::isOpen() const
+{
+    return m_db.isOpen();
+}
+
+void ScheduleFile::createTables()
+{
+    QSqlQuery sq(m_db);
+    sq.exec("PRAGMA user_version = 2");
+    sq.exec("CREATE TABLE IF NOT EXISTS 'schedule' ('id' INTEGER PRIMARY KEY  AUTOINCREMENT  NOT NULL, "
+            "'stype' TEXT, 'name' TEXT, 'sorder' INTEGER )");
+    sq.exec("CREATE TABLE IF NOT EXISTS 'bible' ('scid' INTEGER, 'verseIds' TEXT, 'caption' TEXT, 'captionLong' TEXT)");
+    sq.exec("CREATE TABLE IF NOT EXISTS 'song' ('scid' INTEGER, 'songid' INTEGER, 'sbid' INTEGER, 'sbName' TEXT, "
+            "'number' INTEGER, 'title' TEXT, 'category' INTEGER, 'tune' TEXT, 'wordsBy' TEXT, 'musicBy' TEXT, "
+            "'songText' TEXT, 'notes' TEXT, 'usePrivate' BOOL, 'alignV' INTEGER, 'alignH' INTEGER, 'color' INTEGER, "
+            "'font' TEXT, 'infoColor' INTEGER, 'infoFont' TEXT, 'endingColor' INTEGER, 'endingFont' TEXT, "
+            "'useBack' BOOL, 'backImage' BLOB, 'backName' TEXT)");
+    sq.exec("CREATE TABLE IF NOT EXISTS 'slideshow' ('scid' INTEGER, 'ssid' INTEGER, 'name' TEXT, 'info' TEXT)");
+    sq.exec("CREATE TABLE IF NOT EXISTS 'slides' ('scid' INTEGER, 'sid' INTEGER, 'name' TEXT, 'path' TEXT, "
+            "'porder' INTEGER, 'image' BLOB, 'imageSmall' BLOB, 'imagePreview' BLOB)");
+    sq.exec("CREATE TABLE IF NOT EXISTS 'media' ('scid' INTEGER, 'name' TEXT, 'path' TEXT, 'aRatio' INTEGER)");
+    sq.exec("CREATE TABLE IF NOT EXISTS 'announce' ('scid' INTEGER, 'aId' INTEGER, 'title' TEXT, 'aText' TEXT, "
+            "'usePrivate' BOOL, 'useAuto' BOOL, 'loop' BOOL, 'slideTimer' INTEGER, 'font' TEXT, 'color' INTEGER, "
+            "'useBack' BOOL, 'backImage' BLOB, 'backPath' TEXT, 'alignV' INTEGER, 'alignH' INTEGER)");
+}
+
+bool ScheduleFile::save(QList<Schedule> &schedule, bool all)
+{
+    // With all set every item is written as new, for files that were just created.
+    // Changes are made on a copy that replaces schedule only once the file is committed.
+    if(!m_db.isOpen() || !m_db.transaction())
+        return false;
+
+    QList<Schedule> items = schedule;
+    QSet<int> kept;
+    for(int i(0);i<items.count();++i)
+    {
+        Schedule &sc = items[i];
+        if(all || sc.scid == -1)
+        {
+            m_insSchedule.addBindValue(sc.stype);
+            m_insSchedule.addBindValue(sc.name);
+            m_insSchedule.addBindValue(i+1);
+            m_insSchedule.exec();
+            sc.scid = m_insSchedule.lastInsertId().toInt();
+            writeItem(sc);
+        }
+        else if(sc.sorder != i+1)
+        {
+            m_updSchedule.addBindValue(sc.name);
+            m_updSchedule.addBindValue(i+1);
+            m_updSchedule.addBindValue(sc.scid);
+            m_updSchedule.exec();
+        }
+        sc.sorder = i+1;
+        kept.insert(sc.scid);
+    }
+
+    // Delete any schedule items from file that have been removed from schedule
+    if(!all)
+    {
+        QList<QPair<int,QString> > removed;
+        QSqlQuery sq(m_db);
+        sq.exec("SELECT id, stype FROM schedule");
+        while(sq.next())
+        {
+            if(!kept.contains(sq.value(0).toInt()))
+                removed.append(qMakePair(sq.value(0).toInt(),sq.value(1).toString()));
+        }
+        for(int i(0);i<removed.count();++i)
+            deleteItem(removed.at(i).first,removed.at(i).second);
+    }
+
+    if(!m_db.commit())
+    {
+        m_db.rollback();
+        return false;
+    }
+    schedule = items;
+    return true;
+}
+
+void ScheduleFile::deleteItem(int scid, const QString &stype)
+{
+    QSqlQuery sq(m_db);
+    sq.prepare("DELETE FROM schedule WHERE id = ?");
+    sq.addBindValue(scid);
+    sq.exec();
+    if(stype != "bible" && stype != "song" && stype != "slideshow" && stype != "media" && stype != "announce")
+        return;
+    sq.prepare(QString("DELETE FROM %1 WHERE scid = ?").arg(stype));
+    sq.addBindValue(scid);
+    sq.exec();
+    if(stype == "slideshow")
+    {
+        sq.prepare("DELETE FROM slides WHERE scid = ?");
+        sq.addBindValue(scid);
+        sq.exec();
+    }
+}
+
+void ScheduleFile::writeItem(const Schedule &sc)
+{
+    if(sc.stype == "bible")
+    {
+        const BibleHistory &b = sc.bible;
+        m_insBible.addBindValue(sc.scid);
+        m_insBible.addBindValue(b.verseIds);
+        m_insBible.addBindValue(b.caption);
+        m_insBible.addBindValue(b.captionLong);
+        m_insBible.exec();
+    }
+    else if(sc.stype == "song")
+    {
+        const Song &s = sc.song;
+        m_insSong.addBindValue(sc.scid);
+        m_insSong.addBindValue(s.songID);
+        m_insSong.addBindValue(s.songbook_id);
+        m_insSong.addBindValue(s.songbook_name);
+        m_insSong.addBindValue(s.number);
+        m_insSong.addBindValue(s.title);
+        m_insSong.addBindValue(s.category);
+        m_insSong.addBindValue(s.tune);
+        m_insSong.addBindValue(s.wordsBy);
+        m_insSong.addBindValue(s.musicBy);
+        m_insSong.addBindValue(s.songText);
+        m_insSong.addBindValue(s.notes);
+        m_insSong.addBindValue(s.usePrivateSettings);
+        m_insSong.addBindValue(s.alignmentV);
+        m_insSong.addBindValue(s.alignmentH);
+        m_insSong.addBindValue((unsigned int)(s.color.rgb()));
+        m_insSong.addBindValue(s.font.toString());
+        m_insSong.addBindValue((unsigned int)(s.infoColor.rgb()));
+        m_insSong.addBindValue(s.infoFont.toString());
+        m_insSong.addBindValue((unsigned int)(s.endingColor.rgb()));
+        m_insSong.addBindValue(s.endingFont.toString());
+        m_insSong.addBindValue(s.useBackground);
+        m_insSong.addBindValue(pixToByte(s.background));
+        m_insSong.addBindValue(s.backgroundName);
+        m_insSong.exec();
+    }
+    else if(sc.stype == "slideshow")
+    {
+        const SlideShow &s = sc.slideshow;
+        m_insSlideShow.addBindValue(sc.scid);
+        m_insSlideShow.addBindValue(s.slideShowId);
+        m_insSlideShow.addBindValue(s.name);
+        m_insSlideShow.addBindValue(s.info);
+        m_insSlideShow.exec();
+        writeSlides(sc.scid,s.slides);
+    }
+    else if(sc.stype == "media")
+    {
+        const VideoInfo &v = sc.media;
+        m_insMedia.addBindValue(sc.scid);
+        m_insMedia.addBindValue(v.fileName);
+        m_insMedia.addBindValue(v.filePath);
+        m_insMedia.addBindValue(v.aspectRatio);
+        m_insMedia.exec();
+    }
+    else if(sc.stype == "announce")
+    {
+        const Announcement &a = sc.announce;
+        m_insAnnounce.addBindValue(sc.scid);
+        m_insAnnounce.addBindValue(a.idNum);
+        m_insAnnounce.addBindValue(a.title);
+        m_insAnnounce.addBindValue(a.text);
+        m_insAnnounce.addBindValue(a.usePrivateSettings);
+        m_insAnnounce.addBindValue(a.useAutoNext);
+        m_insAnnounce.addBindValue(a.loop);
+        m_insAnnounce.addBindValue(a.slideTimer);
+        m_insAnnounce.addBindValue(a.font.toString());
+        m_insAnnounce.addBindValue((unsigned int)(a.color.rgb()));
+        m_insAnnounce.addBindValue(a.useBackground);
+        m_insAnnounce.addBindValue(QByteArray()); // background images of announcements are not kept
+        m_insAnnounce.addBindValue(a.backgroundPath);
+        m_insAnnounce.addBindValue(a.alignmentV);
+        m_insAnnounce.addBindValue(a.alignmentH);
+        m_insAnnounce.exec();
+    }
+}
+
+void ScheduleFile::writeSlides(int scid, const QList<SlideShowItem> &slides)
+{
+    // Rows are inserted in slide order, which is the order they are read back in
+    foreach(const SlideShowItem &si, slides)
+    {
+        m_insSlide.addBindValue(scid);
+        m_insSlide.addBindValue(si.slideId);
+        m_insSlide.addBindValue(si.name);
+        m_insSlide.addBindValue(si.path);
+        m_insSlide.addBindValue(si.order);
+        m_insSlide.addBindValue(si.getImageData());
+        m_insSlide.addBindValue(si.getImageSmallData());
+        m_insSlide.addBindValue(si.getImagePreviewData());
+        m_insSlide.exec();
+    }
+}
+
+class JournalItem
+{
+    // A schedule item as it is handed to the journal thread. Pixmaps belong to the
+    // GUI thread, so the song background and the images of slides that are not in
+    // the database travel as images and are encoded on the journal thread.
+public:
+    JournalItem(const Schedule &item);
+    Schedule sc;
+    QImage background;
+    QList<QImage> slideImages; // full, small and preview of every slide that is not stored
+};
+
+JournalItem::JournalItem(const Schedule &item) :
+    sc(item)
+{
+    if(sc.stype == "song")
+    {
+        background = sc.song.background.toImage();
+        sc.song.background = QPixmap();
+    }
+    else if(sc.stype == "slideshow")
+    {
+        for(int i(0);i<sc.slideshow.slides.count();++i)
+        {
+            SlideShowItem &si = sc.slideshow.slides[i];
+            if(si.isStored)
+                continue;
+            // Imported slides keep the full image only encoded, in imageData
+            slideImages << (si.imageData.isEmpty() ? si.image.toImage() : QImage())
+                        << si.imageSmall.toImage() << si.imagePreview.toImage();
+            si.image = si.imageSmall = si.imagePreview = QPixmap();
+        }
+    }
+}
+
+static void writeJournalItem(QDataStream &ds, const JournalItem &item)
+{
+    const Schedule &sc = item.sc;
+    ds << sc.stype << sc.name;
+    if(sc.stype == "bible")
+    {
+        const BibleHistory &b = sc.bible;
+        ds << b.verseIds << b.caption << b.captionLong;
+    }
+    else if(sc.stype == "song")
+    {
+        const Song &s = sc.song;
+        ds << s.songID << s.songbook_id << s.songbook_name << s.number << s.title << s.category;
+        ds << s.tune << s.wordsBy << s.musicBy << s.songText << s.notes << s.usePrivateSettings;
+        ds << s.alignmentV << s.alignmentH << s.color.rgb() << s.font.toString();
+        ds << s.infoColor.rgb() << s.infoFont.toString() << s.endingColor.rgb() << s.endingFont.toString();
+        ds << s.useBackground << s.backgroundName;
+        ds << (item.background.isNull() ? QByteArray() : imageToByte(item.background));
+    }
+    else if(sc.stype == "slideshow")
+    {
+        // Slides of the database are referred to by id, others carry their images
+        const SlideShow &s = sc.slideshow;
+        ds << s.slideShowId << s.name << s.info << qint32(s.slides.count());
+        int image(0);
+        foreach(const SlideShowItem &si, s.slides)
+        {
+            ds << si.slideId << si.name << si.path << si.order << si.isStored;
+            if(si.isStored)
+                continue;
+            const QImage &full = item.slideImages.at(image);
+            const QImage &small = item.slideImages.at(image+1);
+            const QImage &preview = item.slideImages.at(image+2);
+            image += 3;
+            ds << (si.imageData.isEmpty() ? imageToByte(full) : si.imageData);
+            ds << (si.imageSmallData.isEmpty() ? imageToByte(small,ImageThumbnail) : si.imageSmallData);
+            ds << (si.imagePreviewData.isEmpty() ? imageToByte(preview,ImageThumbnail) : si.imagePreviewData);
+        }
+    }
+    else if(sc.stype == "media")
+    {
+        const VideoInfo &v = sc.media;
+        ds << v.filePath << v.fileName << v.aspectRatio;
+    }
+    else if(sc.stype == "announce")
+    {
+        const Announcement &a = sc.announce;
+        ds << a.idNum << a.title << a.text << a.usePrivateSettings << a.useAutoNext << a.loop;
+        ds << a.slideTimer << a.font.toString() << a.color.rgb() << a.useBackground << a.backgroundPath;
+        ds << a.alignmentV << a.alignmentH;
+    }
+}
+
+static Schedule readJournalItem(QDataStream &ds)
+{
+    QString stype, name, font, infoFont, endingFont;
+    QRgb color, infoColor, endingColor;
+    ds >> stype >> name;
+
+    Schedule sc;
+    if(stype == "bible")
+    {
+        BibleHistory b;
+        ds >> b.verseIds >> b.caption >> b.captionLong;
+        sc = Schedule(b);
+    }
+    else if(stype == "song")
+    {
+        Song s;
+        QByteArray back;
+        ds >> s.songID >> s.songbook_id >> s.songbook_name >> s.number >> s.title >> s.category;
+        ds >> s.tune >> s.wordsBy >> s.musicBy >> s.songText >> s.notes >> s.usePrivateSettings;
+        ds >> s.alignmentV >> s.alignmentH >> color >> font;
+        ds >> infoColor >> infoFont >> endingColor >> endingFont;
+        ds >> s.useBackground >> s.backgroundName >> back;
+        s.color = QColor::fromRgb(color);
+        s.font.fromString(font);
+        s.infoColor = QColor::fromRgb(infoColor);
+        s.infoFont.fromString(infoFont);
+        s.endingColor = QColor::fromRgb(endingColor);
+        s.endingFont.fromString(endingFont);
+        if(!back.isEmpty())
+            s.background.loadFromData(back);
+        sc = Schedule(s);
+    }
+    else if(stype == "slideshow")
+    {
+        SlideShow s;
+        qint32 count;
+        ds >> s.slideShowId >> s.name >> s.info >> count;
+        for(int i(0);i<count && ds.status() == QDataStream::Ok;++i)
+        {
+            SlideShowItem si;
+            ds >> si.slideId >> si.name >> si.path >> si.order >> si.isStored;
+            if(!si.isStored)
+            {
+                ds >> si.imageData >> si.imageSmallData >> si.imagePreviewData;
+                si.imageSmall.loadFromData(si.imageSmallData);
+                si.imagePreview.loadFromData(si.imagePreviewData);
+            }
+            s.slides.append(si);
+        }
+        sc = Schedule(s);
+    }
+    else if(stype == "media")
+    {
+        VideoInfo v;
+        ds >> v.filePath >> v.fileName >> v.aspectRatio;
+        sc = Schedule(v);
+    }
+    else if(stype == "announce")
+    {
+        Announcement a;
+        ds >> a.idNum >> a.title >> a.text >> a.usePrivateSettings >> a.useAutoNext >> a.loop;
+        ds >> a.slideTimer >> font >> color >> a.useBackground >> a.backgroundPath;
+        ds >> a.alignmentV >> a.alignmentH;
+        a.font.fromString(font);
+        a.color = QColor::fromRgb(color);
+        sc = Schedule(a);
+    }
+    sc.name = name;
+    return sc;
+}
+
+static QByteArray frameRecord(const QByteArray &record)
+{
+    // Each record is framed by its size and checksum, so that a record that was
+    // only partly written before a crash can be told apart
+    QByteArray framed;
+    QDataStream ds(&framed,QIODevice::WriteOnly);
+    ds << quint32(record.size()) << quint16(qChecksum(record));
+    framed.append(record);
+    return framed;
+}
+
+static void writeJournal(QString fileName, QByteArray record, bool truncate)
+{
+    // Runs on the journal thread, records are written in the order they were made.
+    // A record is on the disk when this returns, not only in the system cache.
+    if(record.isNull())
+    {
+        QFile::remove(fileName);
+        return;
+    }
+    QFile file(fileName);
+    if(file.open(truncate ? QIODevice::WriteOnly | QIODevice::Truncate : QIODevice::Append))
+    {
+        file.write(frameRecord(record));
+        file.flush();
+#ifdef Q_OS_WIN
+        _commit(file.handle());
+#else
+        fsync(file.handle());
+#endif
+    }
+}
+
+static void writeJournalAdd(QString fileName, JournalItem item)
+{
+    QByteArray data;
+    QDataStream ds(&data,QIODevice::WriteOnly);
+    ds << quint8(ScheduleJournal::Add);
+    writeJournalItem(ds,item);
+    writeJournal(fileName,data,false);
+}
+
+ScheduleJournal::ScheduleJournal()
+{
+    // One thread keeps records in order
+    m_pool.setMaxThreadCount(1);
+}
+
+ScheduleJournal::~ScheduleJournal()
+{
+    m_pool.waitForDone();
+}
+
+void ScheduleJournal::setFileName(const QString &fileName)
+{
+    m_fileName = fileName;
+}
+
+void ScheduleJournal::start(const QString &schedulePath)
+{
+    // Starts over for a schedule that matches its file
+    QByteArray data;
+    QDataStream ds(&data,QIODevice::WriteOnly);
+    ds << quint8(Start) << schedulePath;
+    append(data,true);
+}
+
+void ScheduleJournal::add(const Schedule &sc)
+{
+    // Images are encoded on the journal thread
+    if(m_fileName.isEmpty())
+        return;
+    QtConcurrent::run(&m_pool,writeJournalAdd,m_fileName,JournalItem(sc));
+}
+
+void ScheduleJournal::move(int from, int to)
+{
+    QByteArray data;
+    QDataStream ds(&data,QIODevice::WriteOnly);
+    ds << quint8(Move) << qint32(from) << qint32(to);
+    append(data);
+}
+
+void ScheduleJournal::remove(int row)
+{
+    QByteArray data;
+    QDataStream ds(&data,QIODevice::WriteOnly);
+    ds << quint8(Remove) << qint32(row);
+    append(data);
+}
+
+void ScheduleJournal::clear()
+{
+    QByteArray data;
+    QDataStream ds(&data,QIODevice::WriteOnly);
+    ds << quint8(Clear);
+    append(data);
+}
+
+void ScheduleJournal::discard()
+{
+    if(m_fileName.isEmpty())
+        return;
+    QtConcurrent::run(&m_pool,writeJournal,m_fileName,QByteArray(),false);
+}
+
+void ScheduleJournal::append(const QByteArray &record, bool truncate)
+{
+    if(m_fileName.isEmpty())
+        return;
+    QtConcurrent::run(&m_pool,writeJournal,m_fileName,record,truncate);
+}
+
+QList<QByteArray> ScheduleJournal::readRecords(const QString &fileName)
+{
+    QList<QByteArray> records;
+    QFile file(fileName);
+    if(!file.open(QIODevice::ReadOnly))
+        return records;
+    QByteArray all = file.readAll();
+    int pos(0);
+    while(pos + 6 <= all.size())
+    {
+        QDataStream ds(all.mid(pos,6));
+        quint32 size;
+        quint16 sum;
+        ds >> size >> sum;
+        if(size > quint32(all.size() - pos - 6))
+            break;
+        QByteArray record = all.mid(pos+6,size);
+        if(qChecksum(record) != sum)
+            break;
+        records.append(record);
+        pos += 6 + size;
+    }
+    return records;
+}
+
+bool ScheduleJournal::readStart(const QString &fileName, QString &schedulePath)
+{
+    // True when the journal exists and names the schedule it was started for
+    QList<QByteArray> records = readRecords(fileName);
+    if(records.isEmpty())
+        return false;
+    QDataStream ds(records.first());
+    quint8 op;
+    ds >> op;
+    if(op != Start)
+        return false;
+    ds >> schedulePath;
+    return ds.status() == QDataStream::Ok;
+}
+
+int ScheduleJournal::replay(const QString &fileName, QList<Schedule> &schedule)
+{
+    // Applies the recorded edits to the schedule as it was read from its file,
+    // returns the number of edits applied
+    QList<QByteArray> records = readRecords(fileName);
+    int edits(0);
+    for(int i(1);i<records.count();++i)
+    {
+        QDataStream ds(records.at(i));
+        quint8 op;
+        qint32 from, to;
+        ds >> op;
+        switch (op) {
+        case Add:
+        {
+            Schedule sc = readJournalItem(ds);
+            if(ds.status() != QDataStream::Ok || sc.stype.isEmpty())
+                return edits;
+            schedule.append(sc);
+            break;
+        }
+        case Move:
+            ds >> from >> to;
+            if(from < 0 || from >= schedule.count() || to < 0 || to >= schedule.count())
+                return edits;
+            schedule.move(from,to);
+            break;
+        case Remove:
+            ds >> from;
+            if(from < 0 || from >= schedule.count())
+                return edits;
+            schedule.removeAt(from);
+            break;
+        case Clear:
+            schedule.clear();
+            break;
+        default:
+            return edits;
+        }
+        ++edits;
+    }
+    return edits;
+}
@@ -17,6 +17,7 @@
 //
 ***************************************************************************/
 
+#include <QDataStream>
 #include "../headers/settings.hpp"
 
 TextSettingsBase::TextSettingsBase()
@@ -732,17 +733,30 @@ GeneralSettings::GeneralSettings()
 {
     // Apply General Defauls
     displayIsOnTop = false;
-    displayScreen = 0;
-    displayScreen2 = -1; // interger "-1" mean "None" or not to display
-    displayScreen3 = -1;
-    displayScreen4 = -1;
+    // Primary display on the first screen, the others are not shown
+    outputs << OutputSettings(0,1) << OutputSettings(-1,2) << OutputSettings(-1,3) << OutputSettings(-1,4);
     currentThemeId = 0;
     displayOnStartUp = false;
+    useNativeText = false;
+    useMediaFiles = false;
+    autosaveSchedule = false;
     settingsChangedAll = false;
     settingsChangedMulti = false;
     settingsChangedSingle = false;
 }
 
+OutputSettings::OutputSettings(int scr, int display)
+{
+    screen = scr;
+    themeDisplay = display;
+    content = OC_ALL;
+}
+
+bool OutputSettings::operator==(const OutputSettings &other) const
+{
+    return screen == other.screen && themeDisplay == other.themeDisplay && content == other.content;
+}
+
 DisplayControlsSettings::DisplayControlsSettings()
 {
     buttonSize = 3; // 0=16,1=24,2=32,3=48,4=64,5=96
@@ -783,277 +797,346 @@ Settings::Settings()
     isSpClosing = false;
 }
 
+// Settings are stored as one binary section per settings class in SettingsData.
+// Fields are only ever appended to a section, and its version is raised when
+// they are. A section is read up to the version it was written with, fields it
+// does not have keep their defaults. A section written by a newer version is read
+// as far as this version knows it, and never written back.
+static int sectionVersion(const QString &name)
+{
+    // Layout version that this version writes, per section
+    if(name == "general")
+        return 2; // 2 - display outputs
+    return 1;
+}
+
+static void readFields(QDataStream &ds, int version, GeneralSettings &g)
+{
+    // Version 1 only had the screens of the four display screens
+    ds >> g.displayIsOnTop >> g.displayOnStartUp >> g.useNativeText >> g.useMediaFiles >> g.autosaveSchedule;
+    ds >> g.currentThemeId;
+    for(int i(0);i<4;++i)
+    {
+        int screen;
+        ds >> screen;
+        while(g.outputs.count() <= i)
+            g.outputs << OutputSettings(-1,i+1);
+        g.outputs[i].screen = screen;
+    }
+    ds >> g.displayControls.buttonSize >> g.displayControls.alignmentV >> g.displayControls.alignmentH;
+    ds >> g.displayControls.opacity;
+    if(version >= 2)
+    {
+        qint32 count;
+        ds >> count;
+        QList<OutputSettings> outputs;
+        for(int i(0);i<count && ds.status() == QDataStream::Ok;++i)
+        {
+            OutputSettings o;
+            ds >> o.screen >> o.themeDisplay >> o.content;
+            outputs << o;
+        }
+        if(!outputs.isEmpty())
+            g.outputs = outputs;
+    }
+}
+
+static void writeFields(QDataStream &ds, const GeneralSettings &g)
+{
+    ds << g.displayIsOnTop << g.displayOnStartUp << g.useNativeText << g.useMediaFiles << g.autosaveSchedule;
+    ds << g.currentThemeId;
+    for(int i(0);i<4;++i)
+        ds << (i < g.outputs.count() ? g.outputs.at(i).screen : -1);
+    ds << g.displayControls.buttonSize << g.displayControls.alignmentV << g.displayControls.alignmentH;
+    ds << g.displayControls.opacity;
+    ds << qint32(g.outputs.count());
+    foreach(const OutputSettings &o, g.outputs)
+        ds << o.screen << o.themeDisplay << o.content;
+}
+
+static void readFields(QDataStream &ds, int version, SpSettings &sp)
+{
+    Q_UNUSED(version);
+    ds >> sp.spSplitter >> sp.bibleHiddenSplitter >> sp.bibleShowSplitter >> sp.songSplitter;
+    ds >> sp.uiTranslation >> sp.isWindowMaximized;
+}
+
+static void writeFields(QDataStream &ds, const SpSettings &sp)
+{
+    ds << sp.spSplitter << sp.bibleHiddenSplitter << sp.bibleShowSplitter << sp.songSplitter;
+    ds << sp.uiTranslation << sp.isWindowMaximized;
+}
+
+static void readFields(QDataStream &ds, int version, BibleVersionSettings &b)
+{
+    Q_UNUSED(version);
+    ds >> b.primaryBible >> b.secondaryBible >> b.trinaryBible >> b.operatorBible;
+}
+
+static void writeFields(QDataStream &ds, const BibleVersionSettings &b)
+{
+    ds << b.primaryBible << b.secondaryBible << b.trinaryBible << b.operatorBible;
+}
+
+static void readFields(QDataStream &ds, int version, SlideShowSettings &ss)
+{
+    Q_UNUSED(version);
+    ds >> ss.expandSmall >> ss.fitType >> ss.resize >> ss.boundType >> ss.boundWidth;
+}
+
+static void writeFields(QDataStream &ds, const SlideShowSettings &ss)
+{
+    ds << ss.expandSmall << ss.fitType << ss.resize << ss.boundType << ss.boundWidth;
+}
+
+template <typename T>
+static bool readSection(const QByteArray &data, int version, T &sets)
+{
+    // A section is only taken when all of it could be read
+    T s = sets;
+    QDataStream ds(data);
+    ds.setVersion(QDataStream::Qt_6_0);
+    readFields(ds,version,s);
+    if(ds.status() != QDataStream::Ok)
+        return false;
+    sets = s;
+    return true;
+}
+
+template <typename T>
+static QByteArray writeSection(const T &sets)
+{
+    QByteArray data;
+    QDataStream ds(&data,QIODevice::WriteOnly);
+    ds.setVersion(QDataStream::Qt_6_0);
+    writeFields(ds,sets);
+    return data;
+}
+
+void Settings::createTables(QSqlQuery &sq)
+{
+    sq.exec("CREATE TABLE IF NOT EXISTS 'SettingsData' ('section' TEXT PRIMARY KEY, 'version' INTEGER, 'data' BLOB)");
+}
+
 void Settings::loadSettings()
 {
-    QString t,n,v,s,sets; // type, name, value, userValues
-    QStringList set,values;
-    bool dataGenOk,dataSpOk,dataB1Ok,dataB2Ok,dataB3Ok,dataB4Ok, dataPixOk;
-    dataGenOk = dataSpOk = dataB1Ok = dataB2Ok = dataB3Ok = dataB4Ok = dataPixOk = false;
+    // Only reads, see upgradeSections() for sections of an older layout
+    QString name;
+    QByteArray data;
+    int version;
+    bool ok;
     QSqlQuery sq;
-    sq.exec(QString("SELECT type, sets FROM Settings "));
-    while (sq.next())
+    sq.exec("SELECT section, version, data FROM SettingsData");
+    while(sq.next())
     {
-        t = sq.value(0).toString();
-        sets = sq.value(1).toString();
+        name = sq.value(0).toString();
+        version = sq.value(1).toInt();
+        data = sq.value(2).toByteArray();
+
+        if(name == "general")
+            ok = readSection(data,version,general);
+        else if(name == "spMain")
+            ok = readSection(data,version,spMain);
+        else if(name == "bible1")
+            ok = readSection(data,version,bibleSets);
+        else if(name == "bible2")
+            ok = readSection(data,version,bibleSets2);
+        else if(name == "bible3")
+            ok = readSection(data,version,bibleSets3);
+        else if(name == "bible4")
+            ok = readSection(data,version,bibleSets4);
+        else if(name == "pix")
+            ok = readSection(data,version,slideSets);
+        else
+            ok = false;
+
+        // Sections written with an older layout are written again in the current one
+        m_versions.insert(name,version);
+        if(ok && version >= sectionVersion(name))
+            m_saved.insert(name,data);
+    }
+}
 
-        if(t == "general") // set general setting values
-        {
-            dataGenOk = true;
-            values = sets.split("\n");
-            for(int i(0);i<values.count();++i)
-            {
-                s = values.at(i);
-                set = s.split("=");
-                n = set.at(0).trimmed();
-                v = set.at(1).trimmed();
-                if(n == "displayIsOnTop")
-                    general.displayIsOnTop = (v=="true");
-                else if(n == "displayOnStartUp")
-                    general.displayOnStartUp = (v=="true");
-                else if(n == "currentThemeId")
-                    general.currentThemeId = v.toInt();
-                else if (n == "displayScreen")
-                    general.displayScreen = v.toInt();
-                // Display Screen 2 settings
-                else if (n == "displayScreen2")
-                    general.displayScreen2 = v.toInt();
-                // End display screen 2 settings
-                else if (n == "displayScreen3")
-                    general.displayScreen3 = v.toInt();
-                else if (n == "displayScreen4")
-                    general.displayScreen4 = v.toInt();
-                else if (n == "dcIconSize")
-                    general.displayControls.buttonSize = v.toInt();
-                else if (n == "dcAlignment")
-                {
-                    QStringList alinglist = v.split(",");
-                    general.displayControls.alignmentV = alinglist.at(0).toInt();
-                    general.displayControls.alignmentH = alinglist.at(1).toInt();
-                }
-                else if (n == "dcOpacity")
-                    general.displayControls.opacity = v.toDouble();
-            }
-        }
-        else if(t == "spMain")
-        {
-            dataSpOk = true;
-            values = sets.split("\n");
-            for(int i(0);i<values.count();++i)
-            {
-                s = values.at(i);
-                set = s.split("=");
-                n = set.at(0).trimmed();
-                v = set.at(1).trimmed();
-
-                if(n=="spSplitter")
-                    spMain.spSplitter = textToByt(v);
-                else if(n=="bibleHiddenSplitter")
-                    spMain.bibleHiddenSplitter = textToByt(v);
-                else if(n=="bibleShowSplitter")
-                    spMain.bibleShowSplitter = textToByt(v);
-                else if(n=="songSplitter")
-                    spMain.songSplitter = textToByt(v);
-                else if(n=="uiTranslation")
-                    spMain.uiTranslation = v;
-                else if(n=="isWindowMaximized")
-                    spMain.isWindowMaximized = (v=="true");
-            }
-        }
-        else if(t == "bible1")
+void Settings::upgradeSections()
+{
+    // Once at startup, writes sections that are missing or have an older layout
+    Settings sets;
+    sets.loadSettings();
+    sets.saveSettings();
+}
+
+bool Settings::saveSettings()
+{
+    // Only sections that changed since they were loaded or last saved are written.
+    // Returns false when a changed section could not be written.
+    QList<QPair<QString,QByteArray> > sections;
+    sections << qMakePair(QString("general"),writeSection(general));
+    sections << qMakePair(QString("spMain"),writeSection(spMain));
+    sections << qMakePair(QString("bible1"),writeSection(bibleSets));
+    sections << qMakePair(QString("bible2"),writeSection(bibleSets2));
+    sections << qMakePair(QString("bible3"),writeSection(bibleSets3));
+    sections << qMakePair(QString("bible4"),writeSection(bibleSets4));
+    sections << qMakePair(QString("pix"),writeSection(slideSets));
+
+    QSqlQuery sq;
+    bool inTransaction = false;
+    bool ok = true;
+    QList<QPair<QString,QByteArray> > written;
+    m_unsaved.clear();
+    for(int i(0);i<sections.count() && ok;++i)
+    {
+        const QString &name = sections.at(i).first;
+        const QByteArray &data = sections.at(i).second;
+        if(m_saved.contains(name) && m_saved.value(name) == data)
+            continue;
+        if(m_versions.value(name) > sectionVersion(name))
         {
-            dataB1Ok = true;
-            values = sets.split("\n");
-            for(int i(0);i<values.count();++i)
-            {
-                s = values.at(i);
-                set = s.split("=");
-                n = set.at(0).trimmed();
-                v = set.at(1).trimmed();
-                if(n == "primary")
-                    bibleSets.primaryBible = v;
-                else if(n == "secondary")
-                    bibleSets.secondaryBible = v;
-                else if (n == "trinary")
-                    bibleSets.trinaryBible = v;
-                else if (n == "operator")
-                    bibleSets.operatorBible = v;
-            }
+            // Writing it would lose the fields of the newer version
+            qWarning()<<"Settings section"<<name<<"is from a newer version, changes are not saved";
+            m_unsaved << name;
+            continue;
         }
-        else if(t == "bible2")
+
+        // Inside a transaction of the caller this one is not started, the caller commits
+        if(!inTransaction && written.isEmpty())
+            inTransaction = QSqlDatabase::database().transaction();
+        sq.prepare("INSERT OR REPLACE INTO SettingsData (section, version, data) VALUES (?,?,?)");
+        sq.addBindValue(name);
+        sq.addBindValue(sectionVersion(name));
+        sq.addBindValue(data);
+        ok = sq.exec();
+        if(ok)
+            written << sections.at(i);
+    }
+    if(inTransaction)
+    {
+        if(ok)
+            ok = QSqlDatabase::database().commit();
+        else
+            QSqlDatabase::database().rollback();
+    }
+    if(!ok)
+        return false;
+
+    for(int i(0);i<written.count();++i)
+    {
+        m_saved.insert(written.at(i).first,written.at(i).second);
+        m_versions.insert(written.at(i).first,sectionVersion(written.at(i).first));
+    }
+    return true;
+}
+
+static QHash<QString,QString> textValues(const QString &sets)
+{
+    // "name = value" lines, lines without "=" are skipped
+    QHash<QString,QString> values;
+    foreach(const QString &line, sets.split("\n"))
+    {
+        int i = line.indexOf('=');
+        if(i > 0)
+            values.insert(line.left(i).trimmed(),line.mid(i+1).trimmed());
+    }
+    return values;
+}
+
+static void textValue(const QHash<QString,QString> &values, const QString &name, bool &value)
+{
+    if(values.contains(name))
+        value = (values.value(name) == "true");
+}
+
+static void textValue(const QHash<QString,QString> &values, const QString &name, int &value)
+{
+    bool ok;
+    int v = values.value(name).toInt(&ok);
+    if(ok)
+        value = v;
+}
+
+static void textValue(const QHash<QString,QString> &values, const QString &name, QString &value)
+{
+    if(values.contains(name))
+        value = values.value(name);
+}
+
+static void textValue(const QHash<QString,QString> &values, const QString &name, QByteArray &value)
+{
+    // Splitter states were written as hex
+    if(values.contains(name))
+        value = QByteArray::fromHex(values.value(name).toLatin1());
+}
+
+void Settings::readTextSettings(QSqlQuery &sq)
+{
+    // Settings as they were stored before database version 5
+    QString t;
+    QHash<QString,QString> v;
+    sq.exec("SELECT type, sets FROM Settings");
+    while(sq.next())
+    {
+        t = sq.value(0).toString();
+        v = textValues(sq.value(1).toString());
+
+        if(t == "general")
         {
-            dataB2Ok = true;
-            values = sets.split("\n");
-            for(int i(0);i<values.count();++i)
+            textValue(v,"displayIsOnTop",general.displayIsOnTop);
+            textValue(v,"displayOnStartUp",general.displayOnStartUp);
+            textValue(v,"useNativeText",general.useNativeText);
+            textValue(v,"useMediaFiles",general.useMediaFiles);
+            textValue(v,"autosaveSchedule",general.autosaveSchedule);
+            textValue(v,"currentThemeId",general.currentThemeId);
+            textValue(v,"displayScreen",general.outputs[0].screen);
+            textValue(v,"displayScreen2",general.outputs[1].screen);
+            textValue(v,"displayScreen3",general.outputs[2].screen);
+            textValue(v,"displayScreen4",general.outputs[3].screen);
+            textValue(v,"dcIconSize",general.displayControls.buttonSize);
+            QStringList alignment = v.value("dcAlignment").split(",");
+            if(alignment.count() == 2)
             {
-                s = values.at(i);
-                set = s.split("=");
-                n = set.at(0).trimmed();
-                v = set.at(1).trimmed();
-                if(n == "primary")
-                    bibleSets2.primaryBible = v;
-                else if(n == "secondary")
-                    bibleSets2.secondaryBible = v;
-                else if (n == "trinary")
-                    bibleSets2.trinaryBible = v;
+                general.displayControls.alignmentV = alignment.at(0).toInt();
+                general.displayControls.alignmentH = alignment.at(1).toInt();
             }
+            if(v.contains("dcOpacity"))
+                general.displayControls.opacity = v.value("dcOpacity").toDouble();
         }
-        else if(t == "bible3")
+        else if(t == "spMain")
         {
-            dataB3Ok = true;
-            values = sets.split("\n");
-            for(int i(0);i<values.count();++i)
-            {
-                s = values.at(i);
-                set = s.split("=");
-                n = set.at(0).trimmed();
-                v = set.at(1).trimmed();
-                if(n == "primary")
-                    bibleSets3.primaryBible = v;
-                else if(n == "secondary")
-                    bibleSets3.secondaryBible = v;
-                else if (n == "trinary")
-                    bibleSets3.trinaryBible = v;
-            }
+            textValue(v,"spSplitter",spMain.spSplitter);
+            textValue(v,"bibleHiddenSplitter",spMain.bibleHiddenSplitter);
+            textValue(v,"bibleShowSplitter",spMain.bibleShowSplitter);
+            textValue(v,"songSplitter",spMain.songSplitter);
+            textValue(v,"uiTranslation",spMain.uiTranslation);
+            textValue(v,"isWindowMaximized",spMain.isWindowMaximized);
         }
-        else if(t == "bible4")
+        else if(t == "bible1" || t == "bible2" || t == "bible3" || t == "bible4")
         {
-            dataB4Ok = true;
-            values = sets.split("\n");
-            for(int i(0);i<values.count();++i)
-            {
-                s = values.at(i);
-                set = s.split("=");
-                n = set.at(0).trimmed();
-                v = set.at(1).trimmed();
-                if(n == "primary")
-                    bibleSets4.primaryBible = v;
-                else if(n == "secondary")
-                    bibleSets4.secondaryBible = v;
-                else if (n == "trinary")
-                    bibleSets4.trinaryBible = v;
-            }
+            BibleVersionSettings &b = (t == "bible1") ? bibleSets : (t == "bible2") ? bibleSets2
+                                                                  : (t == "bible3") ? bibleSets3 : bibleSets4;
+            textValue(v,"primary",b.primaryBible);
+            textValue(v,"secondary",b.secondaryBible);
+            textValue(v,"trinary",b.trinaryBible);
+            if(t == "bible1")
+                textValue(v,"operator",b.operatorBible);
         }
         else if(t == "pix")
         {
-            dataPixOk = true;
-            values = sets.split("\n");
-            for(int i(0);i<values.count();++i)
-            {
-                s = values.at(i);
-                set = s.split("=");
-                n = set.at(0).trimmed();
-                v = set.at(1).trimmed();
-                if(n == "expandSmall")
-                    slideSets.expandSmall = (v == "true");
-                else if(n == "fitType")
-                    slideSets.fitType = v.toInt();
-                else if (n == "resize")
-                    slideSets.resize = (v == "true");
-                else if (n == "boundType")
-                    slideSets.boundType = v.toInt();
-                else if (n == "boundWidth")
-                    slideSets.boundWidth = v.toInt();
-            }
+            textValue(v,"expandSmall",slideSets.expandSmall);
+            textValue(v,"fitType",slideSets.fitType);
+            textValue(v,"resize",slideSets.resize);
+            textValue(v,"boundType",slideSets.boundType);
+            textValue(v,"boundWidth",slideSets.boundWidth);
         }
     }
-
-    // if no data exist, then create
-    if(!dataGenOk || !dataSpOk || !dataB1Ok || !dataB2Ok || !dataB3Ok || !dataB4Ok|| !dataPixOk)
-        saveNewSettings();
 }
 
-void Settings::saveSettings()
-{
-    QSqlQuery sq;
-    QString gset,spset,b1set,b2set,b3set,b4set,pset;//general,bible,song,annouce,spmain
-
-    // **** Prepare general settings ***************************************
-    if(general.displayIsOnTop)
-        gset = "displayIsOnTop = true";
-    else
-        gset = "displayIsOnTop = false";
-    if(general.displayOnStartUp)
-        gset += "\ndisplayOnStartUp = true";
-    else
-        gset += "\ndisplayOnStartUp = false";
-    gset += "\ncurrentThemeId = " + QString::number(general.currentThemeId);
-    gset += "\ndisplayScreen = " + QString::number(general.displayScreen);
-    gset += "\ndisplayScreen2 = " + QString::number(general.displayScreen2);
-    gset += "\ndisplayScreen3 = " + QString::number(general.displayScreen3);
-    gset += "\ndisplayScreen4 = " + QString::number(general.displayScreen4);
-    gset += "\ndcIconSize = " + QString::number(general.displayControls.buttonSize);
-    gset += QString("\ndcAlignment = %1,%2").arg(general.displayControls.alignmentV).arg(general.displayControls.alignmentH);
-    gset += "\ndcOpacity = " + QString::number(general.displayControls.opacity);
-
-    // **** prepare softProjector main settings
-    spset += "spSplitter = " + spMain.spSplitter.toHex();
-    spset += "\nbibleHiddenSplitter = " + spMain.bibleHiddenSplitter.toHex();
-    spset += "\nbibleShowSplitter = " + spMain.bibleShowSplitter.toHex();
-    spset += "\nsongSplitter = " + spMain.songSplitter.toHex();
-    spset += "\nuiTranslation = " + spMain.uiTranslation;
-    if(spMain.isWindowMaximized)
-        spset += "\nisWindowMaximized = true";
-    else
-        spset += "\nisWindowMaximized = false";
-
-    // **** prepare screen 1 bible versions
-    b1set = "primary = " + bibleSets.primaryBible;
-    b1set += "\nsecondary = " + bibleSets.secondaryBible;
-    b1set += "\ntrinary = " + bibleSets.trinaryBible;
-    b1set += "\noperator = " + bibleSets.operatorBible;
-
-    // **** prepare screen 2 bible versions
-    b2set = "primary = " + bibleSets2.primaryBible;
-    b2set += "\nsecondary = " + bibleSets2.secondaryBible;
-    b2set += "\ntrinary = " + bibleSets2.trinaryBible;
-
-    // **** prepare screen 3 bible versions
-    b3set = "primary = " + bibleSets3.primaryBible;
-    b3set += "\nsecondary = " + bibleSets3.secondaryBible;
-    b3set += "\ntrinary = " + bibleSets3.trinaryBible;
-
-    // **** prepare screen 4 bible versions
-    b4set = "primary = " + bibleSets4.primaryBible;
-    b4set += "\nsecondary = " + bibleSets4.secondaryBible;
-    b4set += "\ntrinary = " + bibleSets4.trinaryBible;
-
-    // **** prepare pix settings
-    if(slideSets.expandSmall)
-        pset = "expandSmall = true";
-    else
-        pset = "expandSmall = false";
-    pset += "\nfitType = " + QString::number(slideSets.fitType);
-    if(slideSets.resize)
-        pset += "\nresize = true";
-    else
-        pset += "\nresize = false";
-    pset += "\nboundType = " + QString::number(slideSets.boundType);
-    pset += "\nboundWidth = " + QString::number(slideSets.boundWidth);
-
-    sq.exec(QString("UPDATE Settings SET sets = '%1' WHERE type = 'general'").arg(gset));
-    sq.exec(QString("UPDATE Settings SET sets = '%1' WHERE type = 'spMain'").arg(spset));
-    sq.exec(QString("UPDATE Settings SET sets = '%1' WHERE type = 'bible1'").arg(b1set));
-    sq.exec(QString("UPDATE Settings SET sets = '%1' WHERE type = 'bible2'").arg(b2set));
-    sq.exec(QString("UPDATE Settings SET sets = '%1' WHERE type = 'bible3'").arg(b3set));
-    sq.exec(QString("UPDATE Settings SET sets = '%1' WHERE type = 'bible4'").arg(b4set));
-    sq.exec(QString("UPDATE Settings SET sets = '%1' WHERE type = 'pix'").arg(pset));
-}
-
-void Settings::saveNewSettings()
+bool Settings::convertTextSettings()
 {
+    // Moves the text settings into SettingsData, once, when the database is upgraded.
+    // The old table is only dropped when every section was written.
     QSqlQuery sq;
-    sq.exec("INSERT OR REPLACE INTO Settings (type, sets) VALUES ('general', 'n=v')");
-    sq.exec("INSERT OR REPLACE INTO Settings (type, sets) VALUES ('spMain', 'n=v')");
-    sq.exec("INSERT OR REPLACE INTO Settings (type, sets) VALUES ('bible1', 'n=v')");
-    sq.exec("INSERT OR REPLACE INTO Settings (type, sets) VALUES ('bible2', 'n=v')");
-    sq.exec("INSERT OR REPLACE INTO Settings (type, sets) VALUES ('bible3', 'n=v')");
-    sq.exec("INSERT OR REPLACE INTO Settings (type, sets) VALUES ('bible4', 'n=v')");
-    sq.exec("INSERT OR REPLACE INTO Settings (type, sets) VALUES ('pix', 'n=v')");
-
-    saveSettings();
-}
-
-QByteArray Settings::textToByt(QString text)
-{
-    return text.toUtf8();
+    Settings sets;
+    sets.readTextSettings(sq);
+    if(!sets.saveSettings())
+        return false;
+    return sq.exec("DROP TABLE IF EXISTS Settings");
 }
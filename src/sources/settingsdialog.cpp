@@ -67,6 +67,7 @@ void SettingsDialog::loadSettings(GeneralSettings &sets, Theme &thm, SlideShowSe
 {
     gsettings = sets;
     theme = thm;
+    theme.loadBackgrounds(); // the theme editor shows all of them
     bsettings = bsets;
     bsettings2 = bsets2;
     bsettings3 = bsets3;
@@ -75,10 +76,7 @@ void SettingsDialog::loadSettings(GeneralSettings &sets, Theme &thm, SlideShowSe
 
     // remember main display window setting if they will be changed
     is_always_on_top = gsettings.displayIsOnTop;
-    current_display_screen = gsettings.displayScreen;
-    currentDisplayScreen2 = gsettings.displayScreen2;
-    currentDisplayScreen3 = gsettings.displayScreen3;
-    currentDisplayScreen4 = gsettings.displayScreen4;
+    currentOutputs = gsettings.outputs;
 
     // Set individual items
     generalSettingswidget->setSettings(gsettings);
@@ -166,12 +164,9 @@ void SettingsDialog::applySettings()
     // Apply settings
     emit updateSettings(gsettings,theme,ssettings,bsettings,bsettings2,bsettings3,bsettings4);
 
-    // Update <display_on_top> only when changed, or when screen location has been changed
+    // Update <display_on_top> only when changed, or when display outputs have been changed
     if(is_always_on_top!=gsettings.displayIsOnTop
-            || current_display_screen!=gsettings.displayScreen
-            || currentDisplayScreen2!=gsettings.displayScreen2
-            || currentDisplayScreen3!=gsettings.displayScreen3
-            || currentDisplayScreen4!=gsettings.displayScreen4)
+            || currentOutputs!=gsettings.outputs)
     {
         emit positionsDisplayWindow();
     }
@@ -184,10 +179,7 @@ void SettingsDialog::applySettings()
 
     // reset display holders
     is_always_on_top = gsettings.displayIsOnTop;
-    current_display_screen = gsettings.displayScreen;
-    currentDisplayScreen2 = gsettings.displayScreen2;
-    currentDisplayScreen3 = gsettings.displayScreen3;
-    currentDisplayScreen4 = gsettings.displayScreen4;
+    currentOutputs = gsettings.outputs;
 }
 
 void SettingsDialog::getThemes()
@@ -215,6 +207,7 @@ void SettingsDialog::changeTheme(int theme_id)
     // Then load changed theme
     theme.setThemeId(theme_id);
     theme.loadTheme();
+    theme.loadBackgrounds();
     setThemes();
 }
 
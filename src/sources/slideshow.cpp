@@ -17,12 +17,336 @@
 //
 ***************************************************************************/
 
+#include <QtConcurrent>
 #include "../headers/slideshow.hpp"
+#include "../headers/assetstore.hpp"
+#include "../headers/dbservice.hpp"
 
 SlideShowItem::SlideShowItem()
 {
     slideId = -1;
     order = -1;
+    isStored = false;
+    imageKey = 0;
+}
+
+QPixmap SlideShowItem::getImage() const
+{
+    if(isStored && image.isNull())
+        return SlideImageCache::instance()->image(slideId,SlideImageCache::Full);
+    if(image.isNull() && !imageData.isEmpty())
+        return SlideImageCache::instance()->decoded(imageKey,imageData);
+    return image;
+}
+
+QPixmap SlideShowItem::getImageSmall() const
+{
+    if(isStored && imageSmall.isNull())
+        return SlideImageCache::instance()->image(slideId,SlideImageCache::Small);
+    return imageSmall;
+}
+
+QPixmap SlideShowItem::getImagePreview() const
+{
+    if(isStored && imagePreview.isNull())
+        return SlideImageCache::instance()->image(slideId,SlideImageCache::Preview);
+    return imagePreview;
+}
+
+QByteArray SlideShowItem::getImageData() const
+{
+    if(!imageData.isEmpty())
+        return imageData;
+    if(isStored && image.isNull())
+        return SlideImageCache::instance()->data(slideId,SlideImageCache::Full);
+    return pixToByte(image);
+}
+
+QByteArray SlideShowItem::getImageSmallData() const
+{
+    if(!imageSmallData.isEmpty())
+        return imageSmallData;
+    if(isStored && imageSmall.isNull())
+        return SlideImageCache::instance()->data(slideId,SlideImageCache::Small);
+    return pixToByte(imageSmall,ImageThumbnail);
+}
+
+QByteArray SlideShowItem::getImagePreviewData() const
+{
+    if(!imagePreviewData.isEmpty())
+        return imagePreviewData;
+    if(isStored && imagePreview.isNull())
+        return SlideImageCache::instance()->data(slideId,SlideImageCache::Preview);
+    return pixToByte(imagePreview,ImageThumbnail);
+}
+
+QListWidgetItem *SlideShowItem::createListItem() const
+{
+    QListWidgetItem *itm = new QListWidgetItem;
+    if(isStored && imageSmall.isNull())
+        itm->setData(Qt::UserRole,slideId); // SlideIconDelegate provides the icon
+    else
+        itm->setIcon(QIcon(imageSmall));
+    return itm;
+}
+
+static qint64 pendingKey(int slideId, int kind)
+{
+    return (qint64(slideId) << 2) | kind;
+}
+
+SlideImageCache *SlideImageCache::instance()
+{
+    static SlideImageCache cache;
+    return &cache;
+}
+
+SlideImageCache::SlideImageCache()
+{
+    m_fullImages.setMaxCost(128*1024);
+    m_thumbs.setMaxCost(16*1024);
+    m_thumbPix.setMaxCost(16*1024);
+    m_fullPix.setMaxCost(128*1024);
+    m_lastDataKey = 0;
+
+    // One background thread that stays alive, so that its database connection is reused
+    m_pool.setMaxThreadCount(1);
+    m_pool.setExpiryTimeout(-1);
+    m_dbPath = QSqlDatabase::database().databaseName();
+}
+
+QByteArray SlideImageCache::read(int slideId, Kind kind, QSqlDatabase db, QString *mediaFile)
+{
+    // When the image is kept in a media file and mediaFile is given, only the
+    // file path is returned through it so that the caller can map the file
+    QString column("pix");
+    if(kind == Small)
+        column = "pix_small";
+    else if(kind == Preview)
+        column = "pix_prev";
+
+    // Images are either stored in Assets or, in rows not converted yet, in place
+    QSqlQuery sq(db);
+    sq.prepare(QString("SELECT s.%1, a.hash, a.data FROM Slides s LEFT JOIN Assets a "
+                       "ON typeof(s.%1) = 'integer' AND a.id = s.%1 WHERE s.id = ?").arg(column));
+    sq.addBindValue(slideId);
+    if(!sq.exec() || !sq.first())
+        return QByteArray();
+    if(sq.value(1).isNull())
+        return sq.value(0).toByteArray();
+    if(!sq.value(2).isNull())
+        return sq.value(2).toByteArray();
+
+    QString path = AssetStore::mediaPath(m_dbPath,sq.value(1).toString());
+    if(mediaFile)
+    {
+        *mediaFile = path;
+        return QByteArray();
+    }
+    return AssetStore::readMediaFile(path);
+}
+
+QImage SlideImageCache::decode(int slideId, Kind kind, QSqlDatabase db)
+{
+    // Renditions written by older versions may be larger than they are shown
+    QSize bound;
+    if(kind == Small)
+        bound = QSize(100,100);
+    else if(kind == Preview)
+        bound = QSize(400,400);
+
+    QString mediaFile;
+    QByteArray data = read(slideId,kind,db,&mediaFile);
+    if(!mediaFile.isEmpty())
+        return AssetStore::decodeMediaFile(mediaFile,bound);
+    return byteToImage(data,bound);
+}
+
+QByteArray SlideImageCache::data(int slideId, Kind kind)
+{
+    return read(slideId,kind,QSqlDatabase::database());
+}
+
+QPixmap SlideImageCache::image(int slideId, Kind kind)
+{
+    if(kind == Small)
+    {
+        QPixmap pix = thumbnail(slideId);
+        if(!pix.isNull())
+            return pix;
+    }
+    else if(kind == Full)
+    {
+        // The same pixmap every time, so that its scaled copy is found by the display
+        if(QPixmap *pix = m_fullPix.object(slideId))
+            return *pix;
+
+        QImage img;
+        {
+            // A prefetch that already runs is waited for, one that is still queued
+            // is taken over, so the slide is not decoded twice
+            QMutexLocker locker(&m_mutex);
+            qint64 key = pendingKey(slideId,Full);
+            while(m_loading.contains(key))
+                m_loaded.wait(&m_mutex);
+            m_pending.remove(key);
+            if(QImage *prefetched = m_fullImages.object(slideId))
+                img = *prefetched;
+            m_fullImages.remove(slideId);
+        }
+        if(img.isNull())
+            img = decode(slideId,kind,QSqlDatabase::database());
+
+        QPixmap pix = QPixmap::fromImage(img);
+        if(!pix.isNull())
+            m_fullPix.insert(slideId,new QPixmap(pix),qMax(qsizetype(1),img.sizeInBytes()/1024));
+        return pix;
+    }
+
+    // Needed right now, decode with the main connection
+    return QPixmap::fromImage(decode(slideId,kind,QSqlDatabase::database()));
+}
+
+QPixmap SlideImageCache::decoded(qint64 &key, const QByteArray &data)
+{
+    // Slides that are not stored keep only their encoded image, the decoded one
+    // is kept here so that showing the slide again does not decode it again
+    if(key != 0)
+    {
+        if(QPixmap *pix = m_fullPix.object(key))
+            return *pix;
+    }
+    else
+        key = --m_lastDataKey;
+
+    QPixmap pix;
+    pix.loadFromData(data);
+    if(!pix.isNull())
+        m_fullPix.insert(key,new QPixmap(pix),qMax(1,pix.width()*pix.height()*4/1024));
+    return pix;
+}
+
+QPixmap SlideImageCache::thumbnail(int slideId)
+{
+    if(QPixmap *pix = m_thumbPix.object(slideId))
+        return *pix;
+
+    QImage img;
+    {
+        QMutexLocker locker(&m_mutex);
+        if(QImage *decoded = m_thumbs.object(slideId))
+            img = *decoded;
+        m_thumbs.remove(slideId);
+    }
+    if(img.isNull())
+        return QPixmap();
+
+    QPixmap pix = QPixmap::fromImage(img);
+    m_thumbPix.insert(slideId,new QPixmap(pix),qMax(qsizetype(1),img.sizeInBytes()/1024));
+    return pix;
+}
+
+void SlideImageCache::requestThumbnail(int slideId)
+{
+    if(m_thumbPix.contains(slideId))
+        return;
+
+    QMutexLocker locker(&m_mutex);
+    qint64 key = pendingKey(slideId,Small);
+    if(m_thumbs.contains(slideId) || m_pending.contains(key))
+        return;
+    m_pending.insert(key);
+    QtConcurrent::run(&m_pool,&SlideImageCache::load,this,slideId,int(Small));
+}
+
+void SlideImageCache::prefetch(const QList<SlideShowItem> &slides, int current)
+{
+    // Next two slides and the previous one
+    QList<int> rows;
+    rows << current+1 << current+2 << current-1;
+
+    QMutexLocker locker(&m_mutex);
+    foreach(int row, rows)
+    {
+        if(row < 0 || row >= slides.count() || !slides.at(row).isStored || !slides.at(row).image.isNull())
+            continue;
+        int id = slides.at(row).slideId;
+        qint64 key = pendingKey(id,Full);
+        if(m_fullPix.contains(id) || m_fullImages.contains(id) || m_pending.contains(key))
+            continue;
+        m_pending.insert(key);
+        QtConcurrent::run(&m_pool,&SlideImageCache::load,this,id,int(Full));
+    }
+}
+
+void SlideImageCache::load(int slideId, int kind)
+{
+    // Runs on the background thread with its own connection
+    qint64 key = pendingKey(slideId,kind);
+    m_mutex.lock();
+    if(!m_pending.contains(key))
+    {
+        // Taken over by image() before it started
+        m_mutex.unlock();
+        return;
+    }
+    m_loading.insert(key);
+    m_mutex.unlock();
+
+    QImage img = decode(slideId,Kind(kind),DbService::instance()->database());
+
+    m_mutex.lock();
+    m_pending.remove(key);
+    m_loading.remove(key);
+    if(!img.isNull())
+    {
+        int cost = qMax(qsizetype(1),img.sizeInBytes()/1024);
+        if(kind == Full)
+            m_fullImages.insert(slideId,new QImage(img),cost);
+        else
+            m_thumbs.insert(slideId,new QImage(img),cost);
+    }
+    m_loaded.wakeAll();
+    m_mutex.unlock();
+
+    if(kind == Small && !img.isNull())
+        emit thumbnailReady(slideId);
+}
+
+SlideIconDelegate::SlideIconDelegate(QAbstractItemView *view) :
+    QStyledItemDelegate(view)
+{
+    m_view = view;
+    connect(SlideImageCache::instance(),SIGNAL(thumbnailReady(int)),this,SLOT(thumbnailReady(int)));
+}
+
+void SlideIconDelegate::paint(QPainter *painter, const QStyleOptionViewItem &option, const QModelIndex &index) const
+{
+    QVariant id = index.data(Qt::UserRole);
+    if(id.isValid())
+        SlideImageCache::instance()->requestThumbnail(id.toInt());
+    QStyledItemDelegate::paint(painter,option,index);
+}
+
+void SlideIconDelegate::initStyleOption(QStyleOptionViewItem *option, const QModelIndex &index) const
+{
+    QStyledItemDelegate::initStyleOption(option,index);
+    QVariant id = index.data(Qt::UserRole);
+    if(!id.isValid())
+        return;
+
+    // Keep the decoration space while the thumbnail is not decoded yet
+    option->features |= QStyleOptionViewItem::HasDecoration;
+    option->decorationSize = m_view->iconSize();
+    QPixmap pix = SlideImageCache::instance()->thumbnail(id.toInt());
+    if(!pix.isNull())
+        option->icon = QIcon(pix);
+}
+
+void SlideIconDelegate::thumbnailReady(int slideId)
+{
+    Q_UNUSED(slideId);
+    m_view->viewport()->update();
 }
 
 SlideShowInfo::SlideShowInfo()
@@ -34,6 +358,109 @@ SlideShow::SlideShow()
     slideShowId = -1;
 }
 
+class ImportedSlide
+{
+public:
+    QString name;
+    QString path;
+    QImage preview;
+    QImage small;
+    QByteArray imageData, previewData, smallData;
+};
+
+class SlideDecoder
+{
+    // Produces the three renditions of one image file, runs on the global thread pool
+public:
+    typedef ImportedSlide result_type;
+    SlideShowSettings sets;
+
+    ImportedSlide operator()(const QString &file) const
+    {
+        ImportedSlide is;
+        QFileInfo f(file);
+        is.name = f.fileName();
+        is.path = f.filePath();
+
+        QFile fl(file);
+        if(!fl.open(QIODevice::ReadOnly))
+            return is;
+        QByteArray bytes = fl.readAll();
+        QBuffer buffer(&bytes);
+        QImageReader reader(&buffer);
+        reader.setAutoTransform(true); // honour EXIF orientation
+
+        // Decode directly at the display size when images are to be resized.
+        // The bound is square, so the orientation does not change the scaled size.
+        QSize size = reader.size();
+        if(sets.resize && size.isValid() && (size.width()>sets.boundWidth || size.height()>sets.boundWidth))
+            reader.setScaledSize(size.scaled(sets.boundWidth,sets.boundWidth,Qt::KeepAspectRatio));
+
+        QImage img = reader.read();
+        if(img.isNull())
+            return is;
+
+        if(img.width()>400 || img.height()>400)
+            is.preview = img.scaled(400,400,Qt::KeepAspectRatio,Qt::SmoothTransformation);
+        else
+            is.preview = img;
+
+        if(is.preview.width()>100 || is.preview.height()>100)
+            is.small = is.preview.scaled(100,100,Qt::KeepAspectRatio,Qt::SmoothTransformation);
+        else
+            is.small = is.preview;
+
+        // The file itself is kept when the image did not have to be scaled or rotated
+        if(!reader.scaledSize().isValid() && reader.transformation() == QImageIOHandler::TransformationNone
+                && isReusableImageFormat(reader.format()))
+            is.imageData = bytes;
+        else
+            is.imageData = imageToByte(img);
+        is.previewData = imageToByte(is.preview,ImageThumbnail);
+        is.smallData = imageToByte(is.small,ImageThumbnail);
+        return is;
+    }
+};
+
+QList<SlideShowItem> importSlides(const QStringList &files, const SlideShowSettings &sets,
+                                  const QString &label, QWidget *parent)
+{
+    SlideDecoder decoder;
+    decoder.sets = sets;
+
+    QProgressDialog progress(label, QObject::tr("Cancel"), 0, files.count(), parent);
+    QFutureWatcher<ImportedSlide> watcher;
+    QObject::connect(&watcher,SIGNAL(progressValueChanged(int)),&progress,SLOT(setValue(int)));
+    QObject::connect(&watcher,SIGNAL(finished()),&progress,SLOT(reset()));
+    QObject::connect(&progress,SIGNAL(canceled()),&watcher,SLOT(cancel()));
+    watcher.setFuture(QtConcurrent::mapped(files,decoder));
+    if(!watcher.isFinished())
+        progress.exec();
+    watcher.waitForFinished();
+
+    // Only the full size image stays encoded, it is decoded again when shown
+    QList<SlideShowItem> slides;
+    QFuture<ImportedSlide> future = watcher.future();
+    for(int i(0);i<files.count();++i)
+    {
+        if(!future.isResultReadyAt(i))
+            continue;
+        ImportedSlide is = future.resultAt(i);
+        if(is.imageData.isEmpty())
+            continue;
+        SlideShowItem sd;
+        sd.name = is.name;
+        sd.path = is.path;
+        sd.imagePreview = QPixmap::fromImage(is.preview);
+        sd.imageSmall = QPixmap::fromImage(is.small);
+        sd.imageData = is.imageData;
+        sd.imagePreviewData = is.previewData;
+        sd.imageSmallData = is.smallData;
+        slides.append(sd);
+    }
+    return slides;
+}
+
 void SlideShow::loadSlideShow(int id)
 {
     slides.clear();
@@ -44,52 +471,18 @@ void SlideShow::loadSlideShow(int id)
     name = sq.value(0).toString();
     info = sq.value(1).toString();
 
-    QProgressDialog progress;
-    progress.setMaximum(100);
-    progress.setValue(1);
-    sq.exec(QString("SELECT id, p_order, name, path, pix, pix_small, pix_prev FROM Slides WHERE ss_id = %1").arg(slideShowId));
-
-    int max(0);
+    // Only slide information is read here, images are decoded when they are needed
+    sq.exec(QString("SELECT id, p_order, name, path FROM Slides WHERE ss_id = %1 ORDER BY p_order").arg(slideShowId));
     while(sq.next())
-        ++max;
-
-    sq.first();
-    progress.setLabelText("Loading Slides...");
-    progress.setMaximum(max+1);
-    int ct(0);
-
-    QList<SlideShowItem> ss;
-    do
     {
         SlideShowItem si;
         si.slideId = sq.value(0).toInt();
         si.order = sq.value(1).toInt();
         si.name = sq.value(2).toString();
         si.path = sq.value(3).toString();
-        si.image.loadFromData(sq.value(4).toByteArray());
-        si.imageSmall.loadFromData(sq.value(5).toByteArray());
-        si.imagePreview.loadFromData(sq.value(6).toByteArray());
-
-        ss.append(si);
-        ++ct;
-        progress.setValue(ct);
-    }while(sq.next());
-
-    // Sort to proper oder number
-    for(int i(0);i<ss.count();++i)
-    {
-        foreach(const SlideShowItem &ssi, ss)
-        {
-            if(ssi.order == i)
-            {
-                slides.append(ssi);
-                break;
-            }
-        }
+        si.isStored = true;
+        slides.append(si);
     }
-
-    ++ct;
-    progress.setValue(ct);
 }
 
 void SlideShow::saveSideShow(QString savelbl, QWidget *ptW, QList<int> delList)
@@ -124,9 +517,9 @@ void SlideShow::saveSideShow(QString savelbl, QWidget *ptW, QList<int> delList)
             sq.addBindValue(ct);
             sq.addBindValue(si.name);
             sq.addBindValue(si.path);
-            sq.addBindValue(pixToByte(si.image));
-            sq.addBindValue(pixToByte(si.imageSmall));
-            sq.addBindValue(pixToByte(si.imagePreview));
+            sq.addBindValue(AssetStore::instance()->store(si.getImageData()));
+            sq.addBindValue(AssetStore::instance()->store(si.getImageSmallData()));
+            sq.addBindValue(AssetStore::instance()->store(si.getImagePreviewData()));
             sq.exec();
             ++ct;
             prg.setValue(ct);
@@ -170,9 +563,9 @@ void SlideShow::saveSideShow(QString savelbl, QWidget *ptW, QList<int> delList)
                 sq.addBindValue(c);
                 sq.addBindValue(si.name);
                 sq.addBindValue(si.path);
-                sq.addBindValue(pixToByte(si.image));
-                sq.addBindValue(pixToByte(si.imageSmall));
-                sq.addBindValue(pixToByte(si.imagePreview));
+                sq.addBindValue(AssetStore::instance()->store(si.getImageData()));
+                sq.addBindValue(AssetStore::instance()->store(si.getImageSmallData()));
+                sq.addBindValue(AssetStore::instance()->store(si.getImagePreviewData()));
                 sq.exec();
                 ++ct;
                 prg.setValue(ct);
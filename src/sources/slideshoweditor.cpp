@@ -26,6 +26,7 @@ SlideShowEditor::SlideShowEditor(QWidget *parent) :
     ui(new Ui::SlideShowEditor)
 {
     ui->setupUi(this);
+    ui->listWidgetSlides->setItemDelegate(new SlideIconDelegate(ui->listWidgetSlides));
     updateButtonState();
 }
 
@@ -55,9 +56,7 @@ void SlideShowEditor::reloadSlides()
     ui->listWidgetSlides->clear();
     foreach(const SlideShowItem &ssi, editSS.slides)
     {
-        QListWidgetItem *itm = new QListWidgetItem;
-        QIcon ico(ssi.imageSmall);
-        itm->setIcon(ico);
+        QListWidgetItem *itm = ssi.createListItem();
         ui->listWidgetSlides->addItem(itm);
     }
 }
@@ -78,57 +77,14 @@ void SlideShowEditor::on_pushButtonAddImages_clicked()
                                                                tr("Images(%1)").arg(getSupportedImageFormats()));
     if(imageFilePaths.count()>0)
     {
-        this->setCursor(Qt::WaitCursor);
-        int i(0);
-        QProgressDialog progress(tr("Adding files..."), tr("Cancel"), 0, imageFilePaths.count(), this);
+        QList<SlideShowItem> imported = importSlides(imageFilePaths,mySettings,tr("Adding files..."),this);
         ui->listWidgetSlides->setIconSize(QSize(100,100));
-        foreach(const QString &file, imageFilePaths)
+        foreach(const SlideShowItem &sd, imported)
         {
-            ++i;
-            progress.setValue(i);
-
-            QPixmap img;
-            SlideShowItem sd;
-            img.load(file);
-            // set display image. If to resize, resize them
-            if(mySettings.resize)
-            {
-                if(img.width()>mySettings.boundWidth || img.height()>mySettings.boundWidth )
-                    sd.image = img.scaled(mySettings.boundWidth ,mySettings.boundWidth , Qt::KeepAspectRatio);
-                else
-                    sd.image = img;
-            }
-            else
-                sd.image = img;
-
-            // set preview image
-            if(img.width()>400 || img.height()>400)
-                sd.imagePreview = img.scaled(400,400, Qt::KeepAspectRatio);
-            else
-                sd.imagePreview = img;
-
-            // set list image
-            if(img.width()>100 || img.height()>100)
-                sd.imageSmall = img.scaled(100,100, Qt::KeepAspectRatio);
-            else
-                sd.imageSmall = img;
-
-            // set file name
-            QFileInfo f(file);
-            sd.name = f.fileName();
-            sd.path = f.filePath();
-
-            // add to slideshow
+            // add to slideshow and to slide show list
             editSS.slides.append(sd);
-
-            // add to slide show list
-            QListWidgetItem *itm = new QListWidgetItem;
-            QIcon ico(sd.imageSmall);
-
-            itm->setIcon(ico);
-            ui->listWidgetSlides->addItem(itm);
+            ui->listWidgetSlides->addItem(sd.createListItem());
         }
-        this->setCursor(Qt::ArrowCursor);
         updateButtonState();
     }
 
@@ -210,7 +166,7 @@ void SlideShowEditor::on_listWidgetSlides_currentRowChanged(int currentRow)
 {
     if(currentRow>=0)
     {
-        ui->labelPreview->setPixmap(editSS.slides.at(currentRow).imagePreview);
+        ui->labelPreview->setPixmap(editSS.slides.at(currentRow).getImagePreview());
         ui->labelPixInfo->setText(tr("Preview slide: %1").arg(editSS.slides.at(currentRow).name));
         updateButtonState();
     }
@@ -18,19 +18,64 @@
 ***************************************************************************/
 
 #include <QWidget>
+#include <QtConcurrent>
 #include "../headers/softprojector.hpp"
 #include "ui_softprojector.h"
 #include "../headers/aboutdialog.hpp"
 #include "../headers/editannouncementdialog.hpp"
 #include "../headers/decklinkdiscovery.hpp"
+#include "../headers/renderprofiler.hpp"
+#include "../headers/assetstore.hpp"
+#include "../headers/dbservice.hpp"
+#include "../headers/startupprofiler.hpp"
+
+// Slides of every schedule item that Prepare Service renders ahead
+static const int PREPARE_SLIDES = 3;
+
+static void warmRender(RenderCache *cache, QList<RenderJob> jobs)
+{
+    cache->prepare(jobs);
+}
 
 SoftProjector::SoftProjector(QWidget *parent)
     : QMainWindow(parent), ui(new Ui::SoftProjectorClass)
 {
     // Load settings
-    mySettings.loadSettings();
-    theme.setThemeId(mySettings.general.currentThemeId);
-    theme.loadTheme();
+    {
+        StartupPhase phase("settings");
+        mySettings.loadSettings();
+    }
+    AssetStore::instance()->setMediaFiles(mySettings.general.useMediaFiles);
+
+    // Songs, the operator Bible and the media catalog are read on database
+    // threads while the display screens and widgets are built.
+    // Each is waited for where it is first used.
+    QString operatorBible = mySettings.bibleSets.operatorBible;
+    if(operatorBible == "same")
+        operatorBible = mySettings.bibleSets.primaryBible;
+    if(operatorBible != "none")
+        Bible::preload(operatorBible);
+    SongDatabase::preload();
+    MediaCatalog::instance()->preload();
+
+    //Setting up the Display Screen
+    // desktop = new QDesktopWidget();
+    // NOTE: With virtual desktop, desktop->screen() will always return the main screen,
+    // so this will initialize the Display1 widget on the main screen:
+    {
+        StartupPhase phase("display screens");
+        for(int i(0);i<mySettings.general.outputs.count();++i)
+            outputs << new DisplayOutput(i+1,&renderCache);
+    }
+    // Don't worry, we'll move them later
+    timingOverlay = NULL;
+    timingTimer = NULL;
+
+    {
+        StartupPhase phase("theme");
+        theme.setThemeId(mySettings.general.currentThemeId);
+        theme.loadTheme();
+    }
     // Reset current theme id if initial was 0
     mySettings.general.currentThemeId = theme.getThemeId();
 
@@ -40,25 +85,42 @@ SoftProjector::SoftProjector(QWidget *parent)
     theme.bible3.versions = mySettings.bibleSets3;
     theme.bible4.versions = mySettings.bibleSets4;
 
-    //Setting up the Display Screen
-    // desktop = new QDesktopWidget();
-    // NOTE: With virtual desktop, desktop->screen() will always return the main screen,
-    // so this will initialize the Display1 widget on the main screen:
-    pds1 = new ProjectorDisplayScreen();
-    pds2 = new ProjectorDisplayScreen(); //for future
-    pds3 = new ProjectorDisplayScreen(); //for future
-    pds4 = new ProjectorDisplayScreen(); //for future
-    // Don't worry, we'll move it later
-
-    bibleWidget = new BibleWidget;
-    songWidget = new SongWidget;
+    // Unsaved schedule changes are written every few seconds when autosave is on
+    autosaveTimer = new QTimer(this);
+    autosaveTimer->setInterval(5000);
+    connect(autosaveTimer,SIGNAL(timeout()),this,SLOT(autosaveSchedule()));
+    autosaveTimer->start();
+
+    // Prepare Service renders on worker threads and moves to the next item when done
+    prepareRow = -1;
+    prepareDialog = NULL;
+    prepareWatcher = new QFutureWatcher<void>(this);
+    connect(prepareWatcher,SIGNAL(finished()),this,SLOT(prepareNextItem()));
+
+    themeWatcher = new QFutureWatcher<QHash<qint64,QImage> >(this);
+    connect(themeWatcher,SIGNAL(finished()),this,SLOT(themeBackgroundsDecoded()));
+
+    {
+        StartupPhase phase("bible widget");
+        bibleWidget = new BibleWidget;
+    }
+    {
+        StartupPhase phase("song widget");
+        songWidget = new SongWidget;
+    }
     editWidget = new EditWidget;
     announceWidget = new AnnounceWidget;
     manageDialog = new ManageDataDialog(this);
     settingsDialog = new SettingsDialog(this);
     helpDialog = new HelpDialog();
-    pictureWidget = new PictureWidget;
-    mediaPlayer = new MediaWidget;
+    {
+        StartupPhase phase("picture widget");
+        pictureWidget = new PictureWidget;
+    }
+    {
+        StartupPhase phase("media widget");
+        mediaPlayer = new MediaWidget;
+    }
     mediaControls = new MediaControl(this);
 
     // Initialize DeckLink device discovery
@@ -86,7 +148,10 @@ SoftProjector::SoftProjector(QWidget *parent)
         deckLinkDevices.clear();
     }
 
-    ui->setupUi(this);
+    {
+        StartupPhase phase("ui setup");
+        ui->setupUi(this);
+    }
 
     // Create action group for language slections
     languagePath = qApp->applicationDirPath()+QString(QDir::separator())+"translations"+QString(QDir::separator());
@@ -99,7 +164,10 @@ SoftProjector::SoftProjector(QWidget *parent)
     // display window (Mac OS X)
 
     // Apply Settings
-    applySetting(mySettings.general, theme, mySettings.slideSets, mySettings.bibleSets, mySettings.bibleSets2, mySettings.bibleSets3, mySettings.bibleSets4);
+    {
+        StartupPhase phase("apply settings");
+        applySetting(mySettings.general, theme, mySettings.slideSets, mySettings.bibleSets, mySettings.bibleSets2, mySettings.bibleSets3, mySettings.bibleSets4);
+    }
 
     positionDisplayWindow();
 
@@ -113,6 +181,8 @@ SoftProjector::SoftProjector(QWidget *parent)
     ui->projectTab->addTab(announceWidget,QIcon(":/icons/icons/announce.png"), tr("Announcements (F8)"));
     ui->projectTab->setCurrentIndex(0);
 
+    // Thumbnails of stored slides are decoded as the show list paints them
+    ui->listShow->setItemDelegate(new SlideIconDelegate(ui->listShow));
 
     connect(bibleWidget, SIGNAL(goLive(QStringList, QString, QItemSelection)),
             this, SLOT(setChapterList(QStringList, QString, QItemSelection)));
@@ -131,9 +201,9 @@ SoftProjector::SoftProjector(QWidget *parent)
     connect(manageDialog, SIGNAL(setMainArrowCursor()), this, SLOT(setArrowCursor()));
     connect(manageDialog, SIGNAL(setMainWaitCursor()), this, SLOT(setWaitCursor()));
     connect(languageGroup, SIGNAL(triggered(QAction*)), this, SLOT(switchLanguage(QAction*)));
-    connect(pds1,SIGNAL(exitSlide()),this,SLOT(on_actionHide_triggered()));
-    connect(pds1,SIGNAL(nextSlide()),this,SLOT(nextSlide()));
-    connect(pds1,SIGNAL(prevSlide()),this,SLOT(prevSlide()));
+    connect(primaryDisplay(),SIGNAL(exitSlide()),this,SLOT(on_actionHide_triggered()));
+    connect(primaryDisplay(),SIGNAL(nextSlide()),this,SLOT(nextSlide()));
+    connect(primaryDisplay(),SIGNAL(prevSlide()),this,SLOT(prevSlide()));
     connect(settingsDialog,SIGNAL(updateSettings(GeneralSettings&,Theme&,SlideShowSettings&,
                                                  BibleVersionSettings&,BibleVersionSettings&,
                                                  BibleVersionSettings&,BibleVersionSettings&)),
@@ -198,18 +268,18 @@ SoftProjector::SoftProjector(QWidget *parent)
     ui->verticalLayoutDisplayControls->insertWidget(1,mediaControls);
     mediaControls->setVisible(false);
     mediaControls->setVolume(100);
-    connect(pds1,SIGNAL(videoPositionChanged(qint64)),
+    connect(primaryDisplay(),SIGNAL(videoPositionChanged(qint64)),
             mediaControls,SLOT(updateTime(qint64)));
-    connect(pds1,SIGNAL(videoDurationChanged(qint64)),
+    connect(primaryDisplay(),SIGNAL(videoDurationChanged(qint64)),
             mediaControls,SLOT(setMaximumTime(qint64)));
-    connect(pds1,SIGNAL(videoPlaybackStateChanged(QMediaPlayer::State)),
+    connect(primaryDisplay(),SIGNAL(videoPlaybackStateChanged(QMediaPlayer::State)),
             mediaControls,SLOT(updatePlayerState(QMediaPlayer::State)));
-    connect(pds1,SIGNAL(videoStopped()),this,SLOT(videoStopped()));
+    connect(primaryDisplay(),SIGNAL(videoStopped()),this,SLOT(videoStopped()));
     connect(mediaControls,SIGNAL(play()),this,SLOT(playVideo()));
     connect(mediaControls,SIGNAL(pause()),this,SLOT(pauseVideo()));
     connect(mediaControls,SIGNAL(stop()),this,SLOT(stopVideo()));
-    connect(mediaControls,SIGNAL(volumeChanged(int)),pds1,SLOT(setVideoVolume(int)));
-    connect(mediaControls,SIGNAL(muted(bool)),pds1,SLOT(setVideoMuted(bool)));
+    connect(mediaControls,SIGNAL(volumeChanged(int)),primaryDisplay(),SLOT(setVideoVolume(int)));
+    connect(mediaControls,SIGNAL(muted(bool)),primaryDisplay(),SLOT(setVideoMuted(bool)));
     connect(mediaControls,SIGNAL(timeChanged(qint64)),this,SLOT(setVideoPosition(qint64)));
 
     version_string = "2.2";
@@ -218,6 +288,10 @@ SoftProjector::SoftProjector(QWidget *parent)
 
 SoftProjector::~SoftProjector()
 {
+    // Rendering uses renderCache, it must not outlive it
+    prepareRow = -1;
+    prepareWatcher->waitForFinished();
+    journal.discard();
     saveSettings();
     delete songWidget;
     delete editWidget;
@@ -225,10 +299,7 @@ SoftProjector::~SoftProjector()
     delete announceWidget;
     delete manageDialog;
     delete mediaPlayer;
-    delete pds1;
-    delete pds2;
-    delete pds3;
-    delete pds4;
+    qDeleteAll(outputs);
     delete languageGroup;
     delete settingsDialog;
     delete shpgUP;
@@ -246,22 +317,25 @@ SoftProjector::~SoftProjector()
 
 void SoftProjector::positionDisplayWindow()
 {
-    // Position the display window as needed (including setting "always on top" flag,
-    // showing full screen / normal mode, and positioning it on the right screen)
+    // Position the display windows as needed (including setting "always on top" flag,
+    // showing full screen / normal mode, and positioning them on the right screens)
 
-    if (mySettings.general.displayIsOnTop)
+    // One display output for every output in settings
+    QList<OutputSettings> &outs = mySettings.general.outputs;
+    while(outputs.count() < outs.count())
+        outputs << new DisplayOutput(outputs.count()+1,&renderCache);
+    while(outputs.count() > outs.count())
     {
-        pds1->setWindowFlags(Qt::WindowStaysOnTopHint);
-        pds2->setWindowFlags(Qt::WindowStaysOnTopHint);
-        pds3->setWindowFlags(Qt::WindowStaysOnTopHint);
-        pds4->setWindowFlags(Qt::WindowStaysOnTopHint);
+        stagedOutputs.removeAll(outputs.last());
+        delete outputs.takeLast();
     }
-    else
+    foreach(DisplayOutput *out, outputs)
+        connect(out->display,SIGNAL(stagedReady()),this,SLOT(showStagedWhenReady()),Qt::UniqueConnection);
+
+    if (mySettings.general.displayIsOnTop)
     {
-        // pds1->setWindowFlags(Qt::WindowStaysOnBottomHint); // Do not show always on top
-        // pds2->setWindowFlags(Qt::WindowStaysOnBottomHint); // Do not show always on top
-        // pds3->setWindowFlags(Qt::WindowStaysOnBottomHint); // Do not show always on top
-        // pds4->setWindowFlags(Qt::WindowStaysOnBottomHint); // Do not show always on top
+        foreach(DisplayOutput *out, outputs)
+            out->display->setWindowFlags(Qt::WindowStaysOnTopHint);
     }
 
     // Get available screens - this will refresh the list on each application startup
@@ -298,162 +372,45 @@ void SoftProjector::positionDisplayWindow()
     }
 
     // Validate and correct display screen indices if they are out of bounds
-    if(mySettings.general.displayScreen < 0 || mySettings.general.displayScreen >= screen_count)
-    {
-        mySettings.general.displayScreen = 0;
-    }
-    if(mySettings.general.displayScreen2 >= screen_count)
+    if(outs[0].screen < 0 || outs[0].screen >= screen_count)
     {
-        mySettings.general.displayScreen2 = -1;
+        outs[0].screen = 0;
     }
-    if(mySettings.general.displayScreen3 >= screen_count)
+    for(int i(1);i<outs.count();++i)
     {
-        mySettings.general.displayScreen3 = -1;
-    }
-    if(mySettings.general.displayScreen4 >= screen_count)
-    {
-        mySettings.general.displayScreen4 = -1;
+        if(outs.at(i).screen >= screen_count)
+            outs[i].screen = -1;
     }
+    for(int i(0);i<outputs.count();++i)
+        outputs.at(i)->setSettings(outs.at(i));
 
     if(screen_count > 1)
     {
-
-        // Check if the selected display is a DeckLink device
-        // Safely check bounds and DeckLink availability
-        if (mySettings.general.displayScreen >= screens.count() && !deckLinkDevices.isEmpty())
+        // The primary display screen is always shown, the others when they have a screen
+        foreach(DisplayOutput *out, outputs)
         {
-            // This might be a DeckLink device
-            int deckLinkIndex = mySettings.general.displayScreen - screens.count();
-            if (deckLinkIndex >= 0 && deckLinkIndex < deckLinkDevices.count())
+            out->isConnected = (out->number() == 1 || out->screen() >= 0);
+            if(!out->isConnected)
             {
-                try {
-                    pds1->setGeometry(deckLinkDevices.at(deckLinkIndex).geometry);
-                    qDebug() << "Using DeckLink device:" << deckLinkDevices.at(deckLinkIndex).modelName;
-                }
-                catch (...)
-                {
-                    // If DeckLink geometry fails, fall back to first regular screen
-                    if (!screens.isEmpty())
-                    {
-                        pds1->setGeometry(screens.at(0)->geometry());
-                    }
-                }
+                out->display->hide();
+                continue;
             }
-            else
-            {
-                // Invalid DeckLink index, fall back to first regular screen
-                if (!screens.isEmpty() && mySettings.general.displayScreen < screens.count())
-                {
-                    pds1->setGeometry(screens.at(mySettings.general.displayScreen)->geometry());
-                }
-                else if (!screens.isEmpty())
-                {
-                    pds1->setGeometry(screens.at(0)->geometry());
-                }
-            }
-        }
-        else
-        {
-            // Regular screen - check bounds
-            if (mySettings.general.displayScreen >= 0 && mySettings.general.displayScreen < screens.count())
-            {
-                pds1->setGeometry(screens.at(mySettings.general.displayScreen)->geometry());
-            }
-            else if (!screens.isEmpty())
+
+            out->display->setGeometry(screenGeometry(out->screen(),screens));
+            out->display->resetImGenSize();
+            out->display->setCursor(Qt::BlankCursor); //Sets a Blank Mouse to the screen
+            out->showPassive(theme);
+            out->display->setControlsVisible(false);
+            if(mySettings.general.displayOnStartUp)
             {
-                // Invalid index, use first screen
-                pds1->setGeometry(screens.at(0)->geometry());
+                out->display->showFullScreen();
             }
         }
 
-        pds1->setCursor(Qt::BlankCursor); //Sets a Blank Mouse to the screen
-        pds1->resetImGenSize();
-        pds1->renderPassiveText(theme.passive.backgroundPix,theme.passive.useBackground);
-        pds1->setControlsVisible(false);
-
         if(mySettings.general.displayOnStartUp)
         {
-            pds1->showFullScreen();
-
             ui->actionCloseDisplay->setChecked(true);
             updateCloseDisplayButtons(true);
-
-        }
-
-        // check if to display secondary display screen
-        if(mySettings.general.displayScreen2>=0 && mySettings.general.displayScreen2 < screen_count)
-        {
-            hasDisplayScreen2 = true;
-            // if (desktop->isVirtualDesktop())
-            {
-                // Move the display widget to screen 1 (secondary screen):
-                pds2->setGeometry(screens.at(mySettings.general.displayScreen2)->geometry());
-                pds2->resetImGenSize();
-
-            }
-
-            pds2->setCursor(Qt::BlankCursor); //Sets a Blank Mouse to the screen
-            pds2->renderPassiveText(theme.passive2.backgroundPix,theme.passive2.useBackground);
-            pds2->setControlsVisible(false);
-            if(mySettings.general.displayOnStartUp)
-            {
-                pds2->showFullScreen();
-            }
-        }
-        else
-        {
-            hasDisplayScreen2 = false;
-            pds2->hide();
-        }
-
-        // check if to display tertiary display screen
-        if(mySettings.general.displayScreen3>=0 && mySettings.general.displayScreen3 < screen_count)
-        {
-            hasDisplayScreen3 = true;
-            // if (desktop->isVirtualDesktop())
-            {
-                // Move the display widget to screen 1 (tertiary screen):
-                pds3->setGeometry(screens.at(mySettings.general.displayScreen3)->geometry());
-                pds3->resetImGenSize();
-
-            }
-            pds3->setCursor(Qt::BlankCursor); //Sets a Blank Mouse to the screen
-            pds3->renderPassiveText(theme.passive3.backgroundPix,theme.passive3.useBackground);
-            pds3->setControlsVisible(false);
-            if(mySettings.general.displayOnStartUp)
-            {
-                pds3->showFullScreen();
-            }
-        }
-        else
-        {
-            hasDisplayScreen3 = false;
-            pds3->hide();
-        }
-
-        // check if to display quaternary display screen
-        if(mySettings.general.displayScreen4>=0 && mySettings.general.displayScreen4 < screen_count)
-        {
-            hasDisplayScreen4 = true;
-            // if (desktop->isVirtualDesktop())
-            {
-                // Move the display widget to screen 1 (quaternary screen):
-                pds4->setGeometry(screens.at(mySettings.general.displayScreen4)->geometry());
-                pds4->resetImGenSize();
-
-            }
-            pds4->setCursor(Qt::BlankCursor); //Sets a Blank Mouse to the screen
-            pds4->renderPassiveText(theme.passive4.backgroundPix,theme.passive4.useBackground);
-            pds4->setControlsVisible(false);
-            if(mySettings.general.displayOnStartUp)
-            {
-                pds4->showFullScreen();
-            }
-        }
-        else
-        {
-            hasDisplayScreen4 = false;
-            pds4->hide();
         }
 
         // specify that there is more than one diplay screen(monitor) availbale
@@ -464,29 +421,124 @@ void SoftProjector::positionDisplayWindow()
         // Single monitor only: Do not show on strat up.
         // Will be shown only when items were sent to the projector.
         qDebug()<< "Setting Primary screen";
-        pds1->setGeometry(screens.at(0)->geometry());
-        pds1->resetImGenSize();
+        foreach(DisplayOutput *out, outputs)
+        {
+            out->isConnected = (out->number() == 1);
+            if(!out->isConnected)
+                out->display->hide();
+        }
+        primaryDisplay()->setGeometry(screens.at(0)->geometry());
+        primaryDisplay()->resetImGenSize();
         showDisplayScreen(false);
         isSingleScreen = true;
-        hasDisplayScreen2 = false;
-        hasDisplayScreen3 = false;
-        hasDisplayScreen4 = false;
     }
+
+    prescaleBackgrounds();
+}
+
+QRect SoftProjector::screenGeometry(int screen, const QList<QScreen*> &screens)
+{
+    // Screens come first, DeckLink devices are numbered after them
+    if(screen >= 0 && screen < screens.count())
+        return screens.at(screen)->geometry();
+
+    int deckLinkIndex = screen - screens.count();
+    if(deckLinkIndex >= 0 && deckLinkIndex < deckLinkDevices.count())
+    {
+        qDebug() << "Using DeckLink device:" << deckLinkDevices.at(deckLinkIndex).modelName;
+        return deckLinkDevices.at(deckLinkIndex).geometry;
+    }
+
+    // Invalid index, use first screen
+    return screens.at(0)->geometry();
+}
+
+QList<int> SoftProjector::themeDisplays()
+{
+    // Theme display settings that connected outputs use
+    QList<int> displays;
+    foreach(DisplayOutput *out, outputs)
+    {
+        if(out->isConnected && !displays.contains(out->themeDisplay()))
+            displays << out->themeDisplay();
+    }
+    return displays;
+}
+
+void SoftProjector::prescaleBackgrounds()
+{
+    // Only the theme backgrounds that connected display outputs use are decoded,
+    // on a database thread. This is called again once they are ready.
+    QList<QVariant> pending = theme.pendingBackgrounds(themeDisplays());
+    if(!pending.isEmpty())
+    {
+        if(!themeWatcher->isRunning())
+            themeWatcher->setFuture(DbService::instance()->run(Theme::decodeBackgrounds,pending));
+        return;
+    }
+    theme.loadBackgrounds(themeDisplays());
+
+    // Theme backgrounds are scaled on worker threads ahead of time, so that switching
+    // between Bible, songs and announcements does not rescale full size pictures.
+    foreach(DisplayOutput *out, outputs)
+    {
+        if(!out->isConnected)
+            continue;
+        int td = out->themeDisplay();
+        prescaleBackground(out,theme.passiveFor(td));
+        if(out->shows(BIBLE))
+            prescaleBackground(out,theme.bibleFor(td));
+        if(out->shows(SONG))
+            prescaleBackground(out,theme.songFor(td));
+        if(out->shows(ANNOUCEMENT))
+            prescaleBackground(out,theme.announceFor(td));
+    }
+}
+
+void SoftProjector::loadShownBackgrounds()
+{
+    // An item must not go live without its background. Backgrounds that are still
+    // being decoded are waited for, the others of connected outputs are decoded now.
+    if(themeWatcher->isRunning())
+    {
+        themeWatcher->waitForFinished();
+        AssetStore::instance()->addDecoded(themeWatcher->result());
+    }
+    theme.loadBackgrounds(themeDisplays());
+}
+
+void SoftProjector::prescaleBackground(DisplayOutput *out, TextSettingsBase sets)
+{
+    out->applyContent(sets);
+    if(sets.useBackground)
+        out->display->prescaleBackground(sets.backgroundPix,0);
+}
+
+void SoftProjector::themeBackgroundsDecoded()
+{
+    // The theme may have changed meanwhile, what is still missing is decoded here.
+    // Nothing is missing on screen when an item going live already waited for them.
+    bool redraw = !theme.pendingBackgrounds(themeDisplays()).isEmpty();
+    AssetStore::instance()->addDecoded(themeWatcher->result());
+    theme.loadBackgrounds(themeDisplays());
+    prescaleBackgrounds();
+    if(redraw)
+        updateScreen();
 }
 
 void SoftProjector::showDisplayScreen(bool show)
 {
     if(show)
     {
-        pds1->showFullScreen();
-        pds1->positionControls(mySettings.general.displayControls);
-        pds1->setControlsVisible(true);
+        primaryDisplay()->showFullScreen();
+        primaryDisplay()->positionControls(mySettings.general.displayControls);
+        primaryDisplay()->setControlsVisible(true);
     }
     else
     {
-        pds1->hide();
+        primaryDisplay()->hide();
         QPixmap p;
-        pds1->renderPassiveText(p,false);
+        primaryDisplay()->renderPassiveText(p,false);
         ui->actionCloseDisplay->setEnabled(false);
     }
 
@@ -527,12 +579,21 @@ void SoftProjector::updateSetting(GeneralSettings &g, Theme &t, SlideShowSetting
                                   BibleVersionSettings &bsets3, BibleVersionSettings &bsets4)
 {
     mySettings.general = g;
+    AssetStore::instance()->setMediaFiles(g.useMediaFiles);
     mySettings.slideSets = ssets;
     mySettings.bibleSets = bsets;
     mySettings.bibleSets2 = bsets2;
     mySettings.bibleSets3 = bsets3;
     mySettings.bibleSets4 = bsets4;
     mySettings.saveSettings();
+    if(!mySettings.unsavedSections().isEmpty())
+    {
+        QMessageBox::warning(this,tr("Settings not saved"),
+                             tr("Some settings were saved by a newer version of SoftProjector. "
+                                "This version cannot write them without losing what the newer version stored, "
+                                "so changes to them are only kept until SoftProjector is closed.\n\n"
+                                "Settings not saved: %1").arg(mySettings.unsavedSections().join(", ")));
+    }
     theme = t;
     bibleWidget->setSettings(mySettings.bibleSets);
     pictureWidget->setSettings(mySettings.slideSets);
@@ -541,6 +602,8 @@ void SoftProjector::updateSetting(GeneralSettings &g, Theme &t, SlideShowSetting
     theme.bible2.versions = mySettings.bibleSets2;
     theme.bible3.versions = mySettings.bibleSets3;
     theme.bible4.versions = mySettings.bibleSets4;
+
+    prescaleBackgrounds();
 }
 
 void SoftProjector::applySetting(GeneralSettings &g, Theme &t, SlideShowSettings &s,
@@ -765,9 +828,7 @@ void SoftProjector::setPictureList(QList<SlideShowItem> &image_list,int row,QStr
 
     foreach(const SlideShowItem &p, pictureShowList)
     {
-        QListWidgetItem *itm = new QListWidgetItem;
-        QIcon ico(p.imageSmall);
-        itm->setIcon(ico);
+        QListWidgetItem *itm = p.createListItem();
         ui->listShow->addItem(itm);
     }
 
@@ -800,69 +861,37 @@ void SoftProjector::setVideo(VideoInfo &video)
 
 void SoftProjector::playVideo()
 {
-    pds1->playVideo();
-    if(hasDisplayScreen2)
-    {
-        pds2->playVideo();
-    }
-    if(hasDisplayScreen3)
+    foreach(DisplayOutput *out, outputs)
     {
-        pds3->playVideo();
-    }
-    if(hasDisplayScreen4)
-    {
-        pds4->playVideo();
+        if(out->isConnected && out->shows(VIDEO))
+            out->display->playVideo();
     }
 }
 
 void SoftProjector::pauseVideo()
 {
-    pds1->pauseVideo();
-    if(hasDisplayScreen2)
-    {
-        pds2->pauseVideo();
-    }
-    if(hasDisplayScreen3)
+    foreach(DisplayOutput *out, outputs)
     {
-        pds3->pauseVideo();
-    }
-    if(hasDisplayScreen4)
-    {
-        pds4->pauseVideo();
+        if(out->isConnected && out->shows(VIDEO))
+            out->display->pauseVideo();
     }
 }
 
 void SoftProjector::stopVideo()
 {
-    pds1->stopVideo();
-    if(hasDisplayScreen2)
-    {
-        pds2->stopVideo();
-    }
-    if(hasDisplayScreen3)
+    foreach(DisplayOutput *out, outputs)
     {
-        pds3->stopVideo();
-    }
-    if(hasDisplayScreen4)
-    {
-        pds4->stopVideo();
+        if(out->isConnected)
+            out->display->stopVideo();
     }
 }
 
 void SoftProjector::setVideoPosition(qint64 position)
 {
-    pds1->setVideoPosition(position);
-    if(hasDisplayScreen2)
-    {
-        pds2->setVideoPosition(position);
-    }
-    if(hasDisplayScreen3)
+    foreach(DisplayOutput *out, outputs)
     {
-        pds3->setVideoPosition(position);
-    }
-    if(hasDisplayScreen4)
-    {
-        pds4->setVideoPosition(position);
+        if(out->isConnected && out->shows(VIDEO))
+            out->display->setVideoPosition(position);
     }
 }
 
@@ -891,6 +920,8 @@ void SoftProjector::on_listShow_itemSelectionChanged()
 
 void SoftProjector::updateScreen()
 {
+    RenderSpan span(RenderProfiler::ScreenUpdate);
+
     // Display the specified row of the show (rightmost) table to
     // the display
     int currentRow = ui->listShow->currentRow();
@@ -898,50 +929,16 @@ void SoftProjector::updateScreen()
     if(!showing)
     {
         // Do not display any text:
-        pds1->renderPassiveText(theme.passive.backgroundPix,theme.passive.useBackground);
-
-        if(isSingleScreen)
-            showDisplayScreen(false);
-
-        if(hasDisplayScreen2)
+        foreach(DisplayOutput *out, outputs)
         {
-            if(!theme.passive2.useDisp1settings)
-            {
-                pds2->renderPassiveText(theme.passive2.backgroundPix,theme.passive2.useBackground);
-            }
-            else
-            {
-                pds2->renderPassiveText(theme.passive.backgroundPix,theme.passive.useBackground);
-            }
-
+            if(out->isConnected)
+                out->showPassive(theme);
         }
 
-        if(hasDisplayScreen3)
-        {
-            if(!theme.passive3.useDisp1settings)
-            {
-                pds3->renderPassiveText(theme.passive3.backgroundPix,theme.passive3.useBackground);
-            }
-            else
-            {
-                pds3->renderPassiveText(theme.passive.backgroundPix,theme.passive.useBackground);
-            }
-
-        }
-
-        if(hasDisplayScreen4)
-        {
-            if(!theme.passive4.useDisp1settings)
-            {
-                pds4->renderPassiveText(theme.passive4.backgroundPix,theme.passive4.useBackground);
-            }
-            else
-            {
-                pds4->renderPassiveText(theme.passive.backgroundPix,theme.passive.useBackground);
-            }
+        if(isSingleScreen)
+            showDisplayScreen(false);
 
-        }
-           stopVideo();
+        stopVideo();
         ui->actionShow->setEnabled(true);
         ui->actionHide->setEnabled(false);
         ui->actionClear->setEnabled(false);
@@ -950,12 +947,12 @@ void SoftProjector::updateScreen()
     {
         if(isSingleScreen)
         {
-            if(pds1->isHidden())
+            if(primaryDisplay()->isHidden())
                 showDisplayScreen(true);
         }
         else
         {
-            if(pds1->isHidden() || !ui->actionCloseDisplay->isChecked())
+            if(primaryDisplay()->isHidden() || !ui->actionCloseDisplay->isChecked())
             {
                 ui->actionCloseDisplay->trigger();
             }
@@ -975,6 +972,7 @@ void SoftProjector::updateScreen()
             break;
         }
 
+        loadShownBackgrounds();
         switch (pType)
         {
         case BIBLE:
@@ -1002,194 +1000,187 @@ void SoftProjector::updateScreen()
 void SoftProjector::showBible()
 {
     int srows(ui->listShow->count());
-    QList<int> currentRows;
+    QString verseIds;
     for(int i(0); i<srows; ++i)
     {
         if(ui->listShow->item(i)->isSelected())
-            currentRows.append(i);
-    }
-    pds1->renderBibleText(bibleWidget->bible.getCurrentVerseAndCaption(
-                              currentRows,theme.bible,mySettings.bibleSets),
-                          theme.bible);
-    if(hasDisplayScreen2)
-    {
-        if(!theme.bible2.useDisp1settings)
-        {
-            pds2->renderBibleText(bibleWidget->bible.
-                                  getCurrentVerseAndCaption(currentRows,theme.bible2,
-                                                            mySettings.bibleSets2),theme.bible2);
-        }
-        else
-        {
-            pds2->renderBibleText(bibleWidget->bible.
-                                  getCurrentVerseAndCaption(currentRows,theme.bible,
-                                                            mySettings.bibleSets),theme.bible);
-        }
+            verseIds += bibleWidget->bible.currentIdList.at(i) + ",";
     }
+    verseIds.chop(1);
 
-    if(hasDisplayScreen3)
+    // Outputs that use display one settings get the very same verse and text image.
+    // Text images of outputs with equal settings and size are rendered only once by renderCache.
+    QList<DisplayOutput*> shown;
+    QList<BibleSettings> bs;
+    QList<RenderJob> jobs;
+    Verse verse1;
     {
-        if(!theme.bible3.useDisp1settings)
-        {
-            pds3->renderBibleText(bibleWidget->bible.
-                                  getCurrentVerseAndCaption(currentRows,theme.bible3,
-                                                            mySettings.bibleSets3),theme.bible3);
-        }
-        else
-        {
-            pds3->renderBibleText(bibleWidget->bible.
-                                  getCurrentVerseAndCaption(currentRows,theme.bible,
-                                                            mySettings.bibleSets),theme.bible);
-        }
+        RenderSpan span(RenderProfiler::Database);
+        verse1 = bibleWidget->bible.getVerses(verseIds,theme.bible,mySettings.bibleSets);
     }
-
-    if(hasDisplayScreen4)
+    foreach(DisplayOutput *out, outputs)
     {
-        if(!theme.bible4.useDisp1settings)
+        if(!out->isConnected)
+            continue;
+        if(!out->shows(BIBLE))
         {
-            pds4->renderBibleText(bibleWidget->bible.
-                                  getCurrentVerseAndCaption(currentRows,theme.bible4,
-                                                            mySettings.bibleSets4),theme.bible4);
-        }
-        else
-        {
-            pds4->renderBibleText(bibleWidget->bible.
-                                  getCurrentVerseAndCaption(currentRows,theme.bible,
-                                                            mySettings.bibleSets),theme.bible);
+            out->showPassive(theme);
+            continue;
         }
+        BibleSettings b = theme.bibleFor(out->themeDisplay());
+        out->applyContent(b);
+        shown << out;
+        bs << b;
+        jobs << RenderJob(getBibleVerse(verseIds,b,b.versions,verse1),b,out->display->screenSize());
     }
+
+    QList<TextSettingsBase*> sets;
+    for(int i(0);i<bs.count();++i)
+        sets << &bs[i];
+    showText(shown,sets,jobs);
 }
 
-void SoftProjector::showSong(int currentRow)
+Verse SoftProjector::getBibleVerse(QString &verseIds, BibleSettings &sets, BibleVersionSettings &bv, Verse &verse1)
 {
-    // Get Song Settings
-    SongSettings s1 = theme.song;
-    SongSettings s2 = theme.song2;
-    SongSettings s3 = theme.song3;
-    SongSettings s4 = theme.song4;
+    // Verse text only depends on Bible versions and abbreviation use,
+    // if they are same as on display one, do not query database again.
+    if(sets.useAbbriviation == theme.bible.useAbbriviation
+            && bv.primaryBible == mySettings.bibleSets.primaryBible
+            && bv.secondaryBible == mySettings.bibleSets.secondaryBible
+            && bv.trinaryBible == mySettings.bibleSets.trinaryBible)
+        return verse1;
 
-    // Apply Song specific settings if there is one
-    if(current_song.usePrivateSettings)
-    {
-        current_song.getSettings(s1);
-        current_song.getSettings(s2);
-        current_song.getSettings(s3);
-        current_song.getSettings(s4);
-    }
+    RenderSpan span(RenderProfiler::Database);
+    return bibleWidget->bible.getVerses(verseIds,sets,bv);
+}
 
-    pds1->renderSongText(current_song.getStanza(currentRow),s1);
-    if(hasDisplayScreen2)
-    {
-        if(!theme.song2.useDisp1settings)
-        {
-            pds2->renderSongText(current_song.getStanza(currentRow),s2);
-        }
-        else
-        {
-            pds2->renderSongText(current_song.getStanza(currentRow),s1);
-        }
-    }
-    if(hasDisplayScreen3)
-    {
-        if(!theme.song3.useDisp1settings)
-        {
-            pds3->renderSongText(current_song.getStanza(currentRow),s3);
-        }
-        else
-        {
-            pds3->renderSongText(current_song.getStanza(currentRow),s1);
-        }
-    }
-    if(hasDisplayScreen4)
+void SoftProjector::showSong(int currentRow)
+{
+    Stanza stanza = current_song.getStanza(currentRow);
+    QList<DisplayOutput*> shown;
+    QList<SongSettings> ss;
+    QList<RenderJob> jobs;
+    foreach(DisplayOutput *out, outputs)
     {
-        if(!theme.song4.useDisp1settings)
+        if(!out->isConnected)
+            continue;
+        if(!out->shows(SONG))
         {
-            pds4->renderSongText(current_song.getStanza(currentRow),s4);
-        }
-        else
-        {
-            pds4->renderSongText(current_song.getStanza(currentRow),s1);
+            out->showPassive(theme);
+            continue;
         }
+        SongSettings s = theme.songFor(out->themeDisplay());
+
+        // Apply Song specific settings if there is one
+        if(current_song.usePrivateSettings)
+            current_song.getSettings(s);
+        out->applyContent(s);
+        shown << out;
+        ss << s;
+        jobs << RenderJob(stanza,s,out->display->screenSize());
     }
 
+    QList<TextSettingsBase*> sets;
+    for(int i(0);i<ss.count();++i)
+        sets << &ss[i];
+    showText(shown,sets,jobs);
 }
 
 void SoftProjector::showAnnounce(int currentRow)
 {
-    pds1->renderAnnounceText(currentAnnounce.getAnnounceSlide(currentRow),theme.announce);
-    if(hasDisplayScreen2)
+    AnnounceSlide slide = currentAnnounce.getAnnounceSlide(currentRow);
+    QList<DisplayOutput*> shown;
+    QList<TextSettings> as;
+    QList<RenderJob> jobs;
+    foreach(DisplayOutput *out, outputs)
     {
-        if(!theme.announce2.useDisp1settings)
-        {
-            pds2->renderAnnounceText(currentAnnounce.getAnnounceSlide(currentRow),theme.announce2);
-        }
-        else
+        if(!out->isConnected)
+            continue;
+        if(!out->shows(ANNOUCEMENT))
         {
-            pds2->renderAnnounceText(currentAnnounce.getAnnounceSlide(currentRow),theme.announce);
+            out->showPassive(theme);
+            continue;
         }
+        TextSettings a = theme.announceFor(out->themeDisplay());
+        out->applyContent(a);
+        shown << out;
+        as << a;
+        jobs << RenderJob(slide,a,out->display->screenSize());
     }
-    if(hasDisplayScreen3)
-    {
-        if(!theme.announce3.useDisp1settings)
-        {
-            pds3->renderAnnounceText(currentAnnounce.getAnnounceSlide(currentRow),theme.announce3);
-        }
-        else
-        {
-            pds3->renderAnnounceText(currentAnnounce.getAnnounceSlide(currentRow),theme.announce);
-        }
-    }
-    if(hasDisplayScreen4)
+
+    QList<TextSettingsBase*> sets;
+    for(int i(0);i<as.count();++i)
+        sets << &as[i];
+    showText(shown,sets,jobs);
+}
+
+void SoftProjector::showText(QList<DisplayOutput *> &shown, QList<TextSettingsBase *> &sets, QList<RenderJob> &jobs)
+{
+    // Text layers that differ between outputs are rendered concurrently. All outputs
+    // are staged first and then switched together, so that they change on the same frame.
+    bool nativeText = mySettings.general.useNativeText && SpTextLayer::isSupported();
+    for(int i(0);i<jobs.count();++i)
+        jobs[i].nativeText = nativeText;
+
+    QList<TextFrame> frames = renderCache.render(jobs);
+    stagedOutputs = shown;
+    for(int i(0);i<shown.count();++i)
+        shown.at(i)->display->stageText(*sets.at(i),frames.at(i));
+    showStagedWhenReady();
+}
+
+void SoftProjector::showStagedWhenReady()
+{
+    // Images load asynchronously, every staged output waits until the last one has loaded
+    foreach(DisplayOutput *out, stagedOutputs)
     {
-        if(!theme.announce4.useDisp1settings)
-        {
-            pds4->renderAnnounceText(currentAnnounce.getAnnounceSlide(currentRow),theme.announce4);
-        }
-        else
-        {
-            pds4->renderAnnounceText(currentAnnounce.getAnnounceSlide(currentRow),theme.announce);
-        }
+        if(!out->display->isStagedReady())
+            return;
     }
+    foreach(DisplayOutput *out, stagedOutputs)
+        out->display->showStaged();
+    stagedOutputs.clear();
 }
 
 void SoftProjector::showPicture(int currentRow)
 {
-    pds1->renderSlideShow(pictureShowList.at(currentRow).image,mySettings.slideSets);
-    if(hasDisplayScreen2)
-    {
-        pds2->renderSlideShow(pictureShowList.at(currentRow).image,mySettings.slideSets);
-    }
-    if(hasDisplayScreen3)
-    {
-        pds3->renderSlideShow(pictureShowList.at(currentRow).image,mySettings.slideSets);
-    }
-    if(hasDisplayScreen4)
+    QPixmap image = pictureShowList.at(currentRow).getImage();
+    foreach(DisplayOutput *out, outputs)
     {
-        pds4->renderSlideShow(pictureShowList.at(currentRow).image,mySettings.slideSets);
+        if(!out->isConnected)
+            continue;
+        if(out->shows(PICTURE))
+            out->display->renderSlideShow(image,mySettings.slideSets);
+        else
+            out->showPassive(theme);
     }
+
+    // Decode the neighbouring slides in the background, so that moving through the show stays fast
+    SlideImageCache::instance()->prefetch(pictureShowList,currentRow);
 }
 
 void SoftProjector::showVideo()
 {
-    pds1->renderVideo(currentVideo);
-    pds1->setVideoVolume(100);
-    if(hasDisplayScreen2)
+    // Only the primary display screen plays the sound
+    foreach(DisplayOutput *out, outputs)
     {
-        pds2->setVideoVolume(0);
-        pds2->setVideoMuted(true);
-        pds2->renderVideo(currentVideo);
-    }
-    if(hasDisplayScreen3)
-    {
-        pds3->setVideoVolume(0);
-        pds3->setVideoMuted(true);
-        pds3->renderVideo(currentVideo);
-    }
-    if(hasDisplayScreen4)
-    {
-        pds4->setVideoVolume(0);
-        pds4->setVideoMuted(true);
-        pds4->renderVideo(currentVideo);
+        if(!out->isConnected)
+            continue;
+        if(!out->shows(VIDEO))
+        {
+            out->showPassive(theme);
+        }
+        else if(out->number() == 1)
+        {
+            out->display->renderVideo(currentVideo);
+            out->display->setVideoVolume(100);
+        }
+        else
+        {
+            out->display->setVideoVolume(0);
+            out->display->setVideoMuted(true);
+            out->display->renderVideo(currentVideo);
+        }
     }
 }
 
@@ -1207,18 +1198,10 @@ void SoftProjector::on_actionHide_triggered()
 
 void SoftProjector::on_actionClear_triggered()
 {
-    pds1->renderNotText();
-    if(hasDisplayScreen2)
-    {
-        pds2->renderNotText();
-    }
-    if(hasDisplayScreen3)
-    {
-        pds3->renderNotText();
-    }
-    if(hasDisplayScreen4)
+    foreach(DisplayOutput *out, outputs)
     {
-        pds4->renderNotText();
+        if(out->isConnected)
+            out->display->renderNotText();
     }
     ui->actionClear->setEnabled(false);
     ui->actionShow->setEnabled(true);
@@ -1227,43 +1210,66 @@ void SoftProjector::on_actionClear_triggered()
 
 void SoftProjector::on_actionCloseDisplay_triggered()
 {
-    if(ui->actionCloseDisplay->isChecked())
+    foreach(DisplayOutput *out, outputs)
     {
-        pds1->showFullScreen();
-        if(hasDisplayScreen2)
-        {
-            pds2->showFullScreen();
-        }
-        if(hasDisplayScreen3)
-        {
-            pds3->showFullScreen();
-        }
-        if(hasDisplayScreen4)
-        {
-            pds4->showFullScreen();
-        }
+        if(!out->isConnected)
+            continue;
+        if(ui->actionCloseDisplay->isChecked())
+            out->display->showFullScreen();
+        else
+            out->display->hide();
     }
-    else
-    {
-        pds1->hide();
-        if(hasDisplayScreen2)
-        {
-            pds2->hide();
-        }
-        if(hasDisplayScreen3)
-        {
-            pds3->hide();
-        }
-        if(hasDisplayScreen4)
-        {
-            pds4->hide();
-        }
+    if(!ui->actionCloseDisplay->isChecked())
         showing = false;
-    }
 
     updateCloseDisplayButtons(ui->actionCloseDisplay->isChecked());
 }
 
+void SoftProjector::on_actionRenderTimings_toggled(bool checked)
+{
+    // Overlay with render stage timings, for finding out where slow slide changes spend their time
+    if(!timingOverlay)
+    {
+        timingOverlay = new QLabel(ui->centralWidget);
+        timingOverlay->setFont(QFontDatabase::systemFont(QFontDatabase::FixedFont));
+        timingOverlay->setStyleSheet("QLabel { background-color: rgba(0,0,0,180); color: white; padding: 6px; }");
+        timingOverlay->setAttribute(Qt::WA_TransparentForMouseEvents);
+        timingTimer = new QTimer(this);
+        timingTimer->setInterval(500);
+        connect(timingTimer,SIGNAL(timeout()),this,SLOT(updateRenderTimings()));
+    }
+
+    timingOverlay->setVisible(checked);
+    if(checked)
+    {
+        updateRenderTimings();
+        timingTimer->start();
+    }
+    else
+        timingTimer->stop();
+}
+
+void SoftProjector::updateRenderTimings()
+{
+    timingOverlay->setText(RenderProfiler::instance()->summary().trimmed());
+    timingOverlay->adjustSize();
+    timingOverlay->move(ui->centralWidget->width()-timingOverlay->width()-10,10);
+    timingOverlay->raise();
+}
+
+void SoftProjector::on_actionSaveRenderTimings_triggered()
+{
+    QString path = QFileDialog::getSaveFileName(this,tr("Save render timings as:"),".",
+                                                tr("CSV Files (*.csv)"));
+    if(path.isEmpty())
+        return;
+    if(!path.endsWith(".csv"))
+        path += ".csv";
+
+    if(!RenderProfiler::instance()->saveCsv(path))
+        QMessageBox::warning(this,tr("Error"),tr("Could not save render timings to:\n%1").arg(path));
+}
+
 void SoftProjector::updateCloseDisplayButtons(bool isOn)
 {
     if(isOn)
@@ -2090,6 +2096,7 @@ void SoftProjector::on_actionScheduleRemove_triggered()
     if(cRow >=0)
     {
         schedule.takeAt(cRow);
+        journal.remove(cRow);
         reloadShceduleList();
     }
 }
@@ -2097,6 +2104,8 @@ void SoftProjector::on_actionScheduleRemove_triggered()
 void SoftProjector::on_actionScheduleClear_triggered()
 {
     schedule.clear();
+    renderCache.releasePrepared();
+    journal.clear();
     reloadShceduleList();
 }
 
@@ -2104,6 +2113,7 @@ void SoftProjector::addToShcedule(BibleHistory &b)
 {
     Schedule d(b);
     schedule.append(d);
+    journal.add(d);
     reloadShceduleList();
 }
 
@@ -2111,6 +2121,7 @@ void SoftProjector::addToShcedule(Song &s)
 {
     Schedule d(s);
     schedule.append(d);
+    journal.add(d);
     reloadShceduleList();
 }
 
@@ -2118,6 +2129,7 @@ void SoftProjector::addToShcedule(SlideShow &s)
 {
     Schedule d(s);
     schedule.append(d);
+    journal.add(d);
     reloadShceduleList();
 }
 
@@ -2125,6 +2137,7 @@ void SoftProjector::addToShcedule(VideoInfo &v)
 {
     Schedule d(v);
     schedule.append(d);
+    journal.add(d);
     reloadShceduleList();
 }
 
@@ -2132,6 +2145,7 @@ void SoftProjector::addToShcedule(Announcement &a)
 {
     Schedule d(a);
     schedule.append(d);
+    journal.add(d);
     reloadShceduleList();
 }
 
@@ -2152,6 +2166,7 @@ void SoftProjector::reloadShceduleList()
 
 void SoftProjector::on_listWidgetSchedule_doubleClicked(const QModelIndex &index)
 {
+    loadScheduleItems(index.row());
     Schedule s = schedule.at(index.row());
     if(s.stype == "bible")
     {
@@ -2191,6 +2206,7 @@ void SoftProjector::on_listWidgetSchedule_itemSelectionChanged()
     int currentRow = ui->listWidgetSchedule->currentRow();
     if(currentRow>=0)
     {
+        loadScheduleItems(currentRow);
         Schedule s = schedule.at(currentRow);
         if(s.stype == "bible")
         {
@@ -2226,6 +2242,7 @@ void SoftProjector::on_actionMoveScheduleTop_triggered()
     if(cs>0)
     {
         schedule.move(cs,0);
+        journal.move(cs,0);
         reloadShceduleList();
         ui->listWidgetSchedule->setCurrentRow(0);
     }
@@ -2237,6 +2254,7 @@ void SoftProjector::on_actionMoveScheduleUp_triggered()
     if(cs>0)
     {
         schedule.move(cs,cs-1);
+        journal.move(cs,cs-1);
         reloadShceduleList();
         ui->listWidgetSchedule->setCurrentRow(cs-1);
     }
@@ -2249,6 +2267,7 @@ void SoftProjector::on_actionMoveScheduleDown_triggered()
     if(cs>=0 && cs<max-1)
     {
         schedule.move(cs,cs+1);
+        journal.move(cs,cs+1);
         reloadShceduleList();
         ui->listWidgetSchedule->setCurrentRow(cs+1);
     }
@@ -2261,6 +2280,7 @@ void SoftProjector::on_actionMoveScheduleBottom_triggered()
     if(cs>=0 && cs<max-1)
     {
         schedule.move(cs,max-1);
+        journal.move(cs,max-1);
         reloadShceduleList();
         ui->listWidgetSchedule->setCurrentRow(max-1);
     }
@@ -2298,6 +2318,8 @@ void SoftProjector::on_actionNewSchedule_triggered()
 
     schedule_file_path = "untitled.spsc";
     schedule.clear();
+    renderCache.releasePrepared();
+    journal.start(schedule_file_path);
     reloadShceduleList();
     is_schedule_saved = false;
     updateWindowText();
@@ -2339,6 +2361,7 @@ void SoftProjector::on_actionOpenSchedule_triggered()
     {
         schedule_file_path = path;
         openSchedule();
+        journal.start(schedule_file_path);
         is_schedule_saved = true;
         updateWindowText();
     }
@@ -2401,6 +2424,8 @@ void SoftProjector::on_actionCloseSchedule_triggered()
 
     schedule_file_path.clear();
     schedule.clear();
+    renderCache.releasePrepared();
+    journal.start(schedule_file_path);
     reloadShceduleList();
     is_schedule_saved = true;
     updateWindowText();
@@ -2413,282 +2438,103 @@ void SoftProjector::saveSchedule(bool overWrite)
     progress.setMaximum(0);
     progress.setLabelText(tr("Saving schedule file..."));
     progress.show();
-    {
-        bool db_exist = QFile::exists(schedule_file_path);
-        if(db_exist && overWrite)
-        {
-            if(!QFile::remove(schedule_file_path))
-            {
-                QMessageBox mb(this);
-                mb.setText(tr("An error has ocured when overwriting existing file.\n"
-                              "Please try again with different file name."));
-                mb.setIcon(QMessageBox::Information);
-                mb.setStandardButtons(QMessageBox::Ok);
-                mb.exec();
-                return;
-            }
-            else
-                db_exist = false;
-        }
-        QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE","spsc");
-        db.setDatabaseName(schedule_file_path);
-        if(db.open())
-        {
-            QSqlQuery sq(db);
-            sq.exec("PRAGMA user_version = 2");
-            sq.exec("CREATE TABLE IF NOT EXISTS 'schedule' ('id' INTEGER PRIMARY KEY  AUTOINCREMENT  NOT NULL, "
-                    "'stype' TEXT, 'name' TEXT, 'sorder' INTEGER )");
-            sq.exec("CREATE TABLE IF NOT EXISTS 'bible' ('scid' INTEGER, 'verseIds' TEXT, 'caption' TEXT, 'captionLong' TEXT)");
-            sq.exec("CREATE TABLE IF NOT EXISTS 'song' ('scid' INTEGER, 'songid' INTEGER, 'sbid' INTEGER, 'sbName' TEXT, "
-                    "'number' INTEGER, 'title' TEXT, 'category' INTEGER, 'tune' TEXT, 'wordsBy' TEXT, 'musicBy' TEXT, "
-                    "'songText' TEXT, 'notes' TEXT, 'usePrivate' BOOL, 'alignV' INTEGER, 'alignH' INTEGER, 'color' INTEGER, "
-                    "'font' TEXT, 'infoColor' INTEGER, 'infoFont' TEXT, 'endingColor' INTEGER, 'endingFont' TEXT, "
-                    "'useBack' BOOL, 'backImage' BLOB, 'backName' TEXT)");
-            sq.exec("CREATE TABLE IF NOT EXISTS 'slideshow' ('scid' INTEGER, 'ssid' INTEGER, 'name' TEXT, 'info' TEXT)");
-            sq.exec("CREATE TABLE IF NOT EXISTS 'slides' ('scid' INTEGER, 'sid' INTEGER, 'name' TEXT, 'path' TEXT, "
-                    "'porder' INTEGER, 'image' BLOB, 'imageSmall' BLOB, 'imagePreview' BLOB)");
-            sq.exec("CREATE TABLE IF NOT EXISTS 'media' ('scid' INTEGER, 'name' TEXT, 'path' TEXT, 'aRatio' INTEGER)");
-            sq.exec("CREATE TABLE IF NOT EXISTS 'announce' ('scid' INTEGER, 'aId' INTEGER, 'title' TEXT, 'aText' TEXT, "
-                    "'usePrivate' BOOL, 'useAuto' BOOL, 'loop' BOOL, 'slideTimer' INTEGER, 'font' TEXT, 'color' INTEGER, "
-                    "'useBack' BOOL, 'backImage' BLOB, 'backPath' TEXT, 'alignV' INTEGER, 'alignH' INTEGER)");
-            if(db_exist)
-                saveScheduleUpdate(sq);
-            else
-                saveScheduleNew(sq);
-        }
-    }
-    QSqlDatabase::removeDatabase("spsc");
-    is_schedule_saved = true;
-    progress.close();
-}
 
-void SoftProjector::saveScheduleNew(QSqlQuery &q)
-{
-    for(int i(0);i < schedule.count();++i)
-    {
-        Schedule sc =  schedule.at(i);
-        q.exec(QString("INSERT INTO schedule (stype,name,sorder) VALUES('%1','%2',%3)")
-               .arg(sc.stype).arg(sc.name).arg(i+1));
-        q.exec("SELECT seq FROM sqlite_sequence WHERE name = 'schedule'");
-        q.first();
-        sc.scid = q.value(0).toInt();
-        q.clear();
-        if(sc.stype == "bible")
-            saveScheduleItemNew(q,sc.scid,sc.bible);
-        else if(sc.stype == "song")
-            saveScheduleItemNew(q,sc.scid,sc.song);
-        else if(sc.stype == "slideshow")
-            saveScheduleItemNew(q,sc.scid,sc.slideshow);
-        else if(sc.stype == "media")
-            saveScheduleItemNew(q,sc.scid,sc.media);
-        else if(sc.stype == "announce")
-            saveScheduleItemNew(q,sc.scid,sc.announce);
-        schedule.replace(i,sc);
-    }
-}
-
-void SoftProjector::saveScheduleItemNew(QSqlQuery &q, int scid, const BibleHistory &b)
-{
-    q.prepare("INSERT INTO bible (scid,verseIds,caption,captionLong) VALUES(?,?,?,?)");
-    q.addBindValue(scid);
-    q.addBindValue(b.verseIds);
-    q.addBindValue(b.caption);
-    q.addBindValue(b.captionLong);
-    q.exec();
-}
-
-void SoftProjector::saveScheduleItemNew(QSqlQuery &q, int scid, const Song &s)
-{
-    q.prepare("INSERT INTO song (scid,songid,sbid,sbName,number,title,category,tune,wordsBy,musicBy,"
-              "songText,notes,usePrivate,alignV,alignH,color,font,infoColor,infoFont,endingColor,"
-              "endingFont,useBack,backImage,backName) "
-              "VALUES(?,?,?,?,?,?,?,?,?,?,?,?,?,?,?,?,?,?,?,?,?,?,?,?)");
-    q.addBindValue(scid);
-    q.addBindValue(s.songID);
-    q.addBindValue(s.songbook_id);
-    q.addBindValue(s.songbook_name);
-    q.addBindValue(s.number);
-    q.addBindValue(s.title);
-    q.addBindValue(s.category);
-    q.addBindValue(s.tune);
-    q.addBindValue(s.wordsBy);
-    q.addBindValue(s.musicBy);
-    q.addBindValue(s.songText);
-    q.addBindValue(s.notes);
-    q.addBindValue(s.usePrivateSettings);
-    q.addBindValue(s.alignmentV);
-    q.addBindValue(s.alignmentH);
-    q.addBindValue((unsigned int)(s.color.rgb()));
-    q.addBindValue(s.font.toString());
-    q.addBindValue((unsigned int)(s.infoColor.rgb()));
-    q.addBindValue(s.infoFont.toString());
-    q.addBindValue((unsigned int)(s.endingColor.rgb()));
-    q.addBindValue(s.endingFont.toString());
-    q.addBindValue(s.useBackground);
-    q.addBindValue(pixToByte(s.background));
-    q.addBindValue(s.backgroundName);
-    q.exec();
-}
-
-void SoftProjector::saveScheduleItemNew(QSqlQuery &q, int scid, const SlideShow &s)
-{
-    q.prepare("INSERT INTO slideshow (scid,ssid,name,info) VALUES (?,?,?,?)");
-    q.addBindValue(scid);
-    q.addBindValue(s.slideShowId);
-    q.addBindValue(s.name);
-    q.addBindValue(s.info);
-    q.exec();
-
-    foreach(const SlideShowItem & si,s.slides)
-    {
-        q.prepare("INSERT INTO slides (scid,sid,name,path,porder,image,imageSmall,imagePreview) VALUES(?,?,?,?,?,?,?,?)");
-        q.addBindValue(scid);
-        q.addBindValue(si.slideId);
-        q.addBindValue(si.name);
-        q.addBindValue(si.path);
-        q.addBindValue(si.order);
-        q.addBindValue(pixToByte(si.image));
-        q.addBindValue(pixToByte(si.imageSmall));
-        q.addBindValue(pixToByte(si.imagePreview));
-        q.exec();
-    }
-}
-
-void SoftProjector::saveScheduleItemNew(QSqlQuery &q, int scid, const VideoInfo &v)
-{
-    q.prepare("INSERT INTO media (scid,name,path,aRatio) VALUES(?,?,?,?)");
-    q.addBindValue(scid);
-    q.addBindValue(v.fileName);
-    q.addBindValue(v.filePath);
-    q.addBindValue(v.aspectRatio);
-    q.exec();
-}
-
-void SoftProjector::saveScheduleItemNew(QSqlQuery &q, int scid, const Announcement &a)
-{
-    q.prepare("INSERT INTO announce (scid,aId,title,aText,usePrivate,useAuto,loop,slideTimer,font,"
-                        "color,useBack,backImage,backPath,alignV,alignH) "
-                        "VALUES(?,?,?,?,?,?,?,?,?,?,?,?,?,?,?)");
-    q.addBindValue(scid);
-    q.addBindValue(a.idNum);
-    q.addBindValue(a.title);
-    q.addBindValue(a.text);
-    q.addBindValue(a.usePrivateSettings);
-    q.addBindValue(a.useAutoNext);
-    q.addBindValue(a.loop);
-    q.addBindValue(a.slideTimer);
-    q.addBindValue(a.font.toString());
-    unsigned int tci = (unsigned int)(a.color.rgb());
-    q.addBindValue(tci);
-    q.addBindValue(a.useBackground);
-    q.addBindValue(pixToByte(QPixmap()));
-    q.addBindValue(a.backgroundPath);
-    q.addBindValue(a.alignmentV);
-    q.addBindValue(a.alignmentH);
-    q.exec();
-}
-
-void SoftProjector::saveScheduleUpdate(QSqlQuery &q)
-{
-    for(int i(0);i < schedule.count();++i)
-    {
-        Schedule sc =  schedule.at(i);
-        if(sc.scid == -1)   // Save new schedule item that was not saved yet
-        {
-            q.exec(QString("INSERT INTO schedule (stype,name,sorder) VALUES('%1','%2',%3)")
-                   .arg(sc.stype).arg(sc.name).arg(i+1));
-            q.exec("SELECT seq FROM sqlite_sequence WHERE name = 'schedule'");
-            q.first();
-            sc.scid = q.value(0).toInt();
-            q.clear();
-            if(sc.stype == "bible")
-                saveScheduleItemNew(q,sc.scid,sc.bible);
-            else if(sc.stype == "song")
-                saveScheduleItemNew(q,sc.scid,sc.song);
-            else if(sc.stype == "slideshow")
-                saveScheduleItemNew(q,sc.scid,sc.slideshow);
-            else if(sc.stype == "media")
-                saveScheduleItemNew(q,sc.scid,sc.media);
-            else if(sc.stype == "announce")
-                saveScheduleItemNew(q,sc.scid,sc.announce);
-            schedule.replace(i,sc);
-        }
-        else    // Update existing schedule item
-        {
-            q.exec(QString("UPDATE schedule SET sorder = %1 WHERE id = %2").arg(i+1).arg(sc.scid));
-            //if(sc.stype == "bible")
-            //    saveScheduleItemUpdate(q,sc.scid,sc.bible);
-            //else if(sc.stype == "song")
-            //    saveScheduleItemUpdate(q,sc.scid,sc.song);
-            //else if(sc.stype == "slideshow")
-            //    saveScheduleItemUpdate(q,sc.scid,sc.slideshow);
-            //else if(sc.stype == "media")
-            //    saveScheduleItemUpdate(q,sc.scid,sc.media);
-            //else if(sc.stype == "announce")
-            //    saveScheduleItemUpdate(q,sc.scid,sc.announce);
-        }
-    }
+    bool db_exist = QFile::exists(schedule_file_path);
+    if(overWrite || !db_exist)
+        loadScheduleItems(-1); // every item is written to a new file
 
-    // Delete any shcedule items from file that have removed from schedule
-    q.exec("SELECT id,stype FROM schedule");
-    QSqlQuery sq = q;
-    while(q.next())
+    if(db_exist && overWrite)
     {
-        int scid = q.value(0).toInt();
-        bool toDelete = false;
-        QString stype = q.value(1).toString();
-        foreach(const Schedule &s,schedule)
+        if(!QFile::remove(schedule_file_path))
         {
-            if(scid == s.scid)
-            {
-                toDelete = false;
-                break;
-            }
-            else
-                toDelete = true;
-        }
-
-        if(toDelete)
-        {
-            sq.exec("DELETE FROM schedule WHERE id = " + QString::number(scid));
-            sq.exec("DELETE FROM " + stype + " WHERE scid = " + QString::number(scid));
-            if(stype == "slideshow")
-                sq.exec("DELETE FROM slides WHERE scid = " + QString::number(scid));
+            QMessageBox mb(this);
+            mb.setText(tr("An error has ocured when overwriting existing file.\n"
+                          "Please try again with different file name."));
+            mb.setIcon(QMessageBox::Information);
+            mb.setStandardButtons(QMessageBox::Ok);
+            mb.exec();
+            return;
         }
+        else
+            db_exist = false;
     }
+
+    // A new file gets every item, an existing one only what changed since the last save
+    if(writeSchedule(!db_exist))
+        schedule_source_path = schedule_file_path;
+    progress.close();
 }
 
-void SoftProjector::saveScheduleItemUpdate(QSqlQuery &q, int scid, const BibleHistory &b)
+bool SoftProjector::writeSchedule(bool all)
 {
-
+    ScheduleFile file(schedule_file_path);
+    if(!file.save(schedule,all))
+        return false;
+    journal.start(schedule_file_path); // the file holds every edit now
+    is_schedule_saved = true;
+    return true;
 }
 
-void SoftProjector::saveScheduleItemUpdate(QSqlQuery &q, int scid, const Song &s)
+void SoftProjector::autosaveSchedule()
 {
-
+    // Saving is incremental, so this is cheap when little has changed
+    if(!mySettings.general.autosaveSchedule || is_schedule_saved || schedule_file_path.isEmpty()
+            || schedule_file_path.startsWith("untitled") || !QFile::exists(schedule_file_path))
+        return;
+    if(writeSchedule(false))
+        updateWindowText();
 }
 
-void SoftProjector::saveScheduleItemUpdate(QSqlQuery &q, int scid, const SlideShow &s)
+void SoftProjector::startupFinished()
 {
-
+    // Queued from main, runs once the event loop has processed the first show
+    StartupProfiler::instance()->finish();
 }
 
-void SoftProjector::saveScheduleItemUpdate(QSqlQuery &q, int scid, const VideoInfo &v)
+void SoftProjector::recoverSchedule()
 {
+    // A journal left behind means the last session did not end normally.
+    // The schedule is rebuilt from its file and the edits made after it was last
+    // saved, and written back to the file, so that the journal can start over.
+    QString journalPath = appDataDir.absoluteFilePath("schedule.journal");
+    journal.setFileName(journalPath);
 
-}
+    QString path;
+    if(!ScheduleJournal::readStart(journalPath,path))
+    {
+        journal.start(schedule_file_path);
+        return;
+    }
 
-void SoftProjector::saveScheduleItemUpdate(QSqlQuery &q, int scid, const Announcement &a)
-{
+    schedule.clear();
+    renderCache.releasePrepared();
+    schedule_file_path = path;
+    if(QFile::exists(schedule_file_path))
+        openSchedule();
+    int edits = ScheduleJournal::replay(journalPath,schedule);
+    reloadShceduleList();
 
+    if(edits == 0)
+    {
+        is_schedule_saved = true;
+        journal.start(schedule_file_path);
+    }
+    else if(schedule_file_path.startsWith("untitled") || !QFile::exists(schedule_file_path)
+            || !writeSchedule(false))
+    {
+        // No file to write to, keep the recovered items in a new journal
+        journal.start(schedule_file_path);
+        foreach(const Schedule &sc, schedule)
+            journal.add(sc);
+    }
+    updateWindowText();
 }
 
 void SoftProjector::openSchedule()
 {
-    QProgressDialog progress;
-    progress.setMaximum(0);
-    progress.setLabelText(tr("Opening schedule file..."));
-    progress.show();
+    // The outline is read with one query per item type and shown right away.
+    // Song backgrounds and slide images stay in the file until an item is first
+    // selected, see loadScheduleItems().
     {
         QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE","spsc");
         db.setDatabaseName(schedule_file_path);
@@ -2700,61 +2546,45 @@ void SoftProjector::openSchedule()
             int scVer = sq.value(0).toInt();
             if(scVer == 2)
             {
+                QHash<int,BibleHistory> bibles;
+                QHash<int,Song> songs;
+                QHash<int,SlideShow> slideShows;
+                QHash<int,VideoInfo> media;
+                QHash<int,Announcement> announcements;
+                openScheduleItems(sq,bibles);
+                openScheduleItems(sq,songs);
+                openScheduleItems(sq,slideShows);
+                openScheduleItems(sq,media);
+                openScheduleItems(sq,announcements);
+
                 schedule.clear();
+                renderCache.releasePrepared();
                 sq.exec("SELECT id, stype, name FROM schedule ORDER BY sorder");
-                QSqlQuery sqsc = sq;
                 while(sq.next())
                 {
                     int scid = sq.value(0).toInt();
                     QString stype = sq.value(1).toString();
-                    QString name = sq.value(2).toString();
 
+                    Schedule sc;
                     if(stype == "bible")
-                    {
-                        BibleHistory bib;
-                        openScheduleItem(sqsc,scid,bib);
-                        Schedule sc(bib);
-                        sc.name = name;
-                        sc.scid = scid;
-                        schedule.append(sc);
-                    }
+                        sc = Schedule(bibles[scid]);
                     else if(stype == "song")
-                    {
-                        Song song;
-                        openScheduleItem(sqsc,scid,song);
-                        Schedule sc(song);
-                        sc.name = name;
-                        sc.scid = scid;
-                        schedule.append(sc);
-                    }
+                        sc = Schedule(songs[scid]);
                     else if(stype == "slideshow")
-                    {
-                        SlideShow ss;
-                        openScheduleItem(sqsc,scid,ss);
-                        Schedule sc(ss);
-                        sc.name = name;
-                        sc.scid = scid;
-                        schedule.append(sc);
-                    }
+                        sc = Schedule(slideShows[scid]);
                     else if(stype == "media")
-                    {
-                        VideoInfo vi;
-                        openScheduleItem(sqsc,scid,vi);
-                        Schedule sc(vi);
-                        sc.name = name;
-                        sc.scid = scid;
-                        schedule.append(sc);
-                    }
+                        sc = Schedule(media[scid]);
                     else if(stype == "announce")
-                    {
-                        Announcement announce;
-                        openScheduleItem(sqsc,scid,announce);
-                        Schedule sc(announce);
-                        sc.name = name;
-                        sc.scid = scid;
-                        schedule.append(sc);
-                    }
+                        sc = Schedule(announcements[scid]);
+                    else
+                        continue;
+                    sc.name = sq.value(2).toString();
+                    sc.scid = scid;
+                    sc.sorder = schedule.count()+1;
+                    sc.isLoaded = (stype != "song" && stype != "slideshow");
+                    schedule.append(sc);
                 }
+                schedule_source_path = schedule_file_path;
                 reloadShceduleList();
             }
             else
@@ -2772,97 +2602,326 @@ void SoftProjector::openSchedule()
         }
     }
     QSqlDatabase::removeDatabase("spsc");
-    progress.close();
 }
 
-void SoftProjector::openScheduleItem(QSqlQuery &q, const int scid, BibleHistory &b)
-{
-    q.exec("SELECT verseIds, caption, captionLong FROM bible WHERE scid = " + QString::number(scid));
-    q.first();
-    b.verseIds = q.value(0).toString();
-    b.caption = q.value(1).toString();
-    b.caption = q.value(2).toString();
-}
-
-void SoftProjector::openScheduleItem(QSqlQuery &q, const int scid, Song &s)
-{
-    q.exec("SELECT * FROM song WHERE scid = " + QString::number(scid));
-    q.first();
-    QSqlRecord r = q.record();
-    s.songID = r.field("songid").value().toInt();
-    s.songbook_id = r.field("sbid").value().toString();
-    s.songbook_name = r.field("sbName").value().toString();
-    s.number = r.field("number").value().toInt();
-    s.title = r.field("title").value().toString();
-    s.category = r.field("category").value().toInt();
-    s.tune = r.field("tune").value().toString();
-    s.wordsBy = r.field("wordsBy").value().toString();
-    s.musicBy = r.field("musicBy").value().toString();
-    s.songText = r.field("songText").value().toString();
-    s.notes = r.field("notes").value().toString();
-    s.usePrivateSettings = r.field("usePrivate").value().toBool();
-    s.alignmentV = r.field("alignV").value().toInt();
-    s.alignmentH = r.field("alignH").value().toInt();
-    s.color = QColor::fromRgb(r.field("color").value().toUInt());
-    s.font.fromString(r.field("font").value().toString());
-    s.infoColor = QColor::fromRgb(r.field("infoColor").value().toUInt());
-    s.infoFont.fromString(r.field("infoFont").value().toString());
-    s.endingColor = QColor::fromRgb(r.field("endingColor").value().toUInt());
-    s.endingFont.fromString(r.field("endingFont").value().toString());
-    s.useBackground = r.field("useBack").value().toBool();
-    s.background.loadFromData(r.field("backImage").value().toByteArray());
-    s.backgroundName = r.field("backName").value().toString();
-}
-
-void SoftProjector::openScheduleItem(QSqlQuery &q, const int scid, SlideShow &s)
-{
-    q.exec("SELECT ssid, name, info FROM slideshow WHERE scid = " + QString::number(scid));
-    q.first();
-    s.slideShowId = q.value(0).toInt();
-    s.name = q.value(1).toString();
-    s.info = q.value(2).toString();
-
-    q.exec("SELECT sid, name, path, porder, image, imageSmall, imagePreview FROM slides WHERE scid = " + QString::number(scid));
+void SoftProjector::openScheduleItems(QSqlQuery &q, QHash<int, BibleHistory> &items)
+{
+    q.exec("SELECT scid, verseIds, caption, captionLong FROM bible");
+    while(q.next())
+    {
+        BibleHistory &b = items[q.value(0).toInt()];
+        b.verseIds = q.value(1).toString();
+        b.caption = q.value(2).toString();
+        b.captionLong = q.value(3).toString();
+    }
+}
+
+void SoftProjector::openScheduleItems(QSqlQuery &q, QHash<int, Song> &items)
+{
+    // Everything but the background image
+    q.exec("SELECT scid, songid, sbid, sbName, number, title, category, tune, wordsBy, musicBy, songText, "
+           "notes, usePrivate, alignV, alignH, color, font, infoColor, infoFont, endingColor, endingFont, "
+           "useBack, backName FROM song");
+    while(q.next())
+    {
+        Song &s = items[q.value(0).toInt()];
+        s.songID = q.value(1).toInt();
+        s.songbook_id = q.value(2).toString();
+        s.songbook_name = q.value(3).toString();
+        s.number = q.value(4).toInt();
+        s.title = q.value(5).toString();
+        s.category = q.value(6).toInt();
+        s.tune = q.value(7).toString();
+        s.wordsBy = q.value(8).toString();
+        s.musicBy = q.value(9).toString();
+        s.songText = q.value(10).toString();
+        s.notes = q.value(11).toString();
+        s.usePrivateSettings = q.value(12).toBool();
+        s.alignmentV = q.value(13).toInt();
+        s.alignmentH = q.value(14).toInt();
+        s.color = QColor::fromRgb(q.value(15).toUInt());
+        s.font.fromString(q.value(16).toString());
+        s.infoColor = QColor::fromRgb(q.value(17).toUInt());
+        s.infoFont.fromString(q.value(18).toString());
+        s.endingColor = QColor::fromRgb(q.value(19).toUInt());
+        s.endingFont.fromString(q.value(20).toString());
+        s.useBackground = q.value(21).toBool();
+        s.backgroundName = q.value(22).toString();
+    }
+}
+
+void SoftProjector::openScheduleItems(QSqlQuery &q, QHash<int, SlideShow> &items)
+{
+    q.exec("SELECT scid, ssid, name, info FROM slideshow");
+    while(q.next())
+    {
+        SlideShow &s = items[q.value(0).toInt()];
+        s.slideShowId = q.value(1).toInt();
+        s.name = q.value(2).toString();
+        s.info = q.value(3).toString();
+    }
+
+    // Slides without their images
+    q.exec("SELECT scid, sid, name, path, porder FROM slides ORDER BY scid, rowid");
     while(q.next())
     {
         SlideShowItem si;
-        si.slideId = q.value(0).toInt();
-        si.name = q.value(1).toString();
-        si.path = q.value(2).toString();
-        si.order = q.value(3).toInt();
-        si.image.loadFromData(q.value(4).toByteArray());
-        si.imageSmall.loadFromData(q.value(5).toByteArray());
-        si.imagePreview.loadFromData(q.value(6).toByteArray());
-        s.slides.append(si);
-    }
-}
-
-void SoftProjector::openScheduleItem(QSqlQuery &q, const int scid, VideoInfo &v)
-{
-    q.exec("SELECT name, path, aRatio FROM media WHERE scid = " + QString::number(scid));
-    q.first();
-    v.fileName = q.value(0).toString();
-    v.filePath = q.value(1).toString();
-    v.aspectRatio = q.value(2).toInt();
-}
-
-void SoftProjector::openScheduleItem(QSqlQuery &q, const int scid, Announcement &a)
-{
-    q.exec("SELECT aId, title, aText, usePrivate, useAuto, loop, slideTimer, font, color, useBack, "
-           "backImage, backPath, alignV, alignH FROM announce WHERE scid = " + QString::number(scid));
-    q.first();
-    a.idNum = q.value(0).toInt();
-    a.title = q.value(1).toString();
-    a.text = q.value(2).toString();
-    a.usePrivateSettings = q.value(3).toBool();
-    a.useAutoNext = q.value(4).toBool();
-    a.loop = q.value(5).toBool();
-    a.slideTimer = q.value(6).toInt();
-    a.font.fromString(q.value(7).toString());
-    a.color = QColor::fromRgb(q.value(8).toUInt());
-    a.useBackground = q.value(9).toBool();
-//    a.backImage = QPixmap
-    a.backgroundPath = q.value(11).toString();
-    a.alignmentV = q.value(12).toInt();
-    a.alignmentH = q.value(13).toInt();
+        si.slideId = q.value(1).toInt();
+        si.name = q.value(2).toString();
+        si.path = q.value(3).toString();
+        si.order = q.value(4).toInt();
+        items[q.value(0).toInt()].slides.append(si);
+    }
+}
+
+void SoftProjector::openScheduleItems(QSqlQuery &q, QHash<int, VideoInfo> &items)
+{
+    q.exec("SELECT scid, name, path, aRatio FROM media");
+    while(q.next())
+    {
+        VideoInfo &v = items[q.value(0).toInt()];
+        v.fileName = q.value(1).toString();
+        v.filePath = q.value(2).toString();
+        v.aspectRatio = q.value(3).toInt();
+    }
+}
+
+void SoftProjector::openScheduleItems(QSqlQuery &q, QHash<int, Announcement> &items)
+{
+    q.exec("SELECT scid, aId, title, aText, usePrivate, useAuto, loop, slideTimer, font, color, useBack, "
+           "backPath, alignV, alignH FROM announce");
+    while(q.next())
+    {
+        Announcement &a = items[q.value(0).toInt()];
+        a.idNum = q.value(1).toInt();
+        a.title = q.value(2).toString();
+        a.text = q.value(3).toString();
+        a.usePrivateSettings = q.value(4).toBool();
+        a.useAutoNext = q.value(5).toBool();
+        a.loop = q.value(6).toBool();
+        a.slideTimer = q.value(7).toInt();
+        a.font.fromString(q.value(8).toString());
+        a.color = QColor::fromRgb(q.value(9).toUInt());
+        a.useBackground = q.value(10).toBool();
+        a.backgroundPath = q.value(11).toString();
+        a.alignmentV = q.value(12).toInt();
+        a.alignmentH = q.value(13).toInt();
+    }
+}
+
+void SoftProjector::loadScheduleItems(int row)
+{
+    // Reads song backgrounds and slide images of items opened as outline only,
+    // for one row or for all rows when row is -1. Full size slide images are
+    // kept encoded until they are shown.
+    QList<int> rows;
+    for(int i(0);i<schedule.count();++i)
+    {
+        if(!schedule.at(i).isLoaded && (row == -1 || row == i))
+            rows.append(i);
+    }
+    if(rows.isEmpty())
+        return;
+
+    {
+        QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE","spscLoad");
+        db.setDatabaseName(schedule_source_path);
+        if(db.open())
+        {
+            QSqlQuery q(db);
+            foreach(int i, rows)
+            {
+                Schedule &sc = schedule[i];
+                if(sc.stype == "song")
+                {
+                    q.prepare("SELECT backImage FROM song WHERE scid = ?");
+                    q.addBindValue(sc.scid);
+                    q.exec();
+                    if(q.first())
+                        sc.song.background.loadFromData(q.value(0).toByteArray());
+                }
+                else if(sc.stype == "slideshow")
+                {
+                    q.prepare("SELECT image, imageSmall, imagePreview FROM slides WHERE scid = ? ORDER BY rowid");
+                    q.addBindValue(sc.scid);
+                    q.exec();
+                    for(int j(0);q.next() && j<sc.slideshow.slides.count();++j)
+                    {
+                        SlideShowItem &si = sc.slideshow.slides[j];
+                        si.imageData = q.value(0).toByteArray();
+                        si.imageSmallData = q.value(1).toByteArray();
+                        si.imagePreviewData = q.value(2).toByteArray();
+                        si.imageSmall.loadFromData(si.imageSmallData);
+                        si.imagePreview.loadFromData(si.imagePreviewData);
+                    }
+                }
+                sc.isLoaded = true;
+            }
+        }
+    }
+    QSqlDatabase::removeDatabase("spscLoad");
+}
+
+void SoftProjector::on_actionPrepareService_triggered()
+{
+    // Reads, decodes and renders the first slides of every schedule item for every
+    // display screen ahead of the service, so that items go live without delay.
+    if(prepareRow != -1 || schedule.isEmpty())
+        return;
+
+    if(!prepareDialog)
+    {
+        prepareDialog = new QProgressDialog(this);
+        prepareDialog->setWindowTitle(tr("Prepare Service"));
+        prepareDialog->setAutoClose(false);
+        prepareDialog->setAutoReset(false);
+        prepareDialog->setMinimumDuration(0);
+    }
+    prepareDialog->reset();
+    prepareDialog->setCancelButtonText(tr("Cancel"));
+    prepareDialog->setRange(0,schedule.count());
+    prepareDialog->setValue(0);
+    prepareDialog->show();
+
+    // The previous preparation is replaced
+    renderCache.releasePrepared();
+    foreach(DisplayOutput *out, outputs)
+        out->display->clearPrescaled();
+    prescaleBackgrounds();
+    prepareRow = 0;
+    prepareNextItem();
+}
+
+void SoftProjector::prepareNextItem()
+{
+    // Database reads and song parsing are done here one item at a time,
+    // text rendering of the item runs on worker threads.
+    if(prepareRow == -1)
+        return;
+    if(prepareDialog->wasCanceled() || prepareRow >= schedule.count())
+    {
+        finishPrepare();
+        return;
+    }
+
+    int row = prepareRow++;
+    prepareDialog->setValue(row);
+    prepareDialog->setLabelText(tr("Preparing: %1").arg(schedule.at(row).name));
+    loadScheduleItems(row);
+
+    QList<RenderJob> jobs = prepareJobs(schedule[row]);
+    bool nativeText = mySettings.general.useNativeText && SpTextLayer::isSupported();
+    for(int i(0);i<jobs.count();++i)
+        jobs[i].nativeText = nativeText;
+    prepareWatcher->setFuture(QtConcurrent::run(warmRender,&renderCache,jobs));
+}
+
+QList<RenderJob> SoftProjector::prepareJobs(Schedule &sc)
+{
+    // Same settings and content as showBible(), showSong(), showAnnounce() and
+    // showPicture() use, so that the prepared text images and scaled backgrounds
+    // are found in the caches when the item goes live.
+    QList<RenderJob> jobs;
+
+    if(sc.stype == "bible")
+    {
+        Verse verse1 = bibleWidget->bible.getVerses(sc.bible.verseIds,theme.bible,mySettings.bibleSets);
+        foreach(DisplayOutput *out, outputs)
+        {
+            if(!out->isConnected || !out->shows(BIBLE))
+                continue;
+            BibleSettings b = theme.bibleFor(out->themeDisplay());
+            out->applyContent(b);
+            jobs << RenderJob(getBibleVerse(sc.bible.verseIds,b,b.versions,verse1),b,out->display->screenSize());
+        }
+    }
+    else if(sc.stype == "song")
+    {
+        int count = qMin(PREPARE_SLIDES,sc.song.getSongTextList().count());
+        foreach(DisplayOutput *out, outputs)
+        {
+            if(!out->isConnected || !out->shows(SONG))
+                continue;
+            SongSettings s = theme.songFor(out->themeDisplay());
+            if(sc.song.usePrivateSettings)
+                sc.song.getSettings(s);
+            out->applyContent(s);
+            if(s.useBackground)
+                out->display->prescaleBackground(s.backgroundPix,0);
+            for(int j(0);j<count;++j)
+                jobs << RenderJob(sc.song.getStanza(j),s,out->display->screenSize());
+        }
+    }
+    else if(sc.stype == "announce")
+    {
+        int count = qMin(PREPARE_SLIDES,sc.announce.getAnnounceList().count());
+        for(int j(0);j<count;++j)
+        {
+            AnnounceSlide slide = sc.announce.getAnnounceSlide(j);
+            foreach(DisplayOutput *out, outputs)
+            {
+                if(!out->isConnected || !out->shows(ANNOUCEMENT))
+                    continue;
+                TextSettings a = theme.announceFor(out->themeDisplay());
+                out->applyContent(a);
+                jobs << RenderJob(slide,a,out->display->screenSize());
+            }
+        }
+    }
+    else if(sc.stype == "slideshow")
+    {
+        // The first slides are decoded once into the schedule item, from the database
+        // or from the schedule file, so that every time they are shown the same
+        // pixmap, and its scaled copy, is used.
+        QList<SlideShowItem> &slides = sc.slideshow.slides;
+        for(int j(0);j<qMin(PREPARE_SLIDES,slides.count());++j)
+        {
+            SlideShowItem &si = slides[j];
+            if(si.image.isNull())
+                si.image = si.getImage();
+            foreach(DisplayOutput *out, outputs)
+            {
+                if(out->isConnected && out->shows(PICTURE))
+                    out->display->prescaleSlide(si.image,mySettings.slideSets);
+            }
+        }
+    }
+    return jobs;
+}
+
+void SoftProjector::finishPrepare()
+{
+    int count = prepareRow;
+    prepareRow = -1;
+    if(prepareDialog->wasCanceled())
+        return;
+
+    // Rough memory held by prepared text images, scaled backgrounds and decoded slides.
+    // Backgrounds still being scaled are not counted yet.
+    int cost = renderCache.cost();
+    foreach(const Schedule &sc, schedule)
+    {
+        foreach(const SlideShowItem &si, sc.slideshow.slides)
+            cost += si.image.width()*si.image.height()*4/1024;
+    }
+    int dropped(0);
+    foreach(DisplayOutput *out, outputs)
+    {
+        if(!out->isConnected)
+            continue;
+        cost += out->display->backgroundCacheCost();
+        dropped += out->display->droppedPrescaled();
+    }
+
+    prepareDialog->setValue(prepareDialog->maximum());
+    if(dropped)
+        prepareDialog->setLabelText(tr("%1 schedule items are prepared, but %2 scaled backgrounds and slides "
+                                       "did not fit in memory and will be scaled when they are shown.\n"
+                                       "About %3 MB of memory is used by prepared slides.")
+                                    .arg(count).arg(dropped).arg(cost/1024));
+    else
+        prepareDialog->setLabelText(tr("Service is ready, %1 schedule items are prepared.\n"
+                                       "About %2 MB of memory is used by prepared slides.")
+                                    .arg(count).arg(cost/1024));
+    prepareDialog->setCancelButtonText(tr("Close"));
 }
@@ -20,6 +20,9 @@
 #include "../headers/song.hpp"
 #include <QDebug>
 #include "../headers/spfunctions.hpp"
+#include "../headers/assetstore.hpp"
+#include "../headers/dbservice.hpp"
+#include "../headers/startupprofiler.hpp"
 
 // for future use or chord import
 // to filter out ChorPro chords from within the song text
@@ -245,7 +248,7 @@ void Song::readData()
         endingFont.fromString(sq.value(17).toString());
     useBackground = sq.value(18).toBool();
     backgroundName = sq.value(19).toString();
-    background.loadFromData(sq.value(20).toByteArray());
+    AssetStore::instance()->loadPixmap(background,sq.value(20));
 }
 
 QStringList Song::getSongTextList()
@@ -675,7 +678,7 @@ void Song::saveUpdate()
     sq.addBindValue(endingFont.toString());
     sq.addBindValue(useBackground);
     sq.addBindValue(backgroundName);
-    sq.addBindValue(pixToByte(background));
+    sq.addBindValue(AssetStore::instance()->store(background));
     sq.addBindValue(songID);
     sq.exec();
 }
@@ -708,7 +711,7 @@ void Song::saveNew()
     sq.addBindValue(endingFont.toString());
     sq.addBindValue(useBackground);
     sq.addBindValue(backgroundName);
-    sq.addBindValue(pixToByte(background));
+    sq.addBindValue(AssetStore::instance()->store(background));
     sq.exec();
 }
 
@@ -719,20 +722,24 @@ Song SongDatabase::getSong(int id)
     return song;
 }
 
-QList<Song> SongDatabase::getSongs()
+struct SongRows
 {
-    QList<Song> songs;
+    QList<QSqlRecord> songbooks;
+    QList<QSqlRecord> songs;
+    QHash<qint64,QImage> images;
+};
 
-    QSqlQuery sq;
-    QStringList sb_ids, sb_names;
+static QFuture<SongRows> preloadedSongs;
+
+static SongRows readSongRows(QSqlDatabase db)
+{
+    SongRows rows;
+    QSqlQuery sq(db);
 
     // get songbook names and ids
     sq.exec("SELECT id, name FROM Songbooks");
     while (sq.next())
-    {
-        sb_ids << sq.value(0).toString();
-        sb_names << sq.value(1).toString();
-    }
+        rows.songbooks.append(sq.record());
     sq.clear();
 
     // get songs
@@ -742,39 +749,85 @@ QList<Song> SongDatabase::getSongs()
     sq.exec("SELECT id, songbook_id, number, title, category, tune, words, music, song_text, notes, "
             "use_private, alignment_v, alignment_h, color, font, info_color, info_font, ending_color, ending_font, "
             "use_background, background_name, background FROM Songs");
+    QList<QVariant> backgrounds;
     while(sq.next())
+    {
+        rows.songs.append(sq.record());
+        backgrounds.append(sq.value(21));
+    }
+    sq.clear();
+
+    rows.images = AssetStore::decodeAssets(db,backgrounds);
+    return rows;
+}
+
+static SongRows preloadSongRows()
+{
+    StartupPhase phase("songs (read)");
+    return readSongRows(DbService::instance()->database());
+}
+
+void SongDatabase::preload()
+{
+    // Reads and decodes all songs on a database thread, getSongs() picks them up
+    if(!preloadedSongs.isValid())
+        preloadedSongs = DbService::instance()->run(preloadSongRows);
+}
+
+QList<Song> SongDatabase::getSongs()
+{
+    QList<Song> songs;
+
+    SongRows rows;
+    if(preloadedSongs.isValid())
+    {
+        rows = preloadedSongs.result();
+        preloadedSongs = QFuture<SongRows>();
+    }
+    else
+        rows = readSongRows(QSqlDatabase::database());
+    AssetStore::instance()->addDecoded(rows.images);
+
+    QStringList sb_ids, sb_names;
+    foreach(const QSqlRecord &r, rows.songbooks)
+    {
+        sb_ids << r.value(0).toString();
+        sb_names << r.value(1).toString();
+    }
+
+    foreach(const QSqlRecord &r, rows.songs)
     {
         Song song;
-        song.songID = sq.value(0).toInt();
-        song.songbook_id = sq.value(1).toString();
-        song.number = sq.value(2).toInt();
-        song.title = sq.value(3).toString();
-        song.category = sq.value(4).toInt();
-        song.tune = sq.value(5).toString();
-        song.wordsBy = sq.value(6).toString();
-        song.musicBy = sq.value(7).toString();
-        song.songText = sq.value(8).toString();
-        song.notes = sq.value(9).toString();
-        song.usePrivateSettings = sq.value(10).toBool();
-        if(!sq.value(11).isNull())
-            song.alignmentV = sq.value(11).toInt();
-        if(!sq.value(12).isNull())
-            song.alignmentH = sq.value(12).toInt();
-        if(!sq.value(13).isNull())
-            song.color = QColor::fromRgb(sq.value(13).toUInt());
-        if(!sq.value(14).isNull())
-            song.font.fromString(sq.value(14).toString());
-        if(!sq.value(15).isNull())
-            song.infoColor = QColor::fromRgb(sq.value(15).toUInt());
-        if(!sq.value(16).isNull())
-            song.infoFont.fromString(sq.value(16).toString());
-        if(!sq.value(17).isNull())
-            song.endingColor = QColor::fromRgb(sq.value(17).toUInt());
-        if(!sq.value(18).isNull())
-            song.endingFont.fromString(sq.value(18).toString());
-        song.useBackground = sq.value(19).toBool();
-        song.backgroundName = sq.value(20).toString();
-        song.background.loadFromData(sq.value(21).toByteArray());
+        song.songID = r.value(0).toInt();
+        song.songbook_id = r.value(1).toString();
+        song.number = r.value(2).toInt();
+        song.title = r.value(3).toString();
+        song.category = r.value(4).toInt();
+        song.tune = r.value(5).toString();
+        song.wordsBy = r.value(6).toString();
+        song.musicBy = r.value(7).toString();
+        song.songText = r.value(8).toString();
+        song.notes = r.value(9).toString();
+        song.usePrivateSettings = r.value(10).toBool();
+        if(!r.value(11).isNull())
+            song.alignmentV = r.value(11).toInt();
+        if(!r.value(12).isNull())
+            song.alignmentH = r.value(12).toInt();
+        if(!r.value(13).isNull())
+            song.color = QColor::fromRgb(r.value(13).toUInt());
+        if(!r.value(14).isNull())
+            song.font.fromString(r.value(14).toString());
+        if(!r.value(15).isNull())
+            song.infoColor = QColor::fromRgb(r.value(15).toUInt());
+        if(!r.value(16).isNull())
+            song.infoFont.fromString(r.value(16).toString());
+        if(!r.value(17).isNull())
+            song.endingColor = QColor::fromRgb(r.value(17).toUInt());
+        if(!r.value(18).isNull())
+            song.endingFont.fromString(r.value(18).toString());
+        song.useBackground = r.value(19).toBool();
+        song.backgroundName = r.value(20).toString();
+        AssetStore::instance()->loadPixmap(song.background,r.value(21));
         song.songbook_name = sb_names.at(sb_ids.indexOf(song.songbook_id));
 
         songs.append(song);
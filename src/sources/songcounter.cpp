@@ -18,6 +18,7 @@
 ***************************************************************************/
 
 #include "../headers/songcounter.hpp"
+#include "../headers/dbservice.hpp"
 #include "ui_songcounter.h"
 
 SongCounter::SongCounter(QWidget *parent, QString loc) :
@@ -90,24 +91,10 @@ void SongCounter::loadCounts()
 
 void SongCounter::addSongCount(Song song)
 {
-    int id = song.songID;
-    int current_count(0);
-
-    // get current song count
-    QSqlQuery sq;
-    sq.exec("SELECT count FROM Songs WHERE id = '" + QString::number(id) + "' ");
-    sq.first();
-    current_count = sq.value(0).toInt();
-    sq.clear();
-
-    // add one count to song
-    ++current_count;
-
-    // set todays date
+    // Counted on a database thread, the song is going live and should not wait for it
     QDate d(QDate::currentDate());
-
-    sq.exec(QString("UPDATE Songs SET count = %1 , date = '%2' WHERE id = %3").arg(QString::number(current_count)).arg(d.toString("MM:dd:yyyy")).arg(QString::number(id)));
-    //    sq.exec("UPDATE Songs SET count = " + QString::number(current_count) + " WHERE id = " + QString::number(id));
+    DbService::instance()->exec("UPDATE Songs SET count = count + 1, date = ? WHERE id = ?",
+                                QVariantList() << d.toString("MM:dd:yyyy") << song.songID);
 }
 
 //***********************************
@@ -19,6 +19,7 @@
 
 #include "../headers/songsettingwidget.hpp"
 #include "ui_songsettingwidget.h"
+#include "../headers/assetstore.hpp"
 
 SongSettingWidget::SongSettingWidget(QWidget *parent) :
     QWidget(parent),
@@ -574,7 +575,7 @@ void SongSettingWidget::on_buttonSongBackground_clicked()
                                                     ".", tr("Images(%1)").arg(getSupportedImageFormats()));
     if(!filename.isNull())
     {
-        QPixmap p(filename);
+        QPixmap p = AssetStore::instance()->loadFile(filename);
         mySettings.backgroundPix = p;
         QFileInfo fi(filename);
         filename = fi.fileName();
@@ -589,7 +590,7 @@ void SongSettingWidget::on_buttonSongBackground2_clicked()
                                                     ".", tr("Images(%1)").arg(getSupportedImageFormats()));
     if(!filename.isNull())
     {
-        QPixmap p(filename);
+        QPixmap p = AssetStore::instance()->loadFile(filename);
         mySettings2.backgroundPix = p;
         QFileInfo fi(filename);
         filename = fi.fileName();
@@ -604,7 +605,7 @@ void SongSettingWidget::on_buttonSongBackground3_clicked()
                                                     ".", tr("Images(%1)").arg(getSupportedImageFormats()));
     if(!filename.isNull())
     {
-        QPixmap p(filename);
+        QPixmap p = AssetStore::instance()->loadFile(filename);
         mySettings3.backgroundPix = p;
         QFileInfo fi(filename);
         filename = fi.fileName();
@@ -619,7 +620,7 @@ void SongSettingWidget::on_buttonSongBackground4_clicked()
                                                     ".", tr("Images(%1)").arg(getSupportedImageFormats()));
     if(!filename.isNull())
     {
-        QPixmap p(filename);
+        QPixmap p = AssetStore::instance()->loadFile(filename);
         mySettings4.backgroundPix = p;
         QFileInfo fi(filename);
         filename = fi.fileName();
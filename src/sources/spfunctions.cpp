@@ -22,15 +22,50 @@
 //{
 //}
 
-QByteArray pixToByte(const QPixmap & pmap)
+QByteArray pixToByte(const QPixmap & pmap, ImageUse use)
 {
+    return imageToByte(pmap.toImage(),use);
+}
+
+QByteArray imageToByte(const QImage & image, ImageUse use)
+{
+    // Images with transparency are kept lossless, everything else is JPEG,
+    // which QImageReader can decode directly at a smaller size.
+    // Thumbnails trade a little quality and PNG compression for speed.
+    const char *format = "JPG";
+    int quality = (use == ImageThumbnail) ? 80 : 90;
+    if(image.hasAlphaChannel())
+    {
+        format = "PNG";
+        quality = (use == ImageThumbnail) ? 80 : -1;
+    }
+
     QByteArray bytes;
     QBuffer buffer(&bytes);
     buffer.open(QIODevice::WriteOnly);
-    pmap.save(&buffer, "JPG",90);
+    image.save(&buffer, format, quality);
     return buffer.data();
 }
 
+QImage byteToImage(const QByteArray & data, QSize bound)
+{
+    // Decodes at most at bound size, JPEG data is scaled while decoding
+    QBuffer buffer;
+    buffer.setData(data);
+    buffer.open(QIODevice::ReadOnly);
+    QImageReader reader(&buffer);
+    QSize size = reader.size();
+    if(bound.isValid() && size.isValid() && (size.width()>bound.width() || size.height()>bound.height()))
+        reader.setScaledSize(size.scaled(bound,Qt::KeepAspectRatio));
+    return reader.read();
+}
+
+bool isReusableImageFormat(const QByteArray & format)
+{
+    // Formats that can be stored as they are instead of encoding the image again
+    return format == "jpeg" || format == "jpg" || format == "png";
+}
+
 bool isAnnounceTitle(QString string)
 {
     // Check if the line is verse title line
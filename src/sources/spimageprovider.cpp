@@ -17,19 +17,71 @@
 //
 ***************************************************************************/
 
+#include <QMutexLocker>
 #include "../headers/spimageprovider.hpp"
 
-SpImageProvider::SpImageProvider() :
-    QQuickImageProvider(QQuickImageProvider::Pixmap)
+SpImageResponse::SpImageResponse(const QImage &image)
 {
+    m_image = image;
+    // Frame is already in memory, report it done once the loader gets back to its event loop
+    QMetaObject::invokeMethod(this,"finished",Qt::QueuedConnection);
 }
 
-QPixmap SpImageProvider::requestPixmap(const QString &id, QSize *size, const QSize &requestedSize)
+QQuickTextureFactory *SpImageResponse::textureFactory() const
 {
-    return m_pixmap;
+    return QQuickTextureFactory::textureFactoryForImage(m_image);
 }
 
-void SpImageProvider::setPixMap(QPixmap &p)
+SpImageProvider::SpImageProvider()
 {
-    m_pixmap = p;
+    m_nextId = 0;
+}
+
+QQuickImageResponse *SpImageProvider::requestImageResponse(const QString &id, const QSize &requestedSize)
+{
+    Q_UNUSED(requestedSize);
+    QMutexLocker locker(&m_mutex);
+    return new SpImageResponse(m_frames.value(id).image);
+}
+
+QString SpImageProvider::addImage(const QImage &image)
+{
+    QMutexLocker locker(&m_mutex);
+
+    // The same image (such as a shared text layer or a memoized color frame)
+    // is stored only once
+    QString id = m_idByCacheKey.value(image.cacheKey());
+    if(!id.isEmpty() && m_frames.contains(id))
+    {
+        ++m_frames[id].refCount;
+        return id;
+    }
+
+    id = QString("im%1").arg(++m_nextId);
+    Frame f;
+    f.image = image;
+    f.refCount = 1;
+    m_frames.insert(id,f);
+    m_idByCacheKey.insert(image.cacheKey(),id);
+    return id;
+}
+
+void SpImageProvider::retain(const QString &id)
+{
+    QMutexLocker locker(&m_mutex);
+    if(m_frames.contains(id))
+        ++m_frames[id].refCount;
+}
+
+void SpImageProvider::release(const QString &id)
+{
+    QMutexLocker locker(&m_mutex);
+    if(!m_frames.contains(id))
+        return;
+
+    if(--m_frames[id].refCount <= 0)
+    {
+        m_idByCacheKey.remove(m_frames.value(id).image.cacheKey());
+        m_frames.remove(id);
+    }
 }
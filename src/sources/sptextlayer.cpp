@@ -0,0 +1,96 @@
+/***************************************************************************
+//
+//    softProjector - an open source media projection software
+//    Copyright (C) 2017  Vladislav Kobzar
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation version 3 of the License.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+***************************************************************************/
+
+#include <QQuickWindow>
+#include <QSGRectangleNode>
+#if QT_VERSION >= QT_VERSION_CHECK(6, 7, 0)
+#include <QSGTextNode>
+#endif
+#include "../headers/sptextlayer.hpp"
+#include "../headers/textlayout.hpp"
+
+SpTextLayer::SpTextLayer(QQuickItem *parent) :
+    QQuickItem(parent)
+{
+    setFlag(ItemHasContents,true);
+}
+
+void SpTextLayer::setFrame(const TextFrame &frame)
+{
+    m_frame = frame;
+    update();
+}
+
+bool SpTextLayer::isSupported()
+{
+#if QT_VERSION >= QT_VERSION_CHECK(6, 7, 0)
+    return true;
+#else
+    return false;
+#endif
+}
+
+#if QT_VERSION >= QT_VERSION_CHECK(6, 7, 0)
+static void addRun(QSGTextNode *node, const TextRun &run, QPointF offset)
+{
+    // Laid out the same way as ImageGenerator lays out the text image
+    TextBlock block(run.text,run.font,run.rect.width(),run.flags,0,run.direction);
+    node->addTextLayout(block.origin(run.rect) + offset,block.layout());
+}
+
+static void addRuns(QQuickWindow *window, QSGNode *root, const QList<TextRun> &runs, QPointF offset)
+{
+    foreach(const TextRun &run, runs)
+    {
+        if(run.isFill)
+        {
+            QSGRectangleNode *rn = window->createRectangleNode();
+            rn->setRect(QRectF(run.rect).translated(offset));
+            rn->setColor(run.color);
+            root->appendChildNode(rn);
+        }
+        else if(!run.text.isEmpty())
+        {
+            QSGTextNode *tn = window->createTextNode();
+            tn->setColor(run.color);
+            addRun(tn,run,offset);
+            root->appendChildNode(tn);
+        }
+    }
+}
+#endif
+
+QSGNode *SpTextLayer::updatePaintNode(QSGNode *oldNode, UpdatePaintNodeData *data)
+{
+    Q_UNUSED(data);
+
+    // Nodes are only rebuilt when the frame changes, which is once per slide
+    delete oldNode;
+    if(!m_frame.isNative)
+        return NULL;
+
+#if QT_VERSION >= QT_VERSION_CHECK(6, 7, 0)
+    QSGNode *root = new QSGNode;
+    addRuns(window(),root,m_frame.shadowRuns,QPointF(m_frame.shadowOffset,m_frame.shadowOffset));
+    addRuns(window(),root,m_frame.runs,QPointF(0,0));
+    return root;
+#else
+    return NULL;
+#endif
+}
@@ -0,0 +1,91 @@
+/***************************************************************************
+//
+//    softProjector - an open source media projection software
+//    Copyright (C) 2017  Vladislav Kobzar
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation version 3 of the License.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+***************************************************************************/
+
+#include <QFile>
+#include <QTextStream>
+#include <QThread>
+#include <QCoreApplication>
+#include "../headers/startupprofiler.hpp"
+
+StartupProfiler *StartupProfiler::instance()
+{
+    static StartupProfiler profiler;
+    return &profiler;
+}
+
+StartupProfiler::StartupProfiler()
+{
+    m_clock.start();
+}
+
+void StartupProfiler::setLogFile(const QString &path)
+{
+    m_logFile = path;
+}
+
+qint64 StartupProfiler::elapsed()
+{
+    return m_clock.nsecsElapsed()/1000;
+}
+
+void StartupProfiler::record(const QString &phase, qint64 start, qint64 duration)
+{
+    Phase p;
+    p.name = phase;
+    p.start = start;
+    p.duration = duration;
+    if(QCoreApplication::instance() && QThread::currentThread() == QCoreApplication::instance()->thread())
+        p.thread = "gui";
+    else
+        p.thread = QString("worker %1").arg(quintptr(QThread::currentThreadId()),0,16);
+
+    QMutexLocker locker(&m_mutex);
+    m_phases.append(p);
+}
+
+void StartupProfiler::finish()
+{
+    // Called when the main window is first ready for input
+    qint64 total = elapsed();
+    if(m_logFile.isEmpty())
+        return;
+
+    QFile file(m_logFile);
+    if(!file.open(QIODevice::WriteOnly | QIODevice::Text))
+        return;
+    QTextStream ts(&file);
+    ts << "phase,thread,start_ms,duration_ms\n";
+    QMutexLocker locker(&m_mutex);
+    foreach(const Phase &p, m_phases)
+        ts << p.name << "," << p.thread << "," << QString::number(p.start/1000.0,'f',1) << ","
+           << QString::number(p.duration/1000.0,'f',1) << "\n";
+    ts << "ready,gui," << QString::number(total/1000.0,'f',1) << ",0\n";
+}
+
+StartupPhase::StartupPhase(const QString &phase)
+{
+    m_phase = phase;
+    m_start = StartupProfiler::instance()->elapsed();
+}
+
+StartupPhase::~StartupPhase()
+{
+    StartupProfiler *p = StartupProfiler::instance();
+    p->record(m_phase,m_start,p->elapsed()-m_start);
+}
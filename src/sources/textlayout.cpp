@@ -0,0 +1,229 @@
+/***************************************************************************
+//
+//    softProjector - an open source media projection software
+//    Copyright (C) 2017  Vladislav Kobzar
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation version 3 of the License.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+***************************************************************************/
+
+#include <QPainter>
+#include <QFontMetricsF>
+#include <QtMath>
+#include "../headers/textlayout.hpp"
+
+static Qt::LayoutDirection layoutDirection(int flags, Qt::LayoutDirection direction)
+{
+    if(flags & Qt::TextForceLeftToRight)
+        return Qt::LeftToRight;
+    else if(flags & Qt::TextForceRightToLeft)
+        return Qt::RightToLeft;
+    return direction;
+}
+
+static int visualFlags(int flags, Qt::LayoutDirection direction)
+{
+    // Same as QGuiApplicationPrivate::visualAlignment(), left and right
+    // are swapped for right to left layouts unless AlignAbsolute is set
+    if(!(flags & Qt::AlignHorizontal_Mask))
+        flags |= Qt::AlignLeft;
+    if(!(flags & Qt::AlignAbsolute) && (flags & (Qt::AlignLeft | Qt::AlignRight)))
+    {
+        if(direction == Qt::RightToLeft)
+            flags ^= (Qt::AlignLeft | Qt::AlignRight);
+        flags |= Qt::AlignAbsolute;
+    }
+    return flags;
+}
+
+static bool expandsTabs(int flags, Qt::LayoutDirection direction)
+{
+    bool rtl = direction == Qt::RightToLeft;
+    return (flags & Qt::TextExpandTabs) && (((flags & Qt::AlignLeft) && !rtl) || ((flags & Qt::AlignRight) && rtl));
+}
+
+static QString layoutText(const QString &text, int flags, Qt::LayoutDirection direction)
+{
+    // drawText draws carriage returns and tabs that are not expanded as spaces
+    direction = layoutDirection(flags,direction);
+    bool expandTabs = expandsTabs(visualFlags(flags,direction),direction);
+    QString s(text);
+    for(int i(0);i<s.size();++i)
+    {
+        QChar c = s.at(i);
+        if(c == QLatin1Char('\r') || ((flags & Qt::TextSingleLine) && c == QLatin1Char('\n')))
+            s[i] = QLatin1Char(' ');
+        else if(c == QLatin1Char('\n'))
+            s[i] = QChar::LineSeparator;
+        else if(c == QLatin1Char('\t') && !expandTabs)
+            s[i] = QLatin1Char(' ');
+    }
+    return s;
+}
+
+TextBlock::TextBlock(const QString &text, const QFont &font, int width, int flags, QPaintDevice *device, Qt::LayoutDirection direction) :
+    m_layout(layoutText(text,flags,direction),font,device)
+{
+    // Mirrors the layout part of QPainter's qt_format_text()
+    direction = layoutDirection(flags,direction);
+    m_flags = visualFlags(flags,direction);
+    QFontMetricsF fm = device ? QFontMetricsF(font,device) : QFontMetricsF(font);
+
+    QTextOption option;
+    option.setTextDirection(direction);
+    // Alignment is done here per line, the layout only justifies
+    option.setAlignment((m_flags & Qt::AlignJustify) ? Qt::AlignJustify : Qt::AlignLeft);
+    if(m_flags & Qt::TextWrapAnywhere)
+        option.setWrapMode(QTextOption::WrapAnywhere);
+    if(expandsTabs(m_flags,direction))
+        option.setTabStopDistance(qRound(fm.horizontalAdvance(QLatin1Char('x'))*8));
+    m_layout.setTextOption(option);
+    m_layout.setCacheEnabled(true);
+
+    m_width = 0;
+    if(m_layout.text().isEmpty())
+    {
+        // Measured as one empty line, nothing is drawn
+        m_height = fm.height();
+        return;
+    }
+
+    // Only TextWordWrap limits the line width, WrapAnywhere alone does not wrap
+    qreal lineWidth = (m_flags & Qt::TextWordWrap) ? qMax(0,width) : 0x01000000;
+    qreal leading = fm.leading();
+    m_height = -leading;
+    m_layout.beginLayout();
+    while(true)
+    {
+        QTextLine line = m_layout.createLine();
+        if(!line.isValid())
+            break;
+        line.setLineWidth(lineWidth);
+        m_height += leading;
+        m_height = qCeil(m_height); // lines start on whole pixels
+        line.setPosition(QPointF(0,m_height));
+        m_height += line.ascent() + line.descent();
+        m_width = qMax(m_width,line.naturalTextWidth());
+        m_lineBottoms.append(m_height);
+    }
+    m_layout.endLayout();
+
+    // Horizontal alignment is per line within the given width. Right aligned right to
+    // left lines also leave out the width of their trailing spaces, which the layout
+    // counts in the advance but drawText places at the start of the line.
+    bool rtl = direction == Qt::RightToLeft
+            || (direction == Qt::LayoutDirectionAuto && m_layout.text().isRightToLeft());
+    for(int i(0);i<m_layout.lineCount();++i)
+    {
+        QTextLine line = m_layout.lineAt(i);
+        qreal x = 0;
+        if(m_flags & Qt::AlignRight)
+        {
+            x = width - line.horizontalAdvance();
+            if(rtl)
+            {
+                int end = line.textStart() + line.textLength();
+                int start = end;
+                while(start > line.textStart() && m_layout.text().at(start-1).isSpace())
+                    --start;
+                if(start < end)
+                    x -= fm.horizontalAdvance(m_layout.text().mid(start,end-start));
+            }
+        }
+        else if(m_flags & Qt::AlignHCenter)
+            x = (width - line.horizontalAdvance())/2;
+        line.setPosition(QPointF(x,line.position().y()));
+    }
+}
+
+QPointF TextBlock::origin(const QRect &rect) const
+{
+    qreal y = rect.top();
+    if(m_flags & Qt::AlignBottom)
+        y += rect.height() - m_height;
+    else if(m_flags & Qt::AlignVCenter)
+        y += (rect.height() - m_height)/2;
+    return QPointF(rect.left(),y);
+}
+
+QRect TextBlock::boundingRect(const QRect &rect) const
+{
+    // Same as QPainter::boundingRect(rect, flags, text)
+    qreal x = rect.left();
+    if(m_flags & Qt::AlignRight)
+        x += rect.width() - m_width;
+    else if(m_flags & Qt::AlignHCenter)
+        x += (rect.width() - m_width)/2;
+    return QRectF(x,origin(rect).y(),m_width,m_height).toAlignedRect();
+}
+
+void TextBlock::draw(QPainter *painter, const QRect &rect) const
+{
+    // Like drawText, lines that start below the rectangle are not drawn and
+    // vertical alignment uses only the lines that are drawn
+    int count(0);
+    qreal height(0);
+    qreal width(0);
+    while(count < m_lineBottoms.count())
+    {
+        width = qMax(width,m_layout.lineAt(count).naturalTextWidth());
+        height = m_lineBottoms.at(count++);
+        if(height >= rect.height())
+            break;
+    }
+
+    qreal y = rect.top();
+    if(m_flags & Qt::AlignBottom)
+        y += rect.height() - height;
+    else if(m_flags & Qt::AlignVCenter)
+        y += (rect.height() - height)/2;
+
+    bool clip = !(m_flags & Qt::TextDontClip) && (height > rect.height() || width > rect.width());
+    if(clip)
+    {
+        painter->save();
+        painter->setClipRect(rect,Qt::IntersectClip);
+    }
+    for(int i(0);i<count;++i)
+        m_layout.lineAt(i).draw(painter,QPointF(rect.left(),y));
+    if(clip)
+        painter->restore();
+}
+
+QTextLayout *TextBlock::layout()
+{
+    return &m_layout;
+}
+
+TextLayoutCache::TextLayoutCache() :
+    m_blocks(256)
+{
+}
+
+QSharedPointer<TextBlock> TextLayoutCache::block(const QString &text, const QFont &font, int width, int flags,
+                                                 QPaintDevice *device, Qt::LayoutDirection direction)
+{
+    QString key = QString("%1|%2|%3|%4|%5|").arg(font.key()).arg(width).arg(flags)
+            .arg(device ? device->logicalDpiY() : 0).arg(int(direction)) + text;
+    QSharedPointer<TextBlock> *cached = m_blocks.object(key);
+    if(cached)
+        return *cached;
+    QSharedPointer<TextBlock> b(new TextBlock(text,font,width,flags,device,direction));
+    m_blocks.insert(key,new QSharedPointer<TextBlock>(b));
+    return b;
+}
+
+void TextLayoutCache::clear()
+{
+    m_blocks.clear();
+}
@@ -18,6 +18,8 @@
 ***************************************************************************/
 
 #include "../headers/theme.hpp"
+#include "../headers/assetstore.hpp"
+#include "../headers/dbservice.hpp"
 /*
 PassiveSettings::PassiveSettings()
 {
@@ -145,7 +147,7 @@ void Theme::savePassiveNew(int screen, TextSettings &settings)
     sq.addBindValue(screen);
     sq.addBindValue(settings.useBackground);
     sq.addBindValue(settings.backgroundName);
-    sq.addBindValue(pixToByte(settings.backgroundPix));
+    sq.addBindValue(storedBackground(PassivePart,screen,settings));
     sq.addBindValue(settings.useDisp1settings);
     sq.exec();
 }
@@ -165,7 +167,7 @@ void Theme::saveBibleNew(int screen, BibleSettings &settings)
     sq.addBindValue(settings.useBlurShadow);
     sq.addBindValue(settings.useBackground);
     sq.addBindValue(settings.backgroundName);
-    sq.addBindValue(pixToByte(settings.backgroundPix));
+    sq.addBindValue(storedBackground(BiblePart,screen,settings));
     sq.addBindValue(settings.textFont.toString());
     sq.addBindValue((unsigned int)(settings.textColor.rgb()));
     sq.addBindValue(settings.textAlignmentV);
@@ -211,7 +213,7 @@ void Theme::saveSongNew(int screen, SongSettings &settings)
     sq.addBindValue(settings.endingPosition);
     sq.addBindValue(settings.useBackground);
     sq.addBindValue(settings.backgroundName);
-    sq.addBindValue(pixToByte(settings.backgroundPix));
+    sq.addBindValue(storedBackground(SongPart,screen,settings));
     sq.addBindValue(settings.textFont);
     sq.addBindValue((unsigned int)(settings.textColor.rgb()));
     sq.addBindValue(settings.textAlignmentV);
@@ -238,7 +240,7 @@ void Theme::saveAnnounceNew(int screen, TextSettings &settings)
     sq.addBindValue(settings.useBlurShadow);
     sq.addBindValue(settings.useBackground);
     sq.addBindValue(settings.backgroundName);
-    sq.addBindValue(pixToByte(settings.backgroundPix));
+    sq.addBindValue(storedBackground(AnnouncePart,screen,settings));
     sq.addBindValue(settings.textFont.toString());
     sq.addBindValue(settings.textColor.rgb());
     sq.addBindValue(settings.textAlignmentV);
@@ -281,7 +283,7 @@ void Theme::savePassiveUpdate(int screen, TextSettings &settings)
                "WHERE theme_id = ? AND disp = ?");
     sq.addBindValue(settings.useBackground);
     sq.addBindValue(settings.backgroundName);
-    sq.addBindValue(pixToByte(settings.backgroundPix));
+    sq.addBindValue(storedBackground(PassivePart,screen,settings));
     sq.addBindValue(settings.useDisp1settings);
     sq.addBindValue(m_info.themeId);
     sq.addBindValue(screen);
@@ -303,7 +305,7 @@ void Theme::saveBibleUpdate(int screen, BibleSettings &settings)
     sq.addBindValue(settings.useBlurShadow);
     sq.addBindValue(settings.useBackground);
     sq.addBindValue(settings.backgroundName);
-    sq.addBindValue(pixToByte(settings.backgroundPix));
+    sq.addBindValue(storedBackground(BiblePart,screen,settings));
     sq.addBindValue(settings.textFont.toString());
     sq.addBindValue((unsigned int)(settings.textColor.rgb()));
     sq.addBindValue(settings.textAlignmentV);
@@ -350,7 +352,7 @@ void Theme::saveSongUpdate(int screen, SongSettings &settings)
     sq.addBindValue(settings.endingPosition);
     sq.addBindValue(settings.useBackground);
     sq.addBindValue(settings.backgroundName);
-    sq.addBindValue(pixToByte(settings.backgroundPix));
+    sq.addBindValue(storedBackground(SongPart,screen,settings));
     sq.addBindValue(settings.textFont);
     sq.addBindValue((unsigned int)(settings.textColor.rgb()));
     sq.addBindValue(settings.textAlignmentV);
@@ -378,7 +380,7 @@ void Theme::saveAnnounceUpdate(int screen, TextSettings &settings)
     sq.addBindValue(settings.useBlurShadow);
     sq.addBindValue(settings.useBackground);
     sq.addBindValue(settings.backgroundName);
-    sq.addBindValue(pixToByte(settings.backgroundPix));
+    sq.addBindValue(storedBackground(AnnouncePart,screen,settings));
     sq.addBindValue(settings.textFont.toString());
     sq.addBindValue(settings.textColor.rgb());
     sq.addBindValue(settings.textAlignmentV);
@@ -394,6 +396,7 @@ void Theme::loadTheme()
     QSqlQuery sq;
     bool ok, allok;
     allok = false;
+    m_backgrounds.clear();
 
     sq.exec(QString("SELECT name, comment FROM Themes WHERE id = %1").arg(m_info.themeId));
     ok = sq.first();
@@ -425,47 +428,177 @@ void Theme::loadTheme()
 
     if(allok)
     {
-        loadPassive(1,passive);
-        loadPassive(2,passive2);
-        loadPassive(3,passive3);
-        loadPassive(4,passive4);
-        loadBible(1,bible);
-        loadBible(2,bible2);
-        loadBible(3,bible3);
-        loadBible(4,bible4);
-        loadSong(1,song);
-        loadSong(2,song2);
-        loadAnnounce(1,announce);
-        loadAnnounce(2,announce2);
+        // Backgrounds are only decoded when a display screen needs them, see loadBackgrounds()
+        QHash<int,QSqlRecord> rows = themeRows("ThemePassive",m_info.themeId);
+        loadPassive(1,rows.value(1),passive);
+        loadPassive(2,rows.value(2),passive2);
+        loadPassive(3,rows.value(3),passive3);
+        loadPassive(4,rows.value(4),passive4);
+        rows = themeRows("ThemeBible",m_info.themeId);
+        loadBible(1,rows.value(1),bible);
+        loadBible(2,rows.value(2),bible2);
+        loadBible(3,rows.value(3),bible3);
+        loadBible(4,rows.value(4),bible4);
+        rows = themeRows("ThemeSong",m_info.themeId);
+        loadSong(1,rows.value(1),song);
+        loadSong(2,rows.value(2),song2);
+        rows = themeRows("ThemeAnnounce",m_info.themeId);
+        loadAnnounce(1,rows.value(1),announce);
+        loadAnnounce(2,rows.value(2),announce2);
     }
 }
 
-void Theme::loadPassive(int screen, TextSettings &settings)
+QHash<int,QSqlRecord> Theme::themeRows(const QString &table, int themeId)
 {
+    // Rows of one theme table by display screen
+    QHash<int,QSqlRecord> rows;
     QSqlQuery sq;
-    QSqlRecord sr;
-    sq.exec(QString("SELECT * FROM ThemePassive WHERE theme_id = %1 and disp = %2").arg(m_info.themeId).arg(screen));
-    sq.first();
-    sr = sq.record();
+    sq.prepare(QString("SELECT * FROM %1 WHERE theme_id = ?").arg(table));
+    sq.addBindValue(themeId);
+    sq.exec();
+    while(sq.next())
+        rows.insert(sq.record().value("disp").toInt(),sq.record());
+    return rows;
+}
+
+TextSettingsBase &Theme::part(int type, int screen)
+{
+    switch (type) {
+    case BiblePart:
+        return screen == 1 ? bible : screen == 2 ? bible2 : screen == 3 ? bible3 : bible4;
+    case SongPart:
+        return screen == 1 ? song : screen == 2 ? song2 : screen == 3 ? song3 : song4;
+    case AnnouncePart:
+        return screen == 1 ? announce : screen == 2 ? announce2 : screen == 3 ? announce3 : announce4;
+    default:
+        return screen == 1 ? passive : screen == 2 ? passive2 : screen == 3 ? passive3 : passive4;
+    }
+}
+
+// Settings a display shows, display settings that follow display 1 resolve to those of display 1
+TextSettings &Theme::passiveFor(int display)
+{
+    TextSettings &p = display == 2 ? passive2 : display == 3 ? passive3 : passive4;
+    return (display <= 1 || display > 4 || p.useDisp1settings) ? passive : p;
+}
+
+BibleSettings &Theme::bibleFor(int display)
+{
+    BibleSettings &b = display == 2 ? bible2 : display == 3 ? bible3 : bible4;
+    return (display <= 1 || display > 4 || b.useDisp1settings) ? bible : b;
+}
+
+SongSettings &Theme::songFor(int display)
+{
+    SongSettings &s = display == 2 ? song2 : display == 3 ? song3 : song4;
+    return (display <= 1 || display > 4 || s.useDisp1settings) ? song : s;
+}
+
+TextSettings &Theme::announceFor(int display)
+{
+    TextSettings &a = display == 2 ? announce2 : display == 3 ? announce3 : announce4;
+    return (display <= 1 || display > 4 || a.useDisp1settings) ? announce : a;
+}
+
+void Theme::deferBackground(int type, int screen, TextSettingsBase &settings, const QVariant &value)
+{
+    settings.backgroundPix = QPixmap();
+    if(!value.isNull())
+        m_backgrounds.insert(type*4+screen-1,value);
+}
+
+QVariant Theme::storedBackground(int type, int screen, TextSettingsBase &settings)
+{
+    // A background that was never decoded is saved as it was loaded
+    int key = type*4+screen-1;
+    if(m_backgrounds.contains(key) && settings.backgroundPix.isNull())
+        return m_backgrounds.value(key);
+    return AssetStore::instance()->store(settings.backgroundPix);
+}
+
+QList<int> Theme::usedParts(const QList<int> &screens)
+{
+    // Keys of the settings that the given display screens show, display screens
+    // that use display 1 settings use those of display 1
+    QList<int> keys;
+    foreach(int screen, screens)
+    {
+        for(int type(PassivePart);type<=AnnouncePart;++type)
+        {
+            int s = (screen > 1 && part(type,screen).useDisp1settings) ? 1 : screen;
+            if(part(type,s).useBackground && !keys.contains(type*4+s-1))
+                keys.append(type*4+s-1);
+        }
+    }
+    return keys;
+}
+
+QList<QVariant> Theme::pendingBackgrounds(const QList<int> &screens)
+{
+    QList<QVariant> values;
+    foreach(int key, usedParts(screens))
+    {
+        if(m_backgrounds.contains(key) && !AssetStore::instance()->isDecoded(m_backgrounds.value(key)))
+            values.append(m_backgrounds.value(key));
+    }
+    return values;
+}
+
+QHash<qint64,QImage> Theme::decodeBackgrounds(QList<QVariant> values)
+{
+    // Any thread
+    return AssetStore::decodeAssets(DbService::instance()->database(),values);
+}
+
+void Theme::loadBackgrounds()
+{
+    // All of them, whether they are used or not
+    loadParts(m_backgrounds.keys());
+}
+
+void Theme::loadBackgrounds(const QList<int> &screens)
+{
+    loadParts(usedParts(screens));
+}
+
+void Theme::loadParts(const QList<int> &keys)
+{
+    // Backgrounds that are not decoded yet are decoded in parallel on database threads
+    QList<QFuture<QHash<qint64,QImage> > > futures;
+    foreach(int key, keys)
+    {
+        QVariant value = m_backgrounds.value(key);
+        if(!value.isNull() && !AssetStore::instance()->isDecoded(value))
+            futures.append(DbService::instance()->run(decodeBackgrounds,QList<QVariant>() << value));
+    }
+    for(int i(0);i<futures.count();++i)
+        AssetStore::instance()->addDecoded(futures[i].result());
+
+    foreach(int key, keys)
+    {
+        if(!m_backgrounds.contains(key))
+            continue;
+        AssetStore::instance()->loadPixmap(part(key/4,key%4+1).backgroundPix,m_backgrounds.value(key));
+        m_backgrounds.remove(key);
+    }
+}
+
+void Theme::loadPassive(int screen, const QSqlRecord &sr, TextSettings &settings)
+{
     settings.useBackground = sr.field("use_background").value().toBool();
     settings.backgroundName = sr.field("background_name").value().toString();
-    settings.backgroundPix.loadFromData(sr.field("background").value().toByteArray());
+    deferBackground(PassivePart,screen,settings,sr.field("background").value());
     settings.useDisp1settings = sr.field("use_disp_1").value().toBool();
 }
 
-void Theme::loadBible(int screen, BibleSettings &settings)
+void Theme::loadBible(int screen, const QSqlRecord &sr, BibleSettings &settings)
 {
-    QSqlQuery sq;
-    QSqlRecord sr;
-    sq.exec(QString("SELECT * FROM ThemeBible WHERE theme_id = %1 and disp = %2").arg(m_info.themeId).arg(screen));
-    sq.first();
-    sr = sq.record();
     settings.useShadow = sr.field("use_shadow").value().toBool();
     settings.useFading = sr.field("use_fading").value().toBool();
     settings.useBlurShadow = sr.field("use_blur_shadow").value().toBool();
     settings.useBackground = sr.field("use_background").value().toBool();
     settings.backgroundName = sr.field("background_name").value().toString();
-    settings.backgroundPix.loadFromData(sr.field("background").value().toByteArray());
+    deferBackground(BiblePart,screen,settings,sr.field("background").value());
     settings.textFont.fromString(sr.field("text_font").value().toString());
     settings.textColor = QColor::fromRgb(sr.field("text_color").value().toUInt());
     settings.textAlignmentV = sr.field("text_align_v").value().toInt();
@@ -483,13 +616,8 @@ void Theme::loadBible(int screen, BibleSettings &settings)
     settings.bibleTextGenBKColor = QColor::fromRgb(sr.field("text_gen_background_color").value().toUInt());
 }
 
-void Theme::loadSong(int screen, SongSettings &settings)
+void Theme::loadSong(int screen, const QSqlRecord &sr, SongSettings &settings)
 {
-    QSqlQuery sq;
-    QSqlRecord sr;
-    sq.exec(QString("SELECT * FROM ThemeSong WHERE theme_id = %1 and disp = %2").arg(m_info.themeId).arg(screen));
-    sq.first();
-    sr = sq.record();
     settings.useShadow = sr.field("use_shadow").value().toBool();
     settings.useFading = sr.field("use_fading").value().toBool();
     settings.useBlurShadow = sr.field("use_blur_shadow").value().toBool();
@@ -506,7 +634,7 @@ void Theme::loadSong(int screen, SongSettings &settings)
     settings.endingPosition = sr.field("ending_position").value().toInt();
     settings.useBackground = sr.field("use_background").value().toBool();
     settings.backgroundName = sr.field("background_name").value().toString();
-    settings.backgroundPix.loadFromData(sr.field("background").value().toByteArray());
+    deferBackground(SongPart,screen,settings,sr.field("background").value());
     settings.textFont.fromString(sr.field("text_font").value().toString());
     settings.textColor = QColor::fromRgb(sr.field("text_color").value().toUInt());
     settings.textAlignmentV = sr.field("text_align_v").value().toInt();
@@ -519,19 +647,14 @@ void Theme::loadSong(int screen, SongSettings &settings)
     settings.songTextGenBKColor = QColor::fromRgb(sr.field("text_gen_background_color").value().toUInt());
 }
 
-void Theme::loadAnnounce(int screen, TextSettings &settings)
+void Theme::loadAnnounce(int screen, const QSqlRecord &sr, TextSettings &settings)
 {
-    QSqlQuery sq;
-    QSqlRecord sr;
-    sq.exec(QString("SELECT * FROM ThemeAnnounce WHERE theme_id = %1 and disp = %2").arg(m_info.themeId).arg(screen));
-    sq.first();
-    sr = sq.record();
     settings.useShadow = sr.field("use_shadow").value().toBool();
     settings.useFading = sr.field("use_fading").value().toBool();
     settings.useBlurShadow = sr.field("use_blur_shadow").value().toBool();
     settings.useBackground = sr.field("use_background").value().toBool();
     settings.backgroundName = sr.field("background_name").value().toString();
-    settings.backgroundPix.loadFromData(sr.field("background").value().toByteArray());
+    deferBackground(AnnouncePart,screen,settings,sr.field("background").value());
     settings.textFont.fromString(sr.field("text_font").value().toString());
     settings.textColor = QColor::fromRgb(sr.field("text_color").value().toUInt());
     settings.textAlignmentV = sr.field("text_align_v").value().toInt();